@@ -35,5 +35,6 @@
 //-----------------------------------------------------------------------------
 // FILESYSTEM
 //-----------------------------------------------------------------------------
-// Set the max. size of the output image
-# define HOSTSTORAGE_SIZE ((size_t)(128 * 1024))
+// Set the max. size of the output image. Images are 128 KiB unless another
+// size or the automatic sizing is requested with --size
+# define HOSTSTORAGE_SIZE ((size_t)(256 * 1024 * 1024))
@@ -9,25 +9,132 @@
  */
 
 /* Includes ------------------------------------------------------------------*/
+#include <errno.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
+#include <getopt.h>
 #include <libgen.h>
+#include <dirent.h>
 #include <unistd.h>
+#include <sys/stat.h>
 
 #include "lib_debug/Debug.h"
-#include "ConfigTool_XmlParser.h"
+#include "ConfigTool_Provisioning.h"
 #include "ConfigTool_Backend.h"
+#include "ConfigTool_BatchTable.h"
+#include "ConfigTool_ConfigDumper.h"
+#include "ConfigTool_ConfigReader.h"
 #include "ConfigTool_ConfigService.h"
+#include "ConfigTool_ConfigVerifier.h"
+#include "ConfigTool_Server.h"
+#include "ConfigTool_Stats.h"
 #include "ConfigTool_Util.h"
+#include "ConfigTool_Worker.h"
 
 
 /* Defines -------------------------------------------------------------------*/
 #define USAGE_STRING                             \
     printf("Usage: cpt -i [<path-to-xml_file>] " \
            "-o [<output_nvm_file_name>] "        \
-           "-t [<filesystem_type>]\n")
+           "-t [<filesystem_type>[,...]] "       \
+           "[--size <image_size>] "              \
+           "[--outdir <output_dir>] "            \
+           "[--template-cache <cache_dir>] "     \
+           "[--batch <table_file>] "             \
+           "[-j <jobs>] "                        \
+           "[--index] [--cluster-domains] "      \
+           "[--stats[=json]] "                   \
+           "[--stats-file <file>] [-s] [-m]\n"   \
+           "       cpt --serve <socket_path> "   \
+           "[--size <image_size>] "              \
+           "[--template-cache <cache_dir>] "     \
+           "[-j <jobs>] [--index] "              \
+           "[--cluster-domains] "                \
+           "[--stats[=json]] "                   \
+           "[--stats-file <file>] [-s] [-m]\n"   \
+           "       cpt --patch <image_or_dir> "  \
+           "[-t <filesystem_type>] "             \
+           "--set <domain>.<param>=<value> "     \
+           "[--set ...] "                        \
+           "[-i <path-to-xml_file>] "            \
+           "[--size <image_size>] [--index] "    \
+           "[--cluster-domains] "                \
+           "[--stats[=json]] "                   \
+           "[--stats-file <file>]\n"             \
+           "       cpt --dump <image_or_dir> "   \
+           "[-t <filesystem_type>] "             \
+           "-o <output_xml_file>\n"             \
+           "       cpt --verify <image_or_dir> " \
+           "[-t <filesystem_type>] "             \
+           "-i <path-to-xml_file> [-s]\n")
+
+// Long options without a short option use values beyond the character range
+#define OPT_SIZE            256
+#define OPT_OUTDIR          257
+#define OPT_TEMPLATE_CACHE  258
+#define OPT_BATCH           259
+#define OPT_SERVE           260
+#define OPT_PATCH           261
+#define OPT_SET             262
+#define OPT_DUMP            263
+#define OPT_VERIFY          264
+#define OPT_INDEX           265
+#define OPT_CLUSTER_DOMAINS 266
+#define OPT_STATS           267
+#define OPT_STATS_FILE      268
+
+// One image per supported filesystem type
+#define MAX_OUTPUTS 3
+
+// Files in the private directory a patched output is rebuilt in
+#define REBUILD_XML_FILE    "rebuild.xml"
+#define REBUILD_BLOB_PREFIX "patch-"
+
+
+/* Private types/enums -------------------------------------------------------*/
+// An output built from the parsed configuration
+typedef struct
+{
+    ConfigTool_BackendConfig_t cfgBackend; /**< backend to write the output with */
+    const char* typeName;                  /**< filesystem type replacing %t */
+    char* outPath;                         /**< image file or output directory */
+} ConfigTool_Target_t;
+
+/* All outputs built from one parsed configuration. In batch mode, every row
+ * of the table builds all outputs, with the outputs named by the row.
+ */
+typedef struct
+{
+    ConfigTool_Provisioning_t* provisioning; /**< parsed configuration */
+    const ConfigTool_Target_t* outputs;      /**< outputs to build */
+    size_t outputCount;                      /**< number of outputs */
+    const ConfigTool_BatchTable_t* table;    /**< overrides, NULL if no batch */
+    const uint32_t* paramIndices;            /**< parameter of each column */
+} ConfigTool_TargetJobs_t;
+
+
+/* Private variables ---------------------------------------------------------*/
+static const struct option longOptions[] =
+{
+    { "size",            required_argument, NULL, OPT_SIZE },
+    { "outdir",          required_argument, NULL, OPT_OUTDIR },
+    { "template-cache",  required_argument, NULL, OPT_TEMPLATE_CACHE },
+    { "batch",           required_argument, NULL, OPT_BATCH },
+    { "serve",           required_argument, NULL, OPT_SERVE },
+    { "patch",           required_argument, NULL, OPT_PATCH },
+    { "set",             required_argument, NULL, OPT_SET },
+    { "dump",            required_argument, NULL, OPT_DUMP },
+    { "verify",          required_argument, NULL, OPT_VERIFY },
+    { "index",           no_argument,       NULL, OPT_INDEX },
+    { "cluster-domains", no_argument,       NULL, OPT_CLUSTER_DOMAINS },
+    { "stats",           optional_argument, NULL, OPT_STATS },
+    { "stats-file",      required_argument, NULL, OPT_STATS_FILE },
+    { "jobs",            required_argument, NULL, 'j' },
+    { NULL,              0,                 NULL, 0 }
+};
 
 
 /* Private functions ---------------------------------------------------------*/
@@ -62,98 +169,830 @@ OS_Error_t ConfigTool_AssignFileSystemType(
 }
 
 
+// Parses a size in bytes with an optional K, M or G suffix, or "auto"
 static
-OS_Error_t ConfigTool_CreateProvisioning(
-    xmlDoc* doc,
-    const char* filePath,
-    const char* outFileName,
+OS_Error_t ConfigTool_ParseImageSize(
+    const char* arg,
+    size_t* imageSize)
+{
+    if (strcmp(arg, "auto") == 0)
+    {
+        *imageSize = CONFIG_TOOL_BACKEND_IMAGE_SIZE_AUTO;
+        return OS_SUCCESS;
+    }
+
+    char* end;
+    errno = 0;
+    unsigned long long size = strtoull(arg, &end, 0);
+    if ((errno != 0) || (end == arg) || (arg[0] == '-'))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    unsigned shift = 0;
+    switch (*end)
+    {
+    case 'K':
+    case 'k':
+        shift = 10;
+        end++;
+        break;
+    case 'M':
+    case 'm':
+        shift = 20;
+        end++;
+        break;
+    case 'G':
+    case 'g':
+        shift = 30;
+        end++;
+        break;
+    }
+
+    if ((*end != '\0') || (size == 0) || (size > (SIZE_MAX >> shift)))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    *imageSize = (size_t)size << shift;
+
+    return OS_SUCCESS;
+}
+
+
+// Reports the STRING.BIN records saved by sharing equal string values
+static
+void ConfigTool_PrintStringPoolSavings(
+    const ConfigTool_StringPool_t* stringPool)
+{
+    uint32_t sharedValues = stringPool->references - stringPool->count;
+
+    if (sharedValues > 0)
+    {
+        printf("String pool: %u of %u string values stored, %zu bytes saved\n",
+               stringPool->count, stringPool->references,
+               (size_t)sharedValues * OS_CONFIG_LIB_PARAMETER_MAX_STRING_SIZE);
+    }
+}
+
+
+// Returns the output name with every %t replaced by the type name, to be freed
+static
+char* ConfigTool_ExpandOutputName(
+    const char* pattern,
+    const char* typeName)
+{
+    size_t len = strlen(pattern) + 1;
+    for (const char* p = strstr(pattern, "%t"); p != NULL; p = strstr(p + 2, "%t"))
+    {
+        len += strlen(typeName);
+    }
+
+    char* name = malloc(len);
+    if (name == NULL)
+    {
+        Debug_LOG_ERROR("Failed to allocate memory");
+        return NULL;
+    }
+
+    char* out = name;
+    while (*pattern != '\0')
+    {
+        if ((pattern[0] == '%') && (pattern[1] == 't'))
+        {
+            out = stpcpy(out, typeName);
+            pattern += 2;
+        }
+        else
+        {
+            *out++ = *pattern++;
+        }
+    }
+    *out = '\0';
+
+    return name;
+}
+
+
+static
+OS_Error_t ConfigTool_GetFileSystemTypeName(
     OS_FileSystem_Type_t fsType,
-    bool createImageFile)
+    const char** typeName)
 {
-    OS_FileSystem_Handle_t hFs;
-    OS_ConfigServiceLib_t configLib;
-    ConfigTool_ConfigServiceCounter_t configCounter = {0};
+    switch (fsType)
+    {
+    case OS_FileSystem_Type_FATFS:
+        *typeName = "FAT";
+        return OS_SUCCESS;
+    case OS_FileSystem_Type_SPIFFS:
+        *typeName = "SPIFFS";
+        return OS_SUCCESS;
+    case OS_FileSystem_Type_LITTLEFS:
+        *typeName = "LITTLEFS";
+        return OS_SUCCESS;
+    default:
+        return OS_ERROR_NOT_SUPPORTED;
+    }
+}
 
-    // Get the root element node
-    xmlNode* rootElement = xmlDocGetRootElement(doc);
-    if (rootElement == NULL)
+
+// Sets up one output per filesystem type of the comma separated list
+static
+OS_Error_t ConfigTool_AssignOutputs(
+    const char* fileSystemTypes,
+    const char* outFileName,
+    const ConfigTool_BackendConfig_t* cfgBackend,
+    ConfigTool_Target_t* outputs,
+    size_t* outputCount)
+{
+    char* types = strdup(fileSystemTypes);
+    if (types == NULL)
     {
-        Debug_LOG_ERROR("Failed to get the root element node of the XML file");
-        return OS_ERROR_GENERIC;
+        Debug_LOG_ERROR("Failed to allocate memory");
+        return OS_ERROR_INSUFFICIENT_SPACE;
     }
 
-    // Get the directory path of the XML file
-    const char* dirPath = dirname((char*)filePath);
+    OS_Error_t err = OS_SUCCESS;
+    char* savePtr;
+    *outputCount = 0;
+
+    for (char* type = strtok_r(types, ",", &savePtr); type != NULL;
+         type = strtok_r(NULL, ",", &savePtr))
+    {
+        if (*outputCount == MAX_OUTPUTS)
+        {
+            printf("Too many FileSystem types requested!\n");
+            err = OS_ERROR_INVALID_PARAMETER;
+            break;
+        }
+
+        ConfigTool_Target_t* output = &outputs[*outputCount];
+        output->cfgBackend = *cfgBackend;
+
+        err = ConfigTool_AssignFileSystemType(type, &output->cfgBackend.fsType);
+        if (err != OS_SUCCESS)
+        {
+            break;
+        }
+
+        // The type names are checked verbatim, the literals outlive the list
+        err = ConfigTool_GetFileSystemTypeName(output->cfgBackend.fsType,
+                                               &output->typeName);
+        if (err != OS_SUCCESS)
+        {
+            break;
+        }
+
+        for (size_t i = 0; i < *outputCount; i++)
+        {
+            if (outputs[i].cfgBackend.fsType == output->cfgBackend.fsType)
+            {
+                printf("FileSystem type %s requested twice!\n", type);
+                err = OS_ERROR_INVALID_PARAMETER;
+                break;
+            }
+        }
+        if (err != OS_SUCCESS)
+        {
+            break;
+        }
+
+        if ((output->outPath = ConfigTool_ExpandOutputName(outFileName, type))
+            == NULL)
+        {
+            err = OS_ERROR_INSUFFICIENT_SPACE;
+            break;
+        }
+        (*outputCount)++;
+    }
 
-    /* Count the number of domains and parameter of their respective types to
-     * initialize the config service backend with
-     */
-    ConfigTool_XmlParserGetElementCount(rootElement, &configCounter, dirPath);
+    free(types);
 
-    Debug_LOG_DEBUG("Domain Count:%d, String Count:%d, Param Count:%d, Blob Count:%d",
-                    configCounter.domain_count, configCounter.string_count,
-                    configCounter.param_count, configCounter.blob_count);
+    if ((err == OS_SUCCESS) && (*outputCount > 1)
+        && (strstr(outFileName, "%t") == NULL))
+    {
+        printf("The output filename needs a %%t for several FileSystem types!\n");
+        err = OS_ERROR_INVALID_PARAMETER;
+    }
 
-    // Initialize file system
-    Debug_LOG_DEBUG("Initializing FileSystem");
-    OS_Error_t err = ConfigTool_BackendInit(&hFs, fsType);
     if (err != OS_SUCCESS)
     {
-        Debug_LOG_ERROR("ConfigTool_Backend_init() failed with %d", err);
+        for (size_t i = 0; i < *outputCount; i++)
+        {
+            free(outputs[i].outPath);
+        }
+        *outputCount = 0;
+    }
+
+    return err;
+}
+
+
+/* Builds one output of a row of the batch table. The overrides are applied to
+ * the model of the worker, which is a private copy of the parsed model unless
+ * the whole batch is a single job.
+ */
+static
+OS_Error_t ConfigTool_WriteBatchOutput(
+    ConfigTool_TargetJobs_t* job,
+    size_t row,
+    const ConfigTool_Target_t* output)
+{
+    ConfigTool_ConfigModel_t* model = &job->provisioning->model;
+    OS_Error_t err;
+
+    for (size_t column = 1; column < job->table->columns; column++)
+    {
+        const char* value = ConfigTool_BatchTableGetCell(job->table, row, column);
+
+        // Empty cells keep the value of the base configuration
+        if (value[0] == '\0')
+        {
+            continue;
+        }
+
+        err = ConfigTool_ConfigModelSetValue(model, job->paramIndices[column],
+                                             value);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("Setting %s of row %zu failed with %d",
+                            ConfigTool_BatchTableGetHeader(job->table, column),
+                            row + 1, err);
+            return err;
+        }
+    }
+
+    err = ConfigTool_ConfigModelRecount(model);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_ConfigModelRecount() failed with %d", err);
         return err;
     }
 
-    // Initialize the configuration service library
-    Debug_LOG_DEBUG("Initializing ConfigService");
-    err = ConfigTool_ConfigServiceInit(&configLib, hFs, &configCounter);
+    char* outPath = ConfigTool_ExpandOutputName(
+                        ConfigTool_BatchTableGetCell(job->table, row, 0),
+                        (output->typeName != NULL) ? output->typeName : "");
+    if (outPath == NULL)
+    {
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+
+    // Without an image, every device gets a directory of its own
+    if ((output->cfgBackend.fsType == OS_FileSystem_Type_NONE)
+        && (mkdir(outPath, 0755) != 0) && (errno != EEXIST))
+    {
+        Debug_LOG_ERROR("mkdir() failed for %s with errno %d", outPath, errno);
+        free(outPath);
+        return OS_ERROR_GENERIC;
+    }
+
+    err = ConfigTool_ProvisioningPublish(
+              job->provisioning,
+              &output->cfgBackend,
+              outPath);
     if (err != OS_SUCCESS)
     {
-        Debug_LOG_ERROR("ConfigTool_ConfigServiceInit() failed with %d", err);
+        Debug_LOG_ERROR("ConfigTool_ProvisioningPublish() failed for %s with %d",
+                        outPath, err);
+    }
+
+    free(outPath);
+
+    return err;
+}
+
+
+// Resolves the "<domain>.<parameter>" header of every override column
+static
+OS_Error_t ConfigTool_ResolveBatchColumns(
+    const ConfigTool_ConfigModel_t* model,
+    const ConfigTool_BatchTable_t* table,
+    size_t outputCount,
+    uint32_t* paramIndices)
+{
+    for (size_t row = 0; row < table->rows; row++)
+    {
+        const char* outPath = ConfigTool_BatchTableGetCell(table, row, 0);
+        if (outPath[0] == '\0')
+        {
+            printf("Row %zu of the batch table has no output!\n", row + 1);
+            return OS_ERROR_INVALID_PARAMETER;
+        }
+        if ((outputCount > 1) && (strstr(outPath, "%t") == NULL))
+        {
+            printf("The output %s needs a %%t for several FileSystem types!\n",
+                   outPath);
+            return OS_ERROR_INVALID_PARAMETER;
+        }
+    }
+
+    for (size_t column = 1; column < table->columns; column++)
+    {
+        const char* header = ConfigTool_BatchTableGetHeader(table, column);
+
+        OS_Error_t err = ConfigTool_ConfigModelFindQualifiedParam(
+                             model,
+                             header,
+                             &paramIndices[column]);
+        if (err == OS_ERROR_INSUFFICIENT_SPACE)
+        {
+            return err;
+        }
+        if (err != OS_SUCCESS)
+        {
+            printf("Batch table column %s is no <domain>.<parameter> of the "
+                   "configuration!\n", header);
+            return OS_ERROR_INVALID_PARAMETER;
+        }
+    }
+
+    return OS_SUCCESS;
+}
+
+
+// Builds one output, run by a worker of its own if there are several
+static
+OS_Error_t ConfigTool_WriteOutput(
+    size_t index,
+    void* ctx)
+{
+    ConfigTool_TargetJobs_t* job = ctx;
+    const ConfigTool_Target_t* output = &job->outputs[index % job->outputCount];
+
+    if (job->table == NULL)
+    {
+        OS_Error_t err = ConfigTool_ProvisioningPublish(
+                             job->provisioning,
+                             &output->cfgBackend,
+                             output->outPath);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("ConfigTool_ProvisioningPublish() failed for %s "
+                            "with %d", output->outPath, err);
+        }
         return err;
     }
 
-    /* Since we will reuse the configCounter to keep track of the elements that
-     * are being written, we reset it to zero after initializing the
-     * configuration lib
-     */
-    memset(&configCounter, 0, sizeof(ConfigTool_ConfigServiceCounter_t));
-    ConfigTool_XmlParserRun(&configLib, rootElement, &configCounter, dirPath);
+    return ConfigTool_WriteBatchOutput(job, index / job->outputCount, output);
+}
+
 
-    // Deinitialize the Filesystem backend
-    err = ConfigTool_BackendDeInit(hFs);
+static
+OS_Error_t ConfigTool_CreateProvisioning(
+    const char* filePath,
+    ConfigTool_Target_t* outputs,
+    size_t outputCount,
+    const ConfigTool_BatchTable_t* table,
+    size_t maxWorkers,
+    bool useStreamParser,
+    bool clusterDomains)
+{
+    ConfigTool_Provisioning_t provisioning;
+    uint32_t* paramIndices = NULL;
+
+    // The configuration is parsed once for all outputs
+    OS_Error_t err = ConfigTool_ProvisioningLoad(
+                         &provisioning,
+                         filePath,
+                         useStreamParser,
+                         clusterDomains);
     if (err != OS_SUCCESS)
     {
-        Debug_LOG_ERROR("ConfigTool_BackendDeInit() failed with %d", err);
+        Debug_LOG_ERROR("ConfigTool_ProvisioningLoad() failed with %d", err);
         return err;
     }
 
-    // If an image should be created, the output might need renaming
-    if (createImageFile)
+    ConfigTool_TargetJobs_t job =
+    {
+        .provisioning = &provisioning,
+        .outputs = outputs,
+        .outputCount = outputCount,
+        .table = table,
+    };
+    size_t jobCount = outputCount;
+
+    // The columns are resolved once, the workers only apply the values
+    if (table != NULL)
     {
-        // Rename the generic output filename to the requested filename
-        if (rename(HOSTSTORAGE_FILE_NAME, outFileName) != 0)
+        if ((paramIndices = calloc(table->columns, sizeof(uint32_t))) == NULL)
+        {
+            Debug_LOG_ERROR("Failed to allocate memory");
+            err = OS_ERROR_INSUFFICIENT_SPACE;
+            goto exit;
+        }
+
+        err = ConfigTool_ResolveBatchColumns(&provisioning.model, table,
+                                             outputCount, paramIndices);
+        if (err != OS_SUCCESS)
         {
-            Debug_LOG_ERROR("Renaming the output file failed.");
-            return OS_ERROR_GENERIC;
+            goto exit;
         }
 
-        Debug_LOG_DEBUG("Provisioned configuration image successfully created as %s",
-                        outFileName);
+        job.paramIndices = paramIndices;
+        jobCount *= table->rows;
+    }
+    else if (maxWorkers == 0)
+    {
+        maxWorkers = outputCount;
     }
 
-    return OS_SUCCESS;
+    if (jobCount == 0)
+    {
+        printf("The batch table has no rows!\n");
+        err = OS_ERROR_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    err = ConfigTool_WorkerRun(jobCount, maxWorkers, ConfigTool_WriteOutput,
+                               &job);
+    if ((err == OS_SUCCESS) && (table == NULL))
+    {
+        ConfigTool_PrintStringPoolSavings(&provisioning.model.stringPool);
+    }
+    else if (err == OS_SUCCESS)
+    {
+        printf("Batch: %zu outputs of %zu devices written\n", jobCount,
+               table->rows);
+    }
+
+exit:
+    free(paramIndices);
+    ConfigTool_ProvisioningFree(&provisioning);
+
+    return err;
+}
+
+
+// Returns the absolute directory blob paths are relative to, to be freed
+static
+char* ConfigTool_GetBlobDir(
+    const char* filePath)
+{
+    if (filePath == NULL)
+    {
+        return realpath(".", NULL);
+    }
+
+    char* filePathCopy = strdup(filePath);
+    if (filePathCopy == NULL)
+    {
+        return NULL;
+    }
+
+    char* blobDir = realpath(dirname(filePathCopy), NULL);
+    free(filePathCopy);
+
+    return blobDir;
+}
+
+
+// Removes the files of a rebuild directory and the directory itself
+static
+void
+ConfigTool_RemoveRebuildDir(
+    const char* dirPath)
+{
+    DIR* dir = opendir(dirPath);
+    if (dir != NULL)
+    {
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != NULL)
+        {
+            if ((strcmp(entry->d_name, ".") != 0)
+                && (strcmp(entry->d_name, "..") != 0))
+            {
+                unlinkat(dirfd(dir), entry->d_name, 0);
+            }
+        }
+        closedir(dir);
+    }
+
+    rmdir(dirPath);
+}
+
+/* Applies the patched values to the model of a rebuild. The model refers to
+ * its blobs relative to the rebuild directory, so new blob files are linked
+ * into it.
+ */
+static
+OS_Error_t
+ConfigTool_SetRebuildValues(
+    ConfigTool_ConfigModel_t* model,
+    const char* dirPath,
+    const char* blobDir,
+    const ConfigTool_ConfigPatcherValue_t* values,
+    size_t valueCount)
+{
+    for (size_t i = 0; i < valueCount; i++)
+    {
+        uint32_t paramIndex;
+        OS_Error_t err = ConfigTool_ConfigModelFindQualifiedParam(
+                             model,
+                             values[i].name,
+                             &paramIndex);
+        if (err != OS_SUCCESS)
+        {
+            printf("Setting %s failed!\n", values[i].name);
+            return err;
+        }
+
+        const char* value = values[i].value;
+        char linkName[32];
+
+        if (model->params[paramIndex].type == BLOB)
+        {
+            char target[PATH_MAX];
+            char linkPath[PATH_MAX];
+
+            snprintf(linkName, sizeof(linkName), "/" REBUILD_BLOB_PREFIX "%zu",
+                     i);
+            if ((snprintf(target, sizeof(target), "%s%s", blobDir, value)
+                 >= (int)sizeof(target))
+                || (snprintf(linkPath, sizeof(linkPath), "%s%s", dirPath,
+                             linkName) >= (int)sizeof(linkPath)))
+            {
+                Debug_LOG_ERROR("Path of blob %s too long", value);
+                return OS_ERROR_INVALID_PARAMETER;
+            }
+
+            if (symlink(target, linkPath) != 0)
+            {
+                Debug_LOG_ERROR("symlink() failed for %s, errno %d", linkPath,
+                                errno);
+                return OS_ERROR_GENERIC;
+            }
+            value = linkName;
+        }
+
+        err = ConfigTool_ConfigModelSetValue(model, paramIndex, value);
+        if (err != OS_SUCCESS)
+        {
+            printf("Setting %s failed!\n", values[i].name);
+            return err;
+        }
+    }
+
+    return ConfigTool_ConfigModelRecount(model);
+}
+
+/* Builds the output again from its own records with the patched values
+ * applied. The records are decoded into a private directory first, so values
+ * patched in place earlier, the record layout and the index of the output are
+ * kept.
+ */
+static
+OS_Error_t
+ConfigTool_RebuildPatchedOutput(
+    const char* outPath,
+    const ConfigTool_BackendConfig_t* cfgBackend,
+    const char* blobDir,
+    const ConfigTool_ConfigPatcherValue_t* values,
+    size_t valueCount,
+    bool useStreamParser,
+    bool clusterDomains)
+{
+    char dirPath[] = P_tmpdir "/cpt-rebuild.XXXXXX";
+    if (mkdtemp(dirPath) == NULL)
+    {
+        Debug_LOG_ERROR("mkdtemp() failed, errno %d", errno);
+        return OS_ERROR_GENERIC;
+    }
+
+    char xmlPath[PATH_MAX];
+    snprintf(xmlPath, sizeof(xmlPath), "%s/%s", dirPath, REBUILD_XML_FILE);
+
+    ConfigTool_BackendConfig_t cfgRebuild = *cfgBackend;
+    ConfigTool_ConfigReader_t reader;
+
+    OS_Error_t err = ConfigTool_ConfigReaderOpen(&reader, cfgBackend->fsType,
+                                                 outPath);
+    if (err != OS_SUCCESS)
+    {
+        printf("Failed to read the configuration from '%s'!\n", outPath);
+        ConfigTool_RemoveRebuildDir(dirPath);
+        return err;
+    }
+
+    cfgRebuild.writeIndex |= (reader.indexFile != NULL);
+    clusterDomains |= ConfigTool_ConfigReaderIsClustered(&reader);
+
+    err = ConfigTool_ConfigDumperRun(&reader, xmlPath);
+    ConfigTool_ConfigReaderClose(&reader);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_ConfigDumperRun() failed with %d", err);
+        ConfigTool_RemoveRebuildDir(dirPath);
+        return err;
+    }
+
+    ConfigTool_Provisioning_t provisioning;
+
+    err = ConfigTool_ProvisioningLoad(
+              &provisioning,
+              xmlPath,
+              useStreamParser,
+              clusterDomains);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_ProvisioningLoad() failed with %d", err);
+        ConfigTool_RemoveRebuildDir(dirPath);
+        return err;
+    }
+
+    err = ConfigTool_SetRebuildValues(&provisioning.model, dirPath, blobDir,
+                                      values, valueCount);
+
+    // The partition keeps its size unless another one is requested
+    struct stat st;
+    if ((cfgRebuild.fsType != OS_FileSystem_Type_NONE)
+        && (cfgRebuild.imageSize == CONFIG_TOOL_BACKEND_IMAGE_SIZE_AUTO)
+        && (stat(outPath, &st) == 0))
+    {
+        cfgRebuild.imageSize = st.st_size;
+    }
+
+    if (err == OS_SUCCESS)
+    {
+        err = ConfigTool_ProvisioningPublish(&provisioning, &cfgRebuild, outPath);
+    }
+
+    ConfigTool_ProvisioningFree(&provisioning);
+    ConfigTool_RemoveRebuildDir(dirPath);
+
+    return err;
+}
+
+
+/* Rewrites the values in the existing output, falling back to a rebuild from
+ * the decoded records if a value does not fit in place
+ */
+static
+OS_Error_t
+ConfigTool_PatchOutput(
+    const char* outPath,
+    const char* filePath,
+    const ConfigTool_BackendConfig_t* cfgBackend,
+    const ConfigTool_ConfigPatcherValue_t* values,
+    size_t valueCount,
+    bool useStreamParser,
+    bool clusterDomains)
+{
+    char* blobDir = ConfigTool_GetBlobDir(filePath);
+    if (blobDir == NULL)
+    {
+        Debug_LOG_ERROR("Failed to resolve the directory of the blob files");
+        return OS_ERROR_GENERIC;
+    }
+
+    OS_Error_t err = ConfigTool_ProvisioningPatch(
+                         cfgBackend,
+                         outPath,
+                         values,
+                         valueCount,
+                         blobDir);
+
+    if (err == OS_ERROR_NOT_SUPPORTED)
+    {
+        printf("The values cannot be patched in place, rebuilding %s\n",
+               outPath);
+
+        err = ConfigTool_RebuildPatchedOutput(
+                  outPath,
+                  cfgBackend,
+                  blobDir,
+                  values,
+                  valueCount,
+                  useStreamParser,
+                  clusterDomains);
+    }
+
+    free(blobDir);
+
+    return err;
+}
+
+
+// Decodes the records of an existing output into an XML file
+static
+OS_Error_t ConfigTool_DumpOutput(
+    const char* outPath,
+    OS_FileSystem_Type_t fsType,
+    const char* xmlPath)
+{
+    ConfigTool_ConfigReader_t reader;
+
+    OS_Error_t err = ConfigTool_ConfigReaderOpen(&reader, fsType, outPath);
+    if (err != OS_SUCCESS)
+    {
+        printf("Failed to read the configuration from '%s'!\n", outPath);
+        return err;
+    }
+
+    err = ConfigTool_ConfigDumperRun(&reader, xmlPath);
+    if (err == OS_SUCCESS)
+    {
+        printf("Dump: %zu domains and %zu parameters written to %s\n",
+               reader.domainCount, reader.paramCount, xmlPath);
+    }
+
+    ConfigTool_ConfigReaderClose(&reader);
+
+    return err;
+}
+
+
+// Compares the records of an existing output with the XML file
+static
+OS_Error_t ConfigTool_VerifyOutput(
+    const char* outPath,
+    OS_FileSystem_Type_t fsType,
+    const char* filePath,
+    bool useStreamParser)
+{
+    ConfigTool_ConfigReader_t reader;
+    ConfigTool_Provisioning_t provisioning;
+
+    OS_Error_t err = ConfigTool_ConfigReaderOpen(&reader, fsType, outPath);
+    if (err != OS_SUCCESS)
+    {
+        printf("Failed to read the configuration from '%s'!\n", outPath);
+        return err;
+    }
+
+    // The model is ordered like the records, whichever layout they have
+    err = ConfigTool_ProvisioningLoad(&provisioning, filePath, useStreamParser,
+                                      ConfigTool_ConfigReaderIsClustered(&reader));
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_ProvisioningLoad() failed with %d", err);
+        ConfigTool_ConfigReaderClose(&reader);
+        return err;
+    }
+
+    size_t mismatchCount;
+    err = ConfigTool_ConfigVerifierRun(&reader, &provisioning.model,
+                                       &mismatchCount);
+    if ((err == OS_SUCCESS) && (mismatchCount > 0))
+    {
+        printf("Verify: %s differs from %s in %zu places\n", outPath, filePath,
+               mismatchCount);
+        err = OS_ERROR_GENERIC;
+    }
+    else if (err == OS_SUCCESS)
+    {
+        printf("Verify: %s matches %s, %zu domains and %zu parameters\n",
+               outPath, filePath, reader.domainCount, reader.paramCount);
+    }
+
+    ConfigTool_ProvisioningFree(&provisioning);
+    ConfigTool_ConfigReaderClose(&reader);
+
+    return err;
 }
 
 
 /* ---------------------------------------------------------------------------*/
-int main(int argc, char* argv[])
+/* Runs the tool with the parsed options. The values to patch are collected in
+ * the passed array, which is owned by main(), so no path has to free it.
+ */
+static
+int ConfigTool_Run(
+    int argc,
+    char* argv[],
+    ConfigTool_ConfigPatcherValue_t* patchValues)
 {
     const char* inFileName = NULL, *outFileName = NULL, *fileSystemType = NULL;
+    const char* outDir = NULL;
+    const char* batchFileName = NULL;
+    const char* socketPath = NULL;
+    const char* patchPath = NULL;
+    const char* dumpPath = NULL;
+    const char* verifyPath = NULL;
+    size_t patchValueCount = 0;
+    size_t maxWorkers = 0;
     bool createImageFile = false;
+    bool useStreamParser = false;
+    bool clusterDomains = false;
+    bool hasStats = false;
+    bool hasImageSize = false;
+    const char* statsPath = NULL;
+    char templateCacheDir[PATH_MAX];
+    struct stat st;
+    ConfigTool_StatsFormat_t statsFormat = CONFIG_TOOL_STATS_FORMAT_TABLE;
+    ConfigTool_BackendConfig_t cfgBackend =
+    {
+        .fsType = OS_FileSystem_Type_NONE,
+        .hostFsMode = CONFIG_TOOL_HOST_FS_MODE_WRITE,
+        .imageSize = CONFIG_TOOL_BACKEND_IMAGE_SIZE_AUTO,
+        .templateCacheDir = NULL,
+        .writeIndex = false,
+        .hostDir = NULL,
+    };
     OS_Error_t err;
 
     int opt;
-    while ((opt = getopt(argc, argv, "i:o:t:h")) != -1)
+    while ((opt = getopt_long(argc, argv, "i:o:t:j:smh", longOptions, NULL))
+           != -1)
     {
         switch (opt)
         {
@@ -168,6 +1007,103 @@ int main(int argc, char* argv[])
             fileSystemType = optarg;
             createImageFile = true;
             break;
+        case 's':
+            useStreamParser = true;
+            break;
+        case 'm':
+            cfgBackend.hostFsMode = CONFIG_TOOL_HOST_FS_MODE_MAP;
+            break;
+        case OPT_SIZE:
+            if (ConfigTool_ParseImageSize(optarg, &cfgBackend.imageSize) != OS_SUCCESS)
+            {
+                printf("Invalid image size: %s\n", optarg);
+                USAGE_STRING;
+                return -1;
+            }
+            hasImageSize = true;
+            break;
+        case OPT_OUTDIR:
+            outDir = optarg;
+            break;
+        case OPT_TEMPLATE_CACHE:
+            // Images are built in a private directory, so it must be absolute
+            if ((realpath(optarg, templateCacheDir) == NULL)
+                || (stat(templateCacheDir, &st) != 0) || !S_ISDIR(st.st_mode))
+            {
+                printf("Template cache directory '%s' does not exist!\n",
+                       optarg);
+                return -1;
+            }
+            cfgBackend.templateCacheDir = templateCacheDir;
+            break;
+        case OPT_BATCH:
+            batchFileName = optarg;
+            break;
+        case OPT_SERVE:
+            socketPath = optarg;
+            break;
+        case OPT_PATCH:
+            patchPath = optarg;
+            break;
+        case OPT_DUMP:
+            dumpPath = optarg;
+            break;
+        case OPT_VERIFY:
+            verifyPath = optarg;
+            break;
+        case OPT_INDEX:
+            cfgBackend.writeIndex = true;
+            break;
+        case OPT_CLUSTER_DOMAINS:
+            clusterDomains = true;
+            break;
+        case OPT_STATS:
+            if ((optarg != NULL) && (strcmp(optarg, "json") != 0))
+            {
+                printf("Invalid statistics format: %s\n", optarg);
+                USAGE_STRING;
+                return -1;
+            }
+            hasStats = true;
+            statsFormat = (optarg != NULL) ?
+                          CONFIG_TOOL_STATS_FORMAT_JSON :
+                          CONFIG_TOOL_STATS_FORMAT_TABLE;
+            break;
+        case OPT_STATS_FILE:
+            hasStats = true;
+            statsPath = optarg;
+            break;
+        case OPT_SET:
+        {
+            char* value = strchr(optarg, '=');
+            if (value == NULL)
+            {
+                printf("Invalid value: %s\n", optarg);
+                USAGE_STRING;
+                return -1;
+            }
+            *value++ = '\0';
+
+            patchValues[patchValueCount].name = optarg;
+            patchValues[patchValueCount].value = value;
+            patchValueCount++;
+            break;
+        }
+        case 'j':
+        {
+            char* end;
+            errno = 0;
+            unsigned long jobs = strtoul(optarg, &end, 10);
+            if ((errno != 0) || (end == optarg) || (*end != '\0')
+                || (optarg[0] == '-') || (jobs == 0))
+            {
+                printf("Invalid number of jobs: %s\n", optarg);
+                USAGE_STRING;
+                return -1;
+            }
+            maxWorkers = jobs;
+            break;
+        }
         case '?':
             printf("unknown option: %c\n", optopt);
             USAGE_STRING;
@@ -178,6 +1114,138 @@ int main(int argc, char* argv[])
         }
     }
 
+    // The counters are shared with the workers, so they are set up first
+    if (hasStats && (ConfigTool_StatsEnable() != OS_SUCCESS))
+    {
+        return -1;
+    }
+
+    // Dumping and verifying only read an existing output
+    if ((dumpPath != NULL) || (verifyPath != NULL))
+    {
+        if (((dumpPath != NULL) && (verifyPath != NULL))
+            || ((dumpPath != NULL) && ((outFileName == NULL)
+                                       || (inFileName != NULL)))
+            || ((verifyPath != NULL) && ((inFileName == NULL)
+                                         || (outFileName != NULL)))
+            || (patchPath != NULL) || (patchValueCount > 0) || (outDir != NULL)
+            || (batchFileName != NULL) || (socketPath != NULL))
+        {
+            printf("Invalid usage of the tool!\n"
+                   "Dumping takes the output, its FileSystem type and the XML "
+                   "file to write, verifying the output, its FileSystem type "
+                   "and the configuration XML file.\n");
+            USAGE_STRING;
+            return -1;
+        }
+
+        OS_FileSystem_Type_t fsType = OS_FileSystem_Type_NONE;
+        if ((fileSystemType != NULL)
+            && (ConfigTool_AssignFileSystemType(fileSystemType, &fsType)
+                != OS_SUCCESS))
+        {
+            return -1;
+        }
+
+        err = (dumpPath != NULL) ?
+              ConfigTool_DumpOutput(dumpPath, fsType, outFileName) :
+              ConfigTool_VerifyOutput(verifyPath, fsType, inFileName,
+                                      useStreamParser);
+        ConfigTool_StatsPrint(statsFormat, statsPath);
+
+        return (err == OS_SUCCESS) ? 0 : -1;
+    }
+
+    if ((patchPath != NULL) != (patchValueCount > 0))
+    {
+        printf("Invalid usage of the tool!\n"
+               "Patching requires an output and at least one value.\n");
+        USAGE_STRING;
+        return -1;
+    }
+
+    if (patchPath != NULL)
+    {
+        if ((outFileName != NULL) || (outDir != NULL) || (batchFileName != NULL)
+            || (socketPath != NULL))
+        {
+            printf("Invalid usage of the tool!\n"
+                   "Patching only takes the output, its FileSystem type and "
+                   "the configuration XML file the blob paths refer to.\n");
+            USAGE_STRING;
+            return -1;
+        }
+
+        err = OS_SUCCESS;
+        if (fileSystemType != NULL)
+        {
+            err = ConfigTool_AssignFileSystemType(fileSystemType,
+                                                  &cfgBackend.fsType);
+        }
+
+        if (err == OS_SUCCESS)
+        {
+            err = ConfigTool_PatchOutput(
+                      patchPath,
+                      inFileName,
+                      &cfgBackend,
+                      patchValues,
+                      patchValueCount,
+                      useStreamParser,
+                      clusterDomains);
+        }
+
+        ConfigTool_StatsPrint(statsFormat, statsPath);
+
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("ConfigTool_PatchOutput() failed with %d", err);
+            return -1;
+        }
+
+        return 0;
+    }
+
+    // Patched images keep their size, new ones get the fixed default size
+    if (!hasImageSize)
+    {
+        cfgBackend.imageSize = CONFIG_TOOL_BACKEND_DEFAULT_IMAGE_SIZE;
+    }
+
+    // The server takes the configuration and outputs with every request
+    if (socketPath != NULL)
+    {
+        if ((inFileName != NULL) || (outFileName != NULL)
+            || (fileSystemType != NULL) || (outDir != NULL)
+            || (batchFileName != NULL))
+        {
+            printf("Invalid usage of the tool!\n"
+                   "The server takes configurations and outputs with every "
+                   "request.\n");
+            USAGE_STRING;
+            return -1;
+        }
+
+        ConfigTool_ServerConfig_t cfgServer =
+        {
+            .socketPath = socketPath,
+            .maxWorkers = maxWorkers,
+            .useStreamParser = useStreamParser,
+            .clusterDomains = clusterDomains,
+            .cfgBackend = cfgBackend,
+        };
+
+        err = ConfigTool_ServerRun(&cfgServer);
+        ConfigTool_StatsPrint(statsFormat, statsPath);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("ConfigTool_ServerRun() failed with %d", err);
+            return -1;
+        }
+
+        return 0;
+    }
+
     if ((inFileName == NULL))
     {
         printf("Invalid usage of the tool!\n"
@@ -186,6 +1254,20 @@ int main(int argc, char* argv[])
         return -1;
     }
 
+    if ((batchFileName != NULL) && (outFileName != NULL))
+    {
+        printf("Invalid usage of the tool!\n"
+               "In batch mode the outputs are named by the batch table.\n");
+        USAGE_STRING;
+        return -1;
+    }
+
+    // In batch mode the filesystem types alone request images
+    if ((batchFileName != NULL) && (fileSystemType != NULL))
+    {
+        outFileName = "%t";
+    }
+
     if (((outFileName != NULL) && (fileSystemType == NULL)))
     {
         printf("Invalid usage of the tool!\n"
@@ -202,6 +1284,40 @@ int main(int argc, char* argv[])
         return -1;
     }
 
+    if (createImageFile && (cfgBackend.hostFsMode == CONFIG_TOOL_HOST_FS_MODE_MAP))
+    {
+        printf("Invalid usage of the tool!\n"
+               "Mapped output files are only supported without an image.\n");
+        USAGE_STRING;
+        return -1;
+    }
+
+    if (!createImageFile
+        && (hasImageSize || (cfgBackend.templateCacheDir != NULL)))
+    {
+        printf("Invalid usage of the tool!\n"
+               "An image size or template cache requires an image to be "
+               "created.\n");
+        USAGE_STRING;
+        return -1;
+    }
+
+    if ((batchFileName != NULL) && (outDir != NULL))
+    {
+        printf("Invalid usage of the tool!\n"
+               "In batch mode the outputs are named by the batch table.\n");
+        USAGE_STRING;
+        return -1;
+    }
+
+    if (createImageFile && (outDir != NULL))
+    {
+        printf("Invalid usage of the tool!\n"
+               "An output directory is only supported without an image.\n");
+        USAGE_STRING;
+        return -1;
+    }
+
     // Verify that the provided configuration file can be opened
     FILE* f = fopen(inFileName, "r");
     if (f == NULL)
@@ -212,41 +1328,93 @@ int main(int argc, char* argv[])
     }
     fclose(f);
 
-    OS_FileSystem_Type_t fsType = OS_FileSystem_Type_NONE;
-
-    if (createImageFile)
+    ConfigTool_BatchTable_t table;
+    if (batchFileName != NULL)
     {
-        err = ConfigTool_AssignFileSystemType(fileSystemType, &fsType);
+        err = ConfigTool_BatchTableLoad(&table, batchFileName);
         if (err != OS_SUCCESS)
         {
-            Debug_LOG_ERROR("ConfigTool_AssignFileSystemType() failed with %d", err);
+            printf("Failed to load the batch table '%s'!\n", batchFileName);
             return -1;
         }
     }
 
-    // Parse the file and get the DOM(document object model)
-    xmlDoc* doc = xmlReadFile(inFileName, NULL, 0);
-    if (doc == NULL)
+    ConfigTool_Target_t outputs[MAX_OUTPUTS];
+    size_t outputCount = 1;
+
+    if (createImageFile)
     {
-        Debug_LOG_ERROR("Could not parse input XML file %s", inFileName);
-        return -1;
+        err = ConfigTool_AssignOutputs(
+                  fileSystemType,
+                  outFileName,
+                  &cfgBackend,
+                  outputs,
+                  &outputCount);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("ConfigTool_AssignOutputs() failed with %d", err);
+            goto exit;
+        }
+    }
+    else
+    {
+        outputs[0].cfgBackend = cfgBackend;
+        outputs[0].typeName = NULL;
+        outputs[0].outPath = strdup((outDir != NULL) ? outDir : ".");
+        if (outputs[0].outPath == NULL)
+        {
+            Debug_LOG_ERROR("Failed to allocate memory");
+            err = OS_ERROR_INSUFFICIENT_SPACE;
+            goto exit;
+        }
     }
 
     err = ConfigTool_CreateProvisioning(
-              doc,
               inFileName,
-              outFileName,
-              fsType,
-              createImageFile);
+              outputs,
+              outputCount,
+              (batchFileName != NULL) ? &table : NULL,
+              maxWorkers,
+              useStreamParser,
+              clusterDomains);
+
+    for (size_t i = 0; i < outputCount; i++)
+    {
+        free(outputs[i].outPath);
+    }
+
+exit:
+    if (batchFileName != NULL)
+    {
+        ConfigTool_BatchTableFree(&table);
+    }
+
+    ConfigTool_StatsPrint(statsFormat, statsPath);
+
     if (err != OS_SUCCESS)
     {
         Debug_LOG_ERROR("ConfigTool_CreateProvisioning() failed with %d", err);
-        xmlFreeDoc(doc);
         return -1;
     }
 
-    // free the document
-    xmlFreeDoc(doc);
-
     return 0;
 }
+
+
+int main(int argc, char* argv[])
+{
+    // There are never more values to patch than arguments
+    ConfigTool_ConfigPatcherValue_t* patchValues = calloc(argc,
+                                                          sizeof(*patchValues));
+    if (patchValues == NULL)
+    {
+        Debug_LOG_ERROR("Failed to allocate memory");
+        return -1;
+    }
+
+    int ret = ConfigTool_Run(argc, argv, patchValues);
+
+    free(patchValues);
+
+    return ret;
+}
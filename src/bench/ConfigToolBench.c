@@ -0,0 +1,847 @@
+/**
+ * Benchmark of the Configuration Provisioning Tool
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+// nftw() and MAP_ANONYMOUS are extensions
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <getopt.h>
+#include <ftw.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "lib_debug/Debug.h"
+#include "ConfigTool_Provisioning.h"
+#include "ConfigTool_Worker.h"
+#include "ConfigToolBench_Generator.h"
+
+
+/* Defines -------------------------------------------------------------------*/
+#define USAGE_STRING                                   \
+    printf("Usage: cpt_bench "                         \
+           "[-t <filesystem_type>[,...]] "             \
+           "[-n <iterations>] "                        \
+           "[--scenario <name>] "                      \
+           "[--domains <count>] [--params <count>] "   \
+           "[--mix <int32>:<int64>:<string>:<blob>] "  \
+           "[--max-blob-size <size>] "                 \
+           "[--seed <seed>] "                          \
+           "[--workdir <dir>] [-s]\n"                  \
+           "       cpt_bench --generate <dir> "        \
+           "[--scenario <name>] "                      \
+           "[--domains <count>] [--params <count>] "   \
+           "[--mix <int32>:<int64>:<string>:<blob>] "  \
+           "[--max-blob-size <size>] [--seed <seed>]\n")
+
+// Long options without a short option use values beyond the character range
+#define OPT_SCENARIO      256
+#define OPT_DOMAINS       257
+#define OPT_PARAMS        258
+#define OPT_MIX           259
+#define OPT_MAX_BLOB_SIZE 260
+#define OPT_SEED          261
+#define OPT_WORKDIR       262
+#define OPT_GENERATE      263
+
+#define DEFAULT_ITERATIONS 10
+#define DEFAULT_FS_TYPES   "FAT,SPIFFS,LITTLEFS,HOST"
+
+// One run per supported filesystem type and the plain host files
+#define MAX_FS_TYPES 4
+
+#define NSEC_PER_SEC UINT64_C(1000000000)
+
+#define SCENARIO_COUNT (sizeof(scenarios) / sizeof(scenarios[0]))
+
+
+/* Private types/enums -------------------------------------------------------*/
+// A named shape of a generated configuration
+typedef struct
+{
+    const char* name;                      /**< name in the report */
+    ConfigToolBench_GeneratorConfig_t cfg; /**< shape of the configuration */
+} ConfigToolBench_Scenario_t;
+
+// A filesystem type the configurations are written with
+typedef struct
+{
+    const char* name;            /**< name in the report */
+    OS_FileSystem_Type_t fsType; /**< type of the image, none for host files */
+} ConfigToolBench_FsType_t;
+
+/* The samples of one scenario and filesystem type. Every sample builds the
+ * output from the XML file in a worker of its own, like a run of the tool,
+ * and stores its latency in the array shared with the workers.
+ */
+typedef struct
+{
+    const char* xmlPath;                   /**< configuration to build */
+    const char* outPath;                   /**< image file or directory */
+    ConfigTool_BackendConfig_t cfgBackend; /**< backend of the output */
+    bool useStreamParser;                  /**< parse with xmlTextReader */
+    uint64_t* samples;                     /**< latency of every sample */
+    uint64_t* loadSamples;                 /**< loading time of every sample */
+} ConfigToolBench_Run_t;
+
+
+/* Private variables ---------------------------------------------------------*/
+static const struct option longOptions[] =
+{
+    { "scenario",      required_argument, NULL, OPT_SCENARIO },
+    { "domains",       required_argument, NULL, OPT_DOMAINS },
+    { "params",        required_argument, NULL, OPT_PARAMS },
+    { "mix",           required_argument, NULL, OPT_MIX },
+    { "max-blob-size", required_argument, NULL, OPT_MAX_BLOB_SIZE },
+    { "seed",          required_argument, NULL, OPT_SEED },
+    { "workdir",       required_argument, NULL, OPT_WORKDIR },
+    { "generate",      required_argument, NULL, OPT_GENERATE },
+    { "iterations",    required_argument, NULL, 'n' },
+    { NULL,            0,                 NULL, 0 }
+};
+
+// Built-in scenarios, run one after the other by default
+static const ConfigToolBench_Scenario_t scenarios[] =
+{
+    // Few integers and strings, dominated by setting up the backend
+    {
+        "small",
+        {
+            .domainCount = 4,
+            .paramCount = 64,
+            .typeWeights = { 4, 2, 2, 0 },
+            .maxBlobSize = 0,
+            .seed = 1,
+        }
+    },
+    // Strings of up to the maximum length spread over many domains
+    {
+        "strings",
+        {
+            .domainCount = 64,
+            .paramCount = 16384,
+            .typeWeights = { 0, 0, 1, 0 },
+            .maxBlobSize = 0,
+            .seed = 2,
+        }
+    },
+    // Many parameters of all types with small blobs
+    {
+        "large",
+        {
+            .domainCount = 256,
+            .paramCount = 100000,
+            .typeWeights = { 4, 2, 3, 1 },
+            .maxBlobSize = 4096,
+            .seed = 3,
+        }
+    },
+    // Few blobs of up to the maximum blob size
+    {
+        "blobs",
+        {
+            .domainCount = 2,
+            .paramCount = 8,
+            .typeWeights = { 0, 0, 0, 1 },
+            .maxBlobSize = CONFIG_TOOL_BENCH_MAX_BLOB_SIZE,
+            .seed = 4,
+        }
+    },
+    /* The same shape with a growing number of parameters and no blobs, the
+     * loading time of the three shows whether loading scales linearly
+     */
+    {
+        "load-10k",
+        {
+            .domainCount = 256,
+            .paramCount = 10000,
+            .typeWeights = { 4, 2, 3, 0 },
+            .maxBlobSize = 0,
+            .seed = 5,
+        }
+    },
+    {
+        "load-50k",
+        {
+            .domainCount = 256,
+            .paramCount = 50000,
+            .typeWeights = { 4, 2, 3, 0 },
+            .maxBlobSize = 0,
+            .seed = 5,
+        }
+    },
+    {
+        "load-100k",
+        {
+            .domainCount = 256,
+            .paramCount = 100000,
+            .typeWeights = { 4, 2, 3, 0 },
+            .maxBlobSize = 0,
+            .seed = 5,
+        }
+    },
+};
+
+static const ConfigToolBench_FsType_t fsTypes[MAX_FS_TYPES] =
+{
+    { "FAT",      OS_FileSystem_Type_FATFS },
+    { "SPIFFS",   OS_FileSystem_Type_SPIFFS },
+    { "LITTLEFS", OS_FileSystem_Type_LITTLEFS },
+    { "HOST",     OS_FileSystem_Type_NONE },
+};
+
+static const char* const typeNames[CONFIG_TOOL_BENCH_TYPE_COUNT] =
+{
+    "int32", "int64", "string", "blob"
+};
+
+
+/* Private functions ---------------------------------------------------------*/
+// Parses a number with an optional K or M suffix
+static
+OS_Error_t ConfigToolBench_ParseNumber(
+    const char* arg,
+    uint64_t max,
+    uint64_t* value)
+{
+    char* end;
+    errno = 0;
+    unsigned long long number = strtoull(arg, &end, 0);
+    if ((errno != 0) || (end == arg) || (arg[0] == '-'))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    unsigned shift = 0;
+    switch (*end)
+    {
+    case 'K':
+    case 'k':
+        shift = 10;
+        end++;
+        break;
+    case 'M':
+    case 'm':
+        shift = 20;
+        end++;
+        break;
+    }
+
+    if ((*end != '\0') || (number > (max >> shift)))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    *value = (uint64_t)number << shift;
+
+    return OS_SUCCESS;
+}
+
+
+// Parses the type weights "<int32>:<int64>:<string>:<blob>"
+static
+OS_Error_t ConfigToolBench_ParseMix(
+    const char* arg,
+    uint32_t* typeWeights)
+{
+    for (size_t i = 0; i < CONFIG_TOOL_BENCH_TYPE_COUNT; i++)
+    {
+        char* end;
+        errno = 0;
+        unsigned long weight = strtoul(arg, &end, 10);
+        if ((errno != 0) || (end == arg) || (arg[0] == '-')
+            || (weight > UINT16_MAX)
+            || (*end != ((i + 1 < CONFIG_TOOL_BENCH_TYPE_COUNT) ? ':' : '\0')))
+        {
+            return OS_ERROR_INVALID_PARAMETER;
+        }
+        typeWeights[i] = (uint32_t)weight;
+        arg = end + 1;
+    }
+
+    return OS_SUCCESS;
+}
+
+
+// Selects the filesystem types of the comma separated list
+static
+OS_Error_t ConfigToolBench_AssignFsTypes(
+    const char* list,
+    const ConfigToolBench_FsType_t** types,
+    size_t* typeCount)
+{
+    char* copy = strdup(list);
+    if (copy == NULL)
+    {
+        Debug_LOG_ERROR("Failed to allocate memory");
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+
+    OS_Error_t err = OS_SUCCESS;
+    char* save;
+    *typeCount = 0;
+
+    for (char* name = strtok_r(copy, ",", &save); name != NULL;
+         name = strtok_r(NULL, ",", &save))
+    {
+        size_t i = 0;
+        while ((i < MAX_FS_TYPES) && (strcmp(name, fsTypes[i].name) != 0))
+        {
+            i++;
+        }
+
+        if ((i == MAX_FS_TYPES) || (*typeCount == MAX_FS_TYPES))
+        {
+            printf("Requested FileSystem not supported: %s\n", name);
+            err = OS_ERROR_NOT_SUPPORTED;
+            break;
+        }
+
+        types[(*typeCount)++] = &fsTypes[i];
+    }
+
+    if ((err == OS_SUCCESS) && (*typeCount == 0))
+    {
+        printf("No FileSystem type provided!\n");
+        err = OS_ERROR_INVALID_PARAMETER;
+    }
+
+    free(copy);
+
+    return err;
+}
+
+
+static
+uint64_t ConfigToolBench_GetTime(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * NSEC_PER_SEC) + (uint64_t)ts.tv_nsec;
+}
+
+
+// Builds the output once from the XML file, run by a worker of its own
+static
+OS_Error_t ConfigToolBench_RunSample(
+    size_t index,
+    void* ctx)
+{
+    ConfigToolBench_Run_t* run = ctx;
+    ConfigTool_Provisioning_t provisioning;
+    uint64_t start = ConfigToolBench_GetTime();
+
+    OS_Error_t err = ConfigTool_ProvisioningLoad(
+                         &provisioning,
+                         run->xmlPath,
+                         run->useStreamParser,
+                         false);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_ProvisioningLoad() failed with %d", err);
+        return err;
+    }
+
+    run->loadSamples[index] = ConfigToolBench_GetTime() - start;
+
+    err = ConfigTool_ProvisioningPublish(
+              &provisioning,
+              &run->cfgBackend,
+              run->outPath);
+    ConfigTool_ProvisioningFree(&provisioning);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_ProvisioningPublish() failed for %s with %d",
+                        run->outPath, err);
+        return err;
+    }
+
+    run->samples[index] = ConfigToolBench_GetTime() - start;
+
+    return OS_SUCCESS;
+}
+
+
+static
+int ConfigToolBench_CompareSamples(
+    const void* a,
+    const void* b)
+{
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+
+    return (x > y) - (x < y);
+}
+
+
+// Nearest-rank percentile of the sorted samples
+static
+uint64_t ConfigToolBench_GetPercentile(
+    const uint64_t* samples,
+    size_t count,
+    unsigned percent)
+{
+    size_t rank = ((count * percent) + 99) / 100;
+
+    return samples[(rank > 0) ? (rank - 1) : 0];
+}
+
+
+// Sorts the samples and returns their sum
+static
+uint64_t ConfigToolBench_SortSamples(
+    uint64_t* samples,
+    size_t count)
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        total += samples[i];
+    }
+    qsort(samples, count, sizeof(*samples), ConfigToolBench_CompareSamples);
+
+    return total;
+}
+
+
+// Prints the report of a run as a single JSON object
+static
+void ConfigToolBench_PrintReport(
+    const ConfigToolBench_Scenario_t* scenario,
+    const ConfigToolBench_GeneratorResult_t* result,
+    const ConfigToolBench_FsType_t* type,
+    uint64_t* samples,
+    uint64_t* loadSamples,
+    size_t count)
+{
+    uint64_t total = ConfigToolBench_SortSamples(samples, count);
+    uint64_t loadTotal = ConfigToolBench_SortSamples(loadSamples, count);
+
+    double seconds = (total > 0) ? ((double)total / NSEC_PER_SEC) : 1.0;
+    double bytes = (double)(result->xmlSize + result->blobSize) * count;
+
+    printf("{\"scenario\":\"%s\",\"fs\":\"%s\",\"domains\":%" PRIu32
+           ",\"params\":%" PRIu32 ",\"types\":{", scenario->name, type->name,
+           scenario->cfg.domainCount, scenario->cfg.paramCount);
+    for (size_t i = 0; i < CONFIG_TOOL_BENCH_TYPE_COUNT; i++)
+    {
+        printf("%s\"%s\":%" PRIu32, (i > 0) ? "," : "", typeNames[i],
+               result->typeCounts[i]);
+    }
+    printf("},\"xml_bytes\":%" PRIu64 ",\"blob_bytes\":%" PRIu64
+           ",\"iterations\":%zu,\"params_per_s\":%.1f,\"mb_per_s\":%.3f"
+           ",\"latency_ns\":{\"min\":%" PRIu64 ",\"mean\":%" PRIu64
+           ",\"p50\":%" PRIu64 ",\"p90\":%" PRIu64 ",\"p99\":%" PRIu64
+           ",\"max\":%" PRIu64 "}",
+           result->xmlSize, result->blobSize, count,
+           ((double)scenario->cfg.paramCount * count) / seconds,
+           (bytes / 1e6) / seconds,
+           samples[0], total / count,
+           ConfigToolBench_GetPercentile(samples, count, 50),
+           ConfigToolBench_GetPercentile(samples, count, 90),
+           ConfigToolBench_GetPercentile(samples, count, 99),
+           samples[count - 1]);
+    printf(",\"load_ns\":{\"min\":%" PRIu64 ",\"mean\":%" PRIu64
+           ",\"p50\":%" PRIu64 ",\"max\":%" PRIu64 "}}\n",
+           loadSamples[0], loadTotal / count,
+           ConfigToolBench_GetPercentile(loadSamples, count, 50),
+           loadSamples[count - 1]);
+    fflush(stdout);
+}
+
+
+// Measures one scenario written with one filesystem type
+static
+OS_Error_t ConfigToolBench_RunFsType(
+    const ConfigToolBench_Scenario_t* scenario,
+    const ConfigToolBench_GeneratorResult_t* result,
+    const ConfigToolBench_FsType_t* type,
+    const char* dirPath,
+    size_t iterations,
+    bool useStreamParser)
+{
+    char xmlPath[PATH_MAX];
+    char outPath[PATH_MAX];
+
+    if ((snprintf(xmlPath, sizeof(xmlPath), "%s/%s", dirPath,
+                  CONFIG_TOOL_BENCH_XML_FILE) >= (int)sizeof(xmlPath))
+        || (snprintf(outPath, sizeof(outPath), "%s/out_%s%s", dirPath,
+                     type->name,
+                     (type->fsType != OS_FileSystem_Type_NONE) ? ".img" : "")
+            >= (int)sizeof(outPath)))
+    {
+        Debug_LOG_ERROR("Path too long in %s", dirPath);
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    // The host files are published into a directory
+    if ((type->fsType == OS_FileSystem_Type_NONE)
+        && (mkdir(outPath, 0755) != 0) && (errno != EEXIST))
+    {
+        Debug_LOG_ERROR("mkdir() failed for %s with errno %d", outPath, errno);
+        return OS_ERROR_GENERIC;
+    }
+
+    // The first sample warms up the caches and is not counted, it also makes
+    // sure there are several jobs, so every sample runs in a worker. The
+    // loading times follow the latencies in the same mapping.
+    size_t sampleCount = iterations + 1;
+    uint64_t* samples = mmap(NULL, 2 * sampleCount * sizeof(uint64_t),
+                             PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS,
+                             -1, 0);
+    if (samples == MAP_FAILED)
+    {
+        Debug_LOG_ERROR("mmap() failed for the samples");
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+
+    ConfigToolBench_Run_t run =
+    {
+        .xmlPath = xmlPath,
+        .outPath = outPath,
+        .cfgBackend =
+        {
+            .fsType = type->fsType,
+            .hostFsMode = CONFIG_TOOL_HOST_FS_MODE_WRITE,
+            .imageSize = CONFIG_TOOL_BACKEND_IMAGE_SIZE_AUTO,
+            .templateCacheDir = NULL,
+            .writeIndex = false,
+            .hostDir = NULL,
+        },
+        .useStreamParser = useStreamParser,
+        .samples = samples,
+        .loadSamples = &samples[sampleCount],
+    };
+
+    OS_Error_t err = ConfigTool_WorkerRun(sampleCount, 1,
+                                          ConfigToolBench_RunSample, &run);
+    if (err == OS_SUCCESS)
+    {
+        ConfigToolBench_PrintReport(scenario, result, type, &samples[1],
+                                    &run.loadSamples[1], iterations);
+    }
+    else
+    {
+        printf("Building %s of scenario %s failed!\n", type->name,
+               scenario->name);
+    }
+
+    munmap(samples, 2 * sampleCount * sizeof(uint64_t));
+
+    return err;
+}
+
+
+static
+OS_Error_t ConfigToolBench_RunScenario(
+    const ConfigToolBench_Scenario_t* scenario,
+    const ConfigToolBench_FsType_t* const* types,
+    size_t typeCount,
+    const char* workDir,
+    size_t iterations,
+    bool useStreamParser)
+{
+    char dirPath[PATH_MAX];
+
+    if (snprintf(dirPath, sizeof(dirPath), "%s/%s", workDir, scenario->name)
+        >= (int)sizeof(dirPath))
+    {
+        Debug_LOG_ERROR("Path too long in %s", workDir);
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    if ((mkdir(dirPath, 0755) != 0) && (errno != EEXIST))
+    {
+        Debug_LOG_ERROR("mkdir() failed for %s with errno %d", dirPath, errno);
+        return OS_ERROR_GENERIC;
+    }
+
+    ConfigToolBench_GeneratorResult_t result;
+    OS_Error_t err = ConfigToolBench_Generate(&scenario->cfg, dirPath, &result);
+    if (err != OS_SUCCESS)
+    {
+        printf("Generating scenario %s failed!\n", scenario->name);
+        return err;
+    }
+
+    for (size_t i = 0; i < typeCount; i++)
+    {
+        err = ConfigToolBench_RunFsType(scenario, &result, types[i], dirPath,
+                                        iterations, useStreamParser);
+        if (err != OS_SUCCESS)
+        {
+            return err;
+        }
+    }
+
+    return OS_SUCCESS;
+}
+
+
+static
+int ConfigToolBench_RemoveEntry(
+    const char* path,
+    const struct stat* st,
+    int flag,
+    struct FTW* ftw)
+{
+    (void)st;
+    (void)flag;
+    (void)ftw;
+
+    if (remove(path) != 0)
+    {
+        Debug_LOG_ERROR("remove() failed for %s with errno %d", path, errno);
+    }
+
+    return 0;
+}
+
+
+int main(int argc, char* argv[])
+{
+    const char* fileSystemTypes = DEFAULT_FS_TYPES;
+    const char* scenarioName = NULL;
+    const char* workDir = NULL;
+    const char* generateDir = NULL;
+    size_t iterations = DEFAULT_ITERATIONS;
+    bool useStreamParser = false;
+    bool hasCustomShape = false;
+    bool hasSeed = false;
+    uint32_t seed = 0;
+    ConfigToolBench_Scenario_t custom =
+    {
+        .name = "custom",
+        .cfg =
+        {
+            .domainCount = 16,
+            .paramCount = 1024,
+            .typeWeights = { 4, 2, 3, 1 },
+            .maxBlobSize = 4096,
+            .seed = 1,
+        },
+    };
+    uint64_t value;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "t:n:sh", longOptions, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 't':
+            fileSystemTypes = optarg;
+            break;
+        case 'n':
+            if ((ConfigToolBench_ParseNumber(optarg, SIZE_MAX, &value)
+                 != OS_SUCCESS) || (value == 0))
+            {
+                printf("Invalid number of iterations: %s\n", optarg);
+                USAGE_STRING;
+                return -1;
+            }
+            iterations = (size_t)value;
+            break;
+        case 's':
+            useStreamParser = true;
+            break;
+        case OPT_SCENARIO:
+            scenarioName = optarg;
+            break;
+        case OPT_DOMAINS:
+            if (ConfigToolBench_ParseNumber(optarg, UINT32_MAX, &value)
+                != OS_SUCCESS)
+            {
+                printf("Invalid number of domains: %s\n", optarg);
+                USAGE_STRING;
+                return -1;
+            }
+            custom.cfg.domainCount = (uint32_t)value;
+            hasCustomShape = true;
+            break;
+        case OPT_PARAMS:
+            if (ConfigToolBench_ParseNumber(optarg, UINT32_MAX, &value)
+                != OS_SUCCESS)
+            {
+                printf("Invalid number of parameters: %s\n", optarg);
+                USAGE_STRING;
+                return -1;
+            }
+            custom.cfg.paramCount = (uint32_t)value;
+            hasCustomShape = true;
+            break;
+        case OPT_MIX:
+            if (ConfigToolBench_ParseMix(optarg, custom.cfg.typeWeights)
+                != OS_SUCCESS)
+            {
+                printf("Invalid type mix: %s\n", optarg);
+                USAGE_STRING;
+                return -1;
+            }
+            hasCustomShape = true;
+            break;
+        case OPT_MAX_BLOB_SIZE:
+            if (ConfigToolBench_ParseNumber(optarg,
+                                            CONFIG_TOOL_BENCH_MAX_BLOB_SIZE,
+                                            &value) != OS_SUCCESS)
+            {
+                printf("Invalid blob size: %s\n", optarg);
+                USAGE_STRING;
+                return -1;
+            }
+            custom.cfg.maxBlobSize = (size_t)value;
+            hasCustomShape = true;
+            break;
+        case OPT_SEED:
+            if (ConfigToolBench_ParseNumber(optarg, UINT32_MAX, &value)
+                != OS_SUCCESS)
+            {
+                printf("Invalid seed: %s\n", optarg);
+                USAGE_STRING;
+                return -1;
+            }
+            seed = (uint32_t)value;
+            hasSeed = true;
+            break;
+        case OPT_WORKDIR:
+            workDir = optarg;
+            break;
+        case OPT_GENERATE:
+            generateDir = optarg;
+            break;
+        case '?':
+            printf("unknown option: %c\n", optopt);
+            USAGE_STRING;
+            return -1;
+        case 'h':
+            USAGE_STRING;
+            return 0;
+        }
+    }
+
+    if (hasCustomShape && (scenarioName != NULL))
+    {
+        printf("Invalid usage of the tool!\n"
+               "A scenario cannot be combined with a custom shape.\n");
+        USAGE_STRING;
+        return -1;
+    }
+
+    // Select the scenarios to run, all built-in ones by default
+    ConfigToolBench_Scenario_t selected[SCENARIO_COUNT];
+    size_t scenarioCount = 0;
+
+    if (hasCustomShape)
+    {
+        selected[scenarioCount++] = custom;
+    }
+    else
+    {
+        for (size_t i = 0; i < SCENARIO_COUNT; i++)
+        {
+            if ((scenarioName == NULL)
+                || (strcmp(scenarioName, scenarios[i].name) == 0))
+            {
+                selected[scenarioCount++] = scenarios[i];
+            }
+        }
+    }
+
+    if (scenarioCount == 0)
+    {
+        printf("Unknown scenario: %s\n", scenarioName);
+        return -1;
+    }
+
+    for (size_t i = 0; hasSeed && (i < scenarioCount); i++)
+    {
+        selected[i].cfg.seed = seed;
+    }
+
+    // Only write the configuration, for use with the tool itself
+    if (generateDir != NULL)
+    {
+        if ((scenarioCount != 1) || (workDir != NULL))
+        {
+            printf("Invalid usage of the tool!\n"
+                   "Generating takes a single scenario or custom shape.\n");
+            USAGE_STRING;
+            return -1;
+        }
+
+        if ((mkdir(generateDir, 0755) != 0) && (errno != EEXIST))
+        {
+            printf("Failed to create the directory '%s'!\n", generateDir);
+            return -1;
+        }
+
+        ConfigToolBench_GeneratorResult_t result;
+        if (ConfigToolBench_Generate(&selected[0].cfg, generateDir, &result)
+            != OS_SUCCESS)
+        {
+            printf("Generating scenario %s failed!\n", selected[0].name);
+            return -1;
+        }
+
+        return 0;
+    }
+
+    const ConfigToolBench_FsType_t* types[MAX_FS_TYPES];
+    size_t typeCount;
+    if (ConfigToolBench_AssignFsTypes(fileSystemTypes, types, &typeCount)
+        != OS_SUCCESS)
+    {
+        USAGE_STRING;
+        return -1;
+    }
+
+    // Without a work directory, a temporary one is used and removed again
+    char tmpDir[] = "cpt_bench.XXXXXX";
+    if ((workDir == NULL) && ((workDir = mkdtemp(tmpDir)) == NULL))
+    {
+        Debug_LOG_ERROR("mkdtemp() failed with errno %d", errno);
+        return -1;
+    }
+
+    // Publishing changes the working directory, so all paths are absolute
+    char* absWorkDir = realpath(workDir, NULL);
+    if (absWorkDir == NULL)
+    {
+        Debug_LOG_ERROR("realpath() failed for %s with errno %d", workDir,
+                        errno);
+        return -1;
+    }
+
+    OS_Error_t err = OS_SUCCESS;
+    for (size_t i = 0; (err == OS_SUCCESS) && (i < scenarioCount); i++)
+    {
+        err = ConfigToolBench_RunScenario(&selected[i], types, typeCount,
+                                          absWorkDir, iterations,
+                                          useStreamParser);
+    }
+
+    if (workDir == tmpDir)
+    {
+        nftw(absWorkDir, ConfigToolBench_RemoveEntry, 16, FTW_DEPTH | FTW_PHYS);
+    }
+    free(absWorkDir);
+
+    return (err == OS_SUCCESS) ? 0 : -1;
+}
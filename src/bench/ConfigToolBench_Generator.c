@@ -0,0 +1,379 @@
+/*
+ * Generator of synthetic configurations for the benchmark
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <string.h>
+
+#include "lib_debug/Debug.h"
+#include "OS_ConfigService.h"
+#include "ConfigToolBench_Generator.h"
+
+
+/* Defines -------------------------------------------------------------------*/
+// Blob files are written in chunks of this size
+#define BLOB_CHUNK_SIZE  (64 * 1024)
+
+// Characters of string values, the last ones have to be escaped in XML
+#define STRING_CHARS     "abcdefghijklmnopqrstuvwxyz" \
+                         "ABCDEFGHIJKLMNOPQRSTUVWXYZ" \
+                         "0123456789-_.:&<>"
+
+
+/* Private types/enums -------------------------------------------------------*/
+// State of a generator run
+typedef struct
+{
+    const ConfigToolBench_GeneratorConfig_t* cfg; /**< shape to generate */
+    const char* dirPath;                          /**< target directory */
+    uint32_t random;                              /**< xorshift32 state */
+    uint32_t blobCount;                           /**< blob files written */
+    ConfigToolBench_GeneratorResult_t* result;    /**< summary to fill */
+} ConfigToolBench_Generator_t;
+
+
+/* Private variables ---------------------------------------------------------*/
+static const char* const typeNames[CONFIG_TOOL_BENCH_TYPE_COUNT] =
+{
+    "int32", "int64", "string", "blob"
+};
+
+
+/* Private functions ---------------------------------------------------------*/
+static
+uint32_t
+ConfigToolBench_GeneratorNext(
+    ConfigToolBench_Generator_t* self)
+{
+    uint32_t x = self->random;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    return self->random = x;
+}
+
+// Returns a number from min to max, both included
+static
+uint64_t
+ConfigToolBench_GeneratorRange(
+    ConfigToolBench_Generator_t* self,
+    uint64_t min,
+    uint64_t max)
+{
+    uint64_t x = ((uint64_t)ConfigToolBench_GeneratorNext(self) << 32)
+                 | ConfigToolBench_GeneratorNext(self);
+
+    return min + (x % (max - min + 1));
+}
+
+static
+ConfigToolBench_ParamType_t
+ConfigToolBench_GeneratorPickType(
+    ConfigToolBench_Generator_t* self,
+    uint32_t totalWeight)
+{
+    uint32_t x = (uint32_t)ConfigToolBench_GeneratorRange(self, 0,
+                                                           totalWeight - 1);
+    ConfigToolBench_ParamType_t type = CONFIG_TOOL_BENCH_TYPE_INT32;
+
+    while (x >= self->cfg->typeWeights[type])
+    {
+        x -= self->cfg->typeWeights[type];
+        type++;
+    }
+
+    return type;
+}
+
+// Writes a name of the prefix and index, padded to a random length
+static
+void
+ConfigToolBench_GeneratorWriteName(
+    ConfigToolBench_Generator_t* self,
+    FILE* f,
+    const char* prefix,
+    uint32_t index,
+    size_t maxLength)
+{
+    int length = fprintf(f, "%s%" PRIu32, prefix, index);
+    if ((length < 0) || ((size_t)length >= maxLength))
+    {
+        return;
+    }
+
+    size_t padding = ConfigToolBench_GeneratorRange(self, 0,
+                                                    maxLength - (size_t)length);
+
+    for (size_t i = 0; i < padding; i++)
+    {
+        fputc('x', f);
+    }
+}
+
+static
+void
+ConfigToolBench_GeneratorWriteString(
+    ConfigToolBench_Generator_t* self,
+    FILE* f)
+{
+    size_t length = ConfigToolBench_GeneratorRange(
+                        self, 1, OS_CONFIG_LIB_PARAMETER_MAX_STRING_SIZE - 1);
+
+    for (size_t i = 0; i < length; i++)
+    {
+        char c = STRING_CHARS[ConfigToolBench_GeneratorRange(
+                                  self, 0, sizeof(STRING_CHARS) - 2)];
+        switch (c)
+        {
+        case '&':
+            fputs("&amp;", f);
+            break;
+        case '<':
+            fputs("&lt;", f);
+            break;
+        case '>':
+            fputs("&gt;", f);
+            break;
+        default:
+            fputc(c, f);
+            break;
+        }
+    }
+}
+
+// Writes a blob file of random size and content, returns its index
+static
+OS_Error_t
+ConfigToolBench_GeneratorWriteBlob(
+    ConfigToolBench_Generator_t* self,
+    uint32_t* blobIndex)
+{
+    static uint32_t chunk[BLOB_CHUNK_SIZE / sizeof(uint32_t)];
+    char path[PATH_MAX];
+
+    if (snprintf(path, sizeof(path), "%s/blob-%" PRIu32 ".bin", self->dirPath,
+                 self->blobCount) >= (int)sizeof(path))
+    {
+        Debug_LOG_ERROR("Blob path too long in %s", self->dirPath);
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    FILE* f = fopen(path, "wb");
+    if (f == NULL)
+    {
+        Debug_LOG_ERROR("fopen() failed for %s", path);
+        return OS_ERROR_GENERIC;
+    }
+
+    size_t size = ConfigToolBench_GeneratorRange(self, 1,
+                                                 self->cfg->maxBlobSize);
+    size_t left = size;
+
+    while (left > 0)
+    {
+        size_t len = (left < sizeof(chunk)) ? left : sizeof(chunk);
+
+        for (size_t i = 0; i < (len + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+             i++)
+        {
+            chunk[i] = ConfigToolBench_GeneratorNext(self);
+        }
+
+        if (fwrite(chunk, 1, len, f) != len)
+        {
+            Debug_LOG_ERROR("fwrite() failed for %s", path);
+            fclose(f);
+            return OS_ERROR_GENERIC;
+        }
+        left -= len;
+    }
+
+    if (fclose(f) != 0)
+    {
+        Debug_LOG_ERROR("fclose() failed for %s", path);
+        return OS_ERROR_GENERIC;
+    }
+
+    self->result->blobSize += size;
+    *blobIndex = self->blobCount++;
+
+    return OS_SUCCESS;
+}
+
+static
+OS_Error_t
+ConfigToolBench_GeneratorWriteParam(
+    ConfigToolBench_Generator_t* self,
+    FILE* f,
+    uint32_t index,
+    ConfigToolBench_ParamType_t type)
+{
+    fputs("<param_name>", f);
+    ConfigToolBench_GeneratorWriteName(self, f, "Param-", index,
+                                       OS_CONFIG_LIB_PARAMETER_NAME_SIZE - 1);
+    fprintf(f, "</param_name><type>%s</type><access_policy><component id=\"1\">"
+            "<read>true</read><write>%s</write></component></access_policy>"
+            "<value>", typeNames[type],
+            (ConfigToolBench_GeneratorNext(self) & 1) ? "true" : "false");
+
+    switch (type)
+    {
+    case CONFIG_TOOL_BENCH_TYPE_INT32:
+        fprintf(f, "%" PRIu32, ConfigToolBench_GeneratorNext(self));
+        break;
+    case CONFIG_TOOL_BENCH_TYPE_INT64:
+        fprintf(f, "%" PRIu64, ConfigToolBench_GeneratorRange(self, 0,
+                                                               UINT64_MAX - 1));
+        break;
+    case CONFIG_TOOL_BENCH_TYPE_STRING:
+        ConfigToolBench_GeneratorWriteString(self, f);
+        break;
+    case CONFIG_TOOL_BENCH_TYPE_BLOB:
+    {
+        uint32_t blobIndex;
+        OS_Error_t err = ConfigToolBench_GeneratorWriteBlob(self, &blobIndex);
+        if (err != OS_SUCCESS)
+        {
+            return err;
+        }
+        // Blob paths are appended to the directory of the XML file
+        fprintf(f, "/blob-%" PRIu32 ".bin", blobIndex);
+        break;
+    }
+    default:
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    fputs("</value>\n", f);
+    self->result->typeCounts[type]++;
+
+    return OS_SUCCESS;
+}
+
+static
+OS_Error_t
+ConfigToolBench_GeneratorWriteXml(
+    ConfigToolBench_Generator_t* self,
+    FILE* f,
+    uint32_t totalWeight)
+{
+    const ConfigToolBench_GeneratorConfig_t* cfg = self->cfg;
+    uint32_t index = 0;
+
+    fputs("<?xml version=\"1.0\"?>\n<config>\n", f);
+
+    for (uint32_t domain = 0; domain < cfg->domainCount; domain++)
+    {
+        uint32_t end = (uint32_t)(((uint64_t)cfg->paramCount * (domain + 1))
+                                  / cfg->domainCount);
+
+        fputs("<domain name=\"", f);
+        ConfigToolBench_GeneratorWriteName(self, f, "Domain-", domain,
+                                           OS_CONFIG_LIB_DOMAIN_NAME_SIZE - 1);
+        fputs("\">\n", f);
+
+        for (; index < end; index++)
+        {
+            ConfigToolBench_ParamType_t type =
+                ConfigToolBench_GeneratorPickType(self, totalWeight);
+
+            OS_Error_t err = ConfigToolBench_GeneratorWriteParam(self, f, index,
+                                                                 type);
+            if (err != OS_SUCCESS)
+            {
+                return err;
+            }
+        }
+
+        fputs("</domain>\n", f);
+    }
+
+    fputs("</config>\n", f);
+
+    return OS_SUCCESS;
+}
+
+
+/* Exported functions --------------------------------------------------------*/
+OS_Error_t
+ConfigToolBench_Generate(
+    const ConfigToolBench_GeneratorConfig_t* cfg,
+    const char* dirPath,
+    ConfigToolBench_GeneratorResult_t* result)
+{
+    uint32_t totalWeight = 0;
+
+    for (size_t i = 0; i < CONFIG_TOOL_BENCH_TYPE_COUNT; i++)
+    {
+        if (cfg->typeWeights[i] > (UINT32_MAX - totalWeight))
+        {
+            return OS_ERROR_INVALID_PARAMETER;
+        }
+        totalWeight += cfg->typeWeights[i];
+    }
+
+    if ((cfg->domainCount == 0) || (cfg->paramCount < cfg->domainCount)
+        || (totalWeight == 0)
+        || ((cfg->typeWeights[CONFIG_TOOL_BENCH_TYPE_BLOB] > 0)
+            && ((cfg->maxBlobSize == 0)
+                || (cfg->maxBlobSize > CONFIG_TOOL_BENCH_MAX_BLOB_SIZE))))
+    {
+        Debug_LOG_ERROR("Invalid shape of the configuration");
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    char path[PATH_MAX];
+    if (snprintf(path, sizeof(path), "%s/%s", dirPath,
+                 CONFIG_TOOL_BENCH_XML_FILE) >= (int)sizeof(path))
+    {
+        Debug_LOG_ERROR("XML path too long in %s", dirPath);
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    FILE* f = fopen(path, "w");
+    if (f == NULL)
+    {
+        Debug_LOG_ERROR("fopen() failed for %s", path);
+        return OS_ERROR_GENERIC;
+    }
+
+    memset(result, 0, sizeof(*result));
+
+    // A xorshift state must never be 0
+    ConfigToolBench_Generator_t self =
+    {
+        .cfg = cfg,
+        .dirPath = dirPath,
+        .random = (cfg->seed != 0) ? cfg->seed : 1,
+        .blobCount = 0,
+        .result = result,
+    };
+
+    OS_Error_t err = ConfigToolBench_GeneratorWriteXml(&self, f, totalWeight);
+
+    if (err == OS_SUCCESS)
+    {
+        long size = ftell(f);
+        result->xmlSize = (size > 0) ? (uint64_t)size : 0;
+    }
+
+    if (((ferror(f) != 0) | (fclose(f) != 0)) && (err == OS_SUCCESS))
+    {
+        Debug_LOG_ERROR("Writing %s failed", path);
+        err = OS_ERROR_GENERIC;
+    }
+
+    return err;
+}
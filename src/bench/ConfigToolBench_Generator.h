@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @file
+ * @brief Generator of synthetic configurations for the benchmark.
+ *
+ * A configuration is written as an XML file together with one blob file per
+ * blob parameter into a directory. Names, values and blob contents are drawn
+ * from a pseudo random sequence, so the same seed always yields the same
+ * configuration. Names and string values reach the maximum lengths of the
+ * configuration library.
+ *
+ * @ingroup ConfigProvisioningTool
+ */
+#pragma once
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <stdint.h>
+
+#include "OS_Error.h"
+
+
+/* Defines -------------------------------------------------------------------*/
+// Name of the XML file in the directory of the configuration
+#define CONFIG_TOOL_BENCH_XML_FILE "config.xml"
+
+// Largest blob size that can be generated
+#define CONFIG_TOOL_BENCH_MAX_BLOB_SIZE ((size_t)(16 * 1024 * 1024))
+
+
+/* Exported types/enums ------------------------------------------------------*/
+/**
+ * @brief Types of the generated parameters.
+ */
+typedef enum
+{
+    CONFIG_TOOL_BENCH_TYPE_INT32,
+    CONFIG_TOOL_BENCH_TYPE_INT64,
+    CONFIG_TOOL_BENCH_TYPE_STRING,
+    CONFIG_TOOL_BENCH_TYPE_BLOB,
+    CONFIG_TOOL_BENCH_TYPE_COUNT
+} ConfigToolBench_ParamType_t;
+
+/**
+ * @brief Shape of a generated configuration.
+ */
+typedef struct
+{
+    uint32_t domainCount;  /**< number of domains */
+    uint32_t paramCount;   /**< number of parameters, spread evenly over the
+                                domains */
+    uint32_t typeWeights[CONFIG_TOOL_BENCH_TYPE_COUNT]; /**< relative share of
+                                                             each type */
+    size_t maxBlobSize;    /**< blob sizes are drawn from 1 to this size */
+    uint32_t seed;         /**< seed of the pseudo random sequence */
+} ConfigToolBench_GeneratorConfig_t;
+
+/**
+ * @brief Summary of a generated configuration.
+ */
+typedef struct
+{
+    uint32_t typeCounts[CONFIG_TOOL_BENCH_TYPE_COUNT]; /**< parameters of
+                                                            each type */
+    uint64_t xmlSize;  /**< size of the XML file in bytes */
+    uint64_t blobSize; /**< size of all blob files in bytes */
+} ConfigToolBench_GeneratorResult_t;
+
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief Writes a configuration of the passed shape to the directory, which
+ * has to exist.
+ *
+ * @retval OS_SUCCESS - if the configuration was written
+ * @retval OS_ERROR_INVALID_PARAMETER - if the shape is invalid
+ * @retval OS_ERROR_GENERIC - if a file could not be written
+ */
+OS_Error_t
+ConfigToolBench_Generate(
+    const ConfigToolBench_GeneratorConfig_t* cfg, //!< [in] Shape of the
+                                                  //!<      configuration
+    const char* dirPath,                          //!< [in] Directory to write
+                                                  //!<      the files to
+    ConfigToolBench_GeneratorResult_t* result     //!< [out] Summary of the
+                                                  //!<       configuration
+);
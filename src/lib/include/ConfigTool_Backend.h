@@ -16,6 +16,7 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "ConfigTool_Util.h"
+#include "ConfigTool_ConfigService.h"
 #include "ConfigTool_HostFs.h"
 #include "ConfigTool_HostFsFile.h"
 
@@ -23,9 +24,86 @@
 #include "lib_host/HostStorage.h"
 
 
+/* Defines -------------------------------------------------------------------*/
+// Size of a partition image unless another one is requested
+#define CONFIG_TOOL_BACKEND_DEFAULT_IMAGE_SIZE  ((size_t)(128 * 1024))
+
+// Image size selecting the smallest image fitting the configuration, plus a
+// safety margin
+#define CONFIG_TOOL_BACKEND_IMAGE_SIZE_AUTO     0
+
+
+/* Exported types/enums ------------------------------------------------------*/
+/**
+ * @brief Configuration of a filesystem backend.
+ */
+typedef struct
+{
+    OS_FileSystem_Type_t fsType;         /**< filesystem type of the image,
+                                              none for plain host files */
+    ConfigTool_HostFs_Mode_t hostFsMode; /**< access mode of the host files */
+    size_t imageSize;                    /**< size of the partition image */
+    const char* templateCacheDir;        /**< absolute directory of the
+                                              blank image templates, NULL to
+                                              always format the image */
+    bool writeIndex;                     /**< also write the parameter name
+                                              index INDEX.BIN */
+    const char* hostDir;                 /**< directory of the host files,
+                                              NULL for the working directory */
+} ConfigTool_BackendConfig_t;
+
+/**
+ * @brief Instance of a filesystem backend.
+ *
+ * Several instances can be used in one process. Note that all image
+ * filesystems share the single HostStorage of lib_host though.
+ */
+typedef struct
+{
+    OS_FileSystem_Config_t cfgFs; /**< configuration of the filesystem */
+    OS_FileSystem_Handle_t hFs;   /**< handle of the initialized filesystem */
+} ConfigTool_Backend_t;
+
+
 /* Exported functions --------------------------------------------------------*/
 /**
- * @brief Initializes the filesystem backend.
+ * @brief Calculates the smallest partition image the backend files of the
+ * passed counts fit into when formatted with the passed filesystem type,
+ * together with the parameter name index if requested. The size is a
+ * multiple of the block size of all filesystem types.
+ *
+ * @return the image size in bytes, 0 if the filesystem type has no image
+ */
+uint64_t
+ConfigTool_BackendGetMinImageSize(
+    OS_FileSystem_Type_t fsType,                      //!< [in] Filesystem type
+    const ConfigTool_ConfigServiceCounter_t* counter, //!< [in] Record counts
+    bool hasIndex                                     //!< [in] INDEX.BIN is
+                                                      //!<      written as well
+);
+
+/**
+ * @brief Calculates the image size selected by
+ * CONFIG_TOOL_BACKEND_IMAGE_SIZE_AUTO, the smallest image plus a safety
+ * margin against the approximations of the filesystem overhead.
+ *
+ * @return the image size in bytes, 0 if the filesystem type has no image
+ */
+uint64_t
+ConfigTool_BackendGetAutoImageSize(
+    OS_FileSystem_Type_t fsType,                      //!< [in] Filesystem type
+    const ConfigTool_ConfigServiceCounter_t* counter, //!< [in] Record counts
+    bool hasIndex                                     //!< [in] INDEX.BIN is
+                                                      //!<      written as well
+);
+
+/**
+ * @brief Initializes the filesystem backend. Without a filesystem type the
+ * backend files are written to the host, in mapped mode they are flushed
+ * with msync() when the backend is deinitialized. Otherwise a partition
+ * image of exactly the configured size is formatted, which has to be a
+ * multiple of 4 KiB no larger than HOSTSTORAGE_SIZE. With a template cache
+ * the image is cloned from a cached blank image if there is one.
  *
  * @return an error code
  * @retval OS_SUCCESS - if the backend was initilazed successfully
@@ -34,8 +112,43 @@
  */
 OS_Error_t
 ConfigTool_BackendInit(
-    OS_FileSystem_Handle_t* hFs, //!< [in] Pointer to a filesystem handle
-    OS_FileSystem_Type_t fsType  //!< [in] Filesystem type
+    ConfigTool_Backend_t* self,           //!< [out] Backend instance to initialize
+    const ConfigTool_BackendConfig_t* cfg //!< [in] Backend configuration
+);
+
+/**
+ * @brief Initializes the filesystem backend on the existing partition image
+ * or host files instead of new ones. The image is
+ * mounted as is, its size has to be configured.
+ *
+ * @return an error code
+ * @retval OS_SUCCESS - if the backend was opened successfully
+ * @retval OS_ERROR_INVALID_PARAMETER - if an invalid parameter was passed
+ * @retval OS_ERROR_GENERIC - if the image could not be mounted
+ */
+OS_Error_t
+ConfigTool_BackendOpen(
+    ConfigTool_Backend_t* self,           //!< [out] Backend instance to initialize
+    const ConfigTool_BackendConfig_t* cfg //!< [in] Backend configuration
+);
+
+/**
+ * @brief Sizes the backend files for the passed counts before the records
+ * are written. Mapped host files are then extended and mapped once at their
+ * final size instead of growing while they are written. For all other
+ * backends nothing is done.
+ *
+ * @return an error code
+ * @retval OS_SUCCESS - if the files were sized successfully
+ * @retval OS_ERROR_GENERIC - if a file could not be created
+ * @retval OS_ERROR_ABORTED - if a file could not be extended or mapped
+ */
+OS_Error_t
+ConfigTool_BackendReserveFiles(
+    ConfigTool_Backend_t* self,                       //!< [in] Backend instance
+    const ConfigTool_ConfigServiceCounter_t* counter, //!< [in] Record counts
+    bool hasIndex                                     //!< [in] INDEX.BIN is
+                                                      //!<      written as well
 );
 
 /**
@@ -48,5 +161,5 @@ ConfigTool_BackendInit(
  */
 OS_Error_t
 ConfigTool_BackendDeInit(
-    OS_FileSystem_Handle_t hFs //!< [in] Filesystem handle
+    ConfigTool_Backend_t* self //!< [in] Backend instance
 );
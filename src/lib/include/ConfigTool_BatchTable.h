@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @file
+ * @brief Table of per-device overrides for batch provisioning.
+ *
+ * The table is a CSV file, if its name ends with ".csv", and a TSV file
+ * otherwise. The first row is the header. The first column holds the output
+ * of a device, every other column a parameter named "<domain>.<parameter>".
+ * CSV fields may be enclosed in double quotes to contain commas, line breaks
+ * or double quotes, which are doubled then.
+ *
+ * @ingroup ConfigProvisioningTool
+ */
+#pragma once
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+
+#include "OS_Error.h"
+
+
+/* Exported types/enums ------------------------------------------------------*/
+/**
+ * @brief Parsed table, the cells are NUL terminated in the file content.
+ */
+typedef struct
+{
+    char* data;      /**< content of the file */
+    char** cells;    /**< cells row by row, starting with the header */
+    size_t columns;  /**< number of columns */
+    size_t rows;     /**< number of rows without the header */
+} ConfigTool_BatchTable_t;
+
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief Reads and parses the table file.
+ *
+ * @retval OS_SUCCESS - if the table was loaded successfully
+ * @retval OS_ERROR_GENERIC - if the file could not be read
+ * @retval OS_ERROR_INVALID_PARAMETER - if the table is malformed
+ * @retval OS_ERROR_INSUFFICIENT_SPACE - if the memory allocation failed
+ */
+OS_Error_t
+ConfigTool_BatchTableLoad(
+    ConfigTool_BatchTable_t* self, //!< [out] Table to initialize
+    const char* path               //!< [in] Path to the table file
+);
+
+/**
+ * @brief Returns a cell of the header.
+ */
+const char*
+ConfigTool_BatchTableGetHeader(
+    const ConfigTool_BatchTable_t* self, //!< [in] Table holding the header
+    size_t column                        //!< [in] Column of the cell
+);
+
+/**
+ * @brief Returns a cell of a row following the header.
+ */
+const char*
+ConfigTool_BatchTableGetCell(
+    const ConfigTool_BatchTable_t* self, //!< [in] Table holding the row
+    size_t row,                          //!< [in] Row of the cell
+    size_t column                        //!< [in] Column of the cell
+);
+
+/**
+ * @brief Frees all resources held by the table.
+ */
+void
+ConfigTool_BatchTableFree(
+    ConfigTool_BatchTable_t* self //!< [in] Table to free
+);
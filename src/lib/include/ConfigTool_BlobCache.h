@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @file
+ * @brief Cache of the blob files referenced by a configuration.
+ *
+ * Each file is mapped once on its first use, keyed by its resolved path. Later
+ * uses of the same file, e.g. when writing the records, are served from the
+ * cache without touching the file again. Files are also deduplicated by their
+ * content, all files with equal content share the entry of the first one, so
+ * the content is stored only once.
+ *
+ * @ingroup ConfigProvisioningTool
+ */
+#pragma once
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "OS_Error.h"
+#include "ConfigTool_BlobSource.h"
+#include "ConfigTool_Util.h"
+
+
+/* Exported types/enums ------------------------------------------------------*/
+/**
+ * @brief A cached blob file.
+ */
+typedef struct
+{
+    char* path;     /**< resolved path of the blob file */
+    uint64_t hash;  /**< hash of the resolved path */
+    ConfigTool_BlobSource_t source; /**< content of the blob file, closed if
+                                         the content is held by another entry */
+    size_t size;    /**< size of the blob value, the content plus a zero byte */
+    uint64_t contentHash;  /**< hash of the content */
+    uint32_t contentEntry; /**< index of the entry holding the content */
+    struct timespec mtime; /**< modification time of the file when loaded */
+} ConfigTool_BlobCacheEntry_t;
+
+/**
+ * @brief Cache of blob files.
+ */
+typedef struct
+{
+    ConfigTool_BlobCacheEntry_t* entries;    /**< cached files in load order */
+    uint32_t count;                          /**< number of cached files */
+    uint32_t capacity;                       /**< allocated entries */
+    ConfigTool_UtilHashTable_t table;        /**< hash table of the paths */
+    ConfigTool_UtilHashTable_t contentTable; /**< hash table of the entries
+                                                  holding content */
+} ConfigTool_BlobCache_t;
+
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief Initializes an empty blob cache.
+ */
+void
+ConfigTool_BlobCacheInit(
+    ConfigTool_BlobCache_t* self //!< [out] Cache to initialize
+);
+
+/**
+ * @brief Frees all cached blobs.
+ */
+void
+ConfigTool_BlobCacheFree(
+    ConfigTool_BlobCache_t* self //!< [in] Cache to free
+);
+
+/**
+ * @brief Returns the cache entry holding the content of the passed file,
+ * mapping the file if it is not cached yet. Files with equal content share the
+ * same entry.
+ *
+ * @retval OS_SUCCESS - if the entry index was returned
+ * @retval OS_ERROR_GENERIC - if the file could not be mapped
+ * @retval OS_ERROR_INSUFFICIENT_SPACE - if the memory allocation failed
+ */
+OS_Error_t
+ConfigTool_BlobCacheLoad(
+    ConfigTool_BlobCache_t* self, //!< [in] Cache to look up the file in
+    const char* filePath,         //!< [in] Path to the blob file
+    uint32_t* entryIndex,         //!< [out] Index of the cache entry
+    bool* isNewContent            //!< [out] true if the content was not in the
+                                  //!<       cache before
+);
+
+/**
+ * @brief Returns a cache entry by its index.
+ *
+ * @return pointer to the entry, valid until the next call to
+ * ConfigTool_BlobCacheLoad()
+ */
+const ConfigTool_BlobCacheEntry_t*
+ConfigTool_BlobCacheGetEntry(
+    const ConfigTool_BlobCache_t* self, //!< [in] Cache holding the entry
+    uint32_t entryIndex                 //!< [in] Index of the entry
+);
+
+/**
+ * @brief Checks whether any cached file was modified, replaced or removed
+ * since it was loaded, by its modification time and size. The content of such
+ * a file is stale, a streamed one would even be read with its old length.
+ *
+ * @return true if any cached file changed
+ */
+bool
+ConfigTool_BlobCacheIsModified(
+    const ConfigTool_BlobCache_t* self //!< [in] Cache to check
+);
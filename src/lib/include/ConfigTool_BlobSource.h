@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @file
+ * @brief Read-only, binary-safe access to the content of a blob file.
+ *
+ * The length of a file is taken from its status, so blobs may contain zero
+ * bytes. Files up to CONFIG_TOOL_BLOB_SOURCE_MAP_LIMIT are mapped into memory
+ * and never copied. Larger files are streamed, i.e. they stay open and are
+ * read piece by piece on demand, so their size is not bound by the available
+ * memory.
+ *
+ * @ingroup ConfigProvisioningTool
+ */
+#pragma once
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "OS_Error.h"
+
+
+/* Defines -------------------------------------------------------------------*/
+#ifndef CONFIG_TOOL_BLOB_SOURCE_MAP_LIMIT
+// Files larger than this are streamed instead of mapped
+#define CONFIG_TOOL_BLOB_SOURCE_MAP_LIMIT   (64 * 1024 * 1024)
+#endif
+
+/* Exported types/enums ------------------------------------------------------*/
+/**
+ * @brief Content of a blob file.
+ */
+typedef struct
+{
+    const void* data; /**< read-only mapping of the file, NULL if empty or
+                           streamed */
+    size_t length;    /**< length of the file content */
+    int fd;           /**< open file of a streamed source, -1 otherwise */
+    struct timespec mtime; /**< modification time of the file when opened */
+} ConfigTool_BlobSource_t;
+
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief Maps the content of the passed file.
+ *
+ * @retval OS_SUCCESS - if the file was mapped successfully
+ * @retval OS_ERROR_GENERIC - if the file could not be opened or mapped
+ */
+OS_Error_t
+ConfigTool_BlobSourceOpen(
+    ConfigTool_BlobSource_t* self, //!< [out] Blob source to initialize
+    const char* filePath           //!< [in] Path to the blob file
+);
+
+/**
+ * @brief Copies a part of the file content into the passed buffer.
+ *
+ * Works for mapped and streamed sources alike.
+ *
+ * @retval OS_SUCCESS - if all requested bytes were copied
+ * @retval OS_ERROR_INVALID_PARAMETER - if the range exceeds the file content
+ * @retval OS_ERROR_GENERIC - if the file could not be read
+ */
+OS_Error_t
+ConfigTool_BlobSourceRead(
+    const ConfigTool_BlobSource_t* self, //!< [in] Blob source to read from
+    size_t offset,                       //!< [in] Offset in the file content
+    void* buffer,                        //!< [out] Buffer to copy to
+    size_t length                        //!< [in] Number of bytes to copy
+);
+
+/**
+ * @brief Calculates the hash of the file content.
+ *
+ * @retval OS_SUCCESS - if the hash was calculated
+ * @retval OS_ERROR_GENERIC - if the file could not be read
+ */
+OS_Error_t
+ConfigTool_BlobSourceHash(
+    const ConfigTool_BlobSource_t* self, //!< [in] Blob source to hash
+    uint64_t* hash                       //!< [out] Hash of the content
+);
+
+/**
+ * @brief Compares the content of two blob sources byte by byte.
+ *
+ * @retval OS_SUCCESS - if the comparison was done
+ * @retval OS_ERROR_GENERIC - if a file could not be read
+ */
+OS_Error_t
+ConfigTool_BlobSourceEqual(
+    const ConfigTool_BlobSource_t* self,  //!< [in] Blob source to compare
+    const ConfigTool_BlobSource_t* other, //!< [in] Blob source to compare with
+    bool* isEqual                         //!< [out] true if the content is equal
+);
+
+/**
+ * @brief Returns whether the content is streamed instead of mapped.
+ */
+bool
+ConfigTool_BlobSourceIsStreamed(
+    const ConfigTool_BlobSource_t* self //!< [in] Blob source
+);
+
+/**
+ * @brief Unmaps or closes the file.
+ */
+void
+ConfigTool_BlobSourceClose(
+    ConfigTool_BlobSource_t* self //!< [in] Blob source to close
+);
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @file
+ * @brief Decodes the records of existing backend files back into an XML
+ * configuration.
+ *
+ * The XML file is canonical: every domain lists its parameters in record
+ * order, integers are written in decimal and access rights as read and write
+ * settings. Blob values are written to files next to the XML file, one per
+ * distinct blob, which the XML file refers to like any other configuration.
+ * Building the XML file again yields the same records.
+ *
+ * @ingroup ConfigProvisioningTool
+ */
+#pragma once
+
+/* Includes ------------------------------------------------------------------*/
+#include "ConfigTool_ConfigReader.h"
+
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief Writes the configuration held by the passed records to an XML file.
+ *
+ * @retval OS_SUCCESS - if the XML file and the blob files were written
+ * @retval OS_ERROR_INVALID_STATE - if a record refers to an invalid domain,
+ * string or blob, or a string cannot be represented in XML
+ * @retval OS_ERROR_INSUFFICIENT_SPACE - if the memory allocation failed
+ * @retval OS_ERROR_GENERIC - if a file could not be written
+ */
+OS_Error_t
+ConfigTool_ConfigDumperRun(
+    const ConfigTool_ConfigReader_t* reader, //!< [in] Records to decode
+    const char* xmlPath                      //!< [in] Path of the XML file
+);
@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @file
+ * @brief Intermediate representation of a parsed configuration.
+ *
+ * The input front ends fill the model once, the output stage then walks the
+ * flat domain and parameter arrays. The element counters required to size the
+ * configuration backends are kept up to date while the model is filled.
+ *
+ * @ingroup ConfigProvisioningTool
+ */
+#pragma once
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ConfigTool_ConfigService.h"
+#include "ConfigTool_BlobCache.h"
+#include "ConfigTool_StringPool.h"
+
+
+/* Exported types/enums ------------------------------------------------------*/
+/**
+ * @brief A domain of the configuration.
+ */
+typedef struct
+{
+    char name[OS_CONFIG_LIB_DOMAIN_NAME_SIZE]; /**< name of the domain */
+} ConfigTool_ConfigModelDomain_t;
+
+/**
+ * @brief A parameter of the configuration.
+ */
+typedef struct
+{
+    ConfigTool_ConfigServiceParamType_t type;  /**< type of the parameter */
+    uint32_t domainIndex;                      /**< index of the owning domain */
+    char name[OS_CONFIG_LIB_PARAMETER_NAME_SIZE]; /**< name of the parameter */
+    bool hasReadAccess;                        /**< read access is granted */
+    bool hasWriteAccess;                       /**< write access is granted */
+    size_t valueOffset;    /**< offset of the value text in the value buffer */
+    size_t valueLength;    /**< length of the value text without terminator */
+    size_t blobSize;       /**< size of the blob value (blobs only) */
+    uint32_t numberOfBlocks; /**< blocks required by the blob (blobs only) */
+    uint32_t blobEntry;    /**< blob cache entry holding the value, shared by
+                                all blobs with equal content (blobs only) */
+    uint32_t stringEntry;  /**< string pool entry of the value, which is the
+                                index of its STRING.BIN record (strings only) */
+} ConfigTool_ConfigModelParam_t;
+
+/**
+ * @brief Flat representation of a configuration.
+ */
+typedef struct
+{
+    ConfigTool_ConfigModelDomain_t* domains; /**< domains in document order */
+    size_t domainCapacity;                   /**< allocated domain entries */
+    ConfigTool_ConfigModelParam_t* params;   /**< parameters in document order */
+    size_t paramCapacity;                    /**< allocated parameter entries */
+    char* values;                            /**< NUL separated value texts */
+    size_t valuesSize;                       /**< used bytes of the value buffer */
+    size_t valuesCapacity;                   /**< allocated bytes of the value buffer */
+    char* dirPath;        /**< directory the blob values are relative to */
+    ConfigTool_BlobCache_t blobCache; /**< content of the referenced blob files */
+    ConfigTool_StringPool_t stringPool; /**< unique string values */
+    ConfigTool_ConfigServiceCounter_t counter; /**< element counts of the model */
+    bool isClustered;     /**< parameters are ordered by domain and name */
+} ConfigTool_ConfigModel_t;
+
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief Initializes an empty configuration model.
+ *
+ * @retval OS_SUCCESS - if the model was initialized successfully
+ * @retval OS_ERROR_INSUFFICIENT_SPACE - if the memory allocation failed
+ */
+OS_Error_t
+ConfigTool_ConfigModelInit(
+    ConfigTool_ConfigModel_t* self, //!< [out] Model to initialize
+    const char* dirPath             /*!< [in] Directory path containing the
+                                              files referenced by blob values */
+);
+
+/**
+ * @brief Frees all resources held by the configuration model.
+ */
+void
+ConfigTool_ConfigModelFree(
+    ConfigTool_ConfigModel_t* self //!< [in] Model to free
+);
+
+/**
+ * @brief Appends a domain to the model. All parameters added afterwards belong
+ * to this domain.
+ *
+ * @retval OS_SUCCESS - if the domain was added successfully
+ * @retval OS_ERROR_INSUFFICIENT_SPACE - if the memory allocation failed
+ */
+OS_Error_t
+ConfigTool_ConfigModelAddDomain(
+    ConfigTool_ConfigModel_t* self, //!< [in] Model to add the domain to
+    const char* name                //!< [in] Name of the domain
+);
+
+/**
+ * @brief Appends a parameter to the most recently added domain. For blob
+ * parameters the value is the path of the file holding the blob, relative to
+ * the directory path of the model.
+ *
+ * @retval OS_SUCCESS - if the parameter was added successfully
+ * @retval OS_ERROR_INVALID_PARAMETER - if the parameter type is not supported
+ *                                      or no domain was added yet
+ * @retval OS_ERROR_GENERIC - if the blob file could not be read
+ * @retval OS_ERROR_INSUFFICIENT_SPACE - if the memory allocation failed
+ */
+OS_Error_t
+ConfigTool_ConfigModelAddParam(
+    ConfigTool_ConfigModel_t* self,           //!< [in] Model to add the parameter to
+    ConfigTool_ConfigServiceParamType_t type, //!< [in] Type of the parameter
+    const char* name,                         //!< [in] Name of the parameter
+    bool hasReadAccess,                       //!< [in] Read access is granted
+    bool hasWriteAccess,                      //!< [in] Write access is granted
+    const char* value                         //!< [in] Value text from the input
+);
+
+/**
+ * @brief Looks up a parameter by the names of its domain and itself.
+ *
+ * @retval OS_SUCCESS - if the parameter was found
+ * @retval OS_ERROR_NOT_FOUND - if there is no such parameter
+ */
+OS_Error_t
+ConfigTool_ConfigModelFindParam(
+    const ConfigTool_ConfigModel_t* self, //!< [in] Model to search
+    const char* domainName,               //!< [in] Name of the domain
+    const char* paramName,                //!< [in] Name of the parameter
+    uint32_t* paramIndex                  //!< [out] Index of the parameter
+);
+
+/**
+ * @brief Looks up a parameter by its qualified name "<domain>.<parameter>".
+ * Domain names may contain dots themselves, so every dot is tried as
+ * separator.
+ *
+ * @retval OS_SUCCESS - if the parameter was found
+ * @retval OS_ERROR_NOT_FOUND - if there is no such parameter
+ * @retval OS_ERROR_INSUFFICIENT_SPACE - if the memory allocation failed
+ */
+OS_Error_t
+ConfigTool_ConfigModelFindQualifiedParam(
+    const ConfigTool_ConfigModel_t* self, //!< [in] Model to search
+    const char* qualifiedName,            //!< [in] "<domain>.<parameter>"
+    uint32_t* paramIndex                  //!< [out] Index of the parameter
+);
+
+/**
+ * @brief Replaces the value text of a parameter. The blob file of a new blob
+ * value is loaded into the blob cache right away. Once all values are
+ * replaced, ConfigTool_ConfigModelRecount() has to be called before the model
+ * is written.
+ *
+ * @retval OS_SUCCESS - if the value was replaced successfully
+ * @retval OS_ERROR_INVALID_PARAMETER - if an integer value is invalid or out
+ *                                      of range
+ * @retval OS_ERROR_GENERIC - if the blob file could not be read
+ * @retval OS_ERROR_INSUFFICIENT_SPACE - if the memory allocation failed
+ */
+OS_Error_t
+ConfigTool_ConfigModelSetValue(
+    ConfigTool_ConfigModel_t* self, //!< [in] Model holding the parameter
+    uint32_t paramIndex,            //!< [in] Index of the parameter
+    const char* value               //!< [in] New value text
+);
+
+/**
+ * @brief Rebuilds the string pool and the record counts from the current
+ * values of all parameters, in the order of the parameters like the parser
+ * does.
+ *
+ * @retval OS_SUCCESS - if the model was recounted successfully
+ * @retval OS_ERROR_INSUFFICIENT_SPACE - if the memory allocation failed or the
+ * blob blocks exceed the addressable range
+ */
+OS_Error_t
+ConfigTool_ConfigModelRecount(
+    ConfigTool_ConfigModel_t* self //!< [in] Model to recount
+);
+
+/**
+ * @brief Orders the parameters by domain and, within a domain, bytewise by
+ * name, so the parameters of each domain form a contiguous range. Parameters
+ * of the same name keep their document order. The string pool and the record
+ * counts are rebuilt in the new order, parameter indices taken before are no
+ * longer valid.
+ *
+ * @retval OS_SUCCESS - if the parameters were ordered successfully
+ * @retval OS_ERROR_INSUFFICIENT_SPACE - if the memory allocation failed
+ */
+OS_Error_t
+ConfigTool_ConfigModelClusterDomains(
+    ConfigTool_ConfigModel_t* self //!< [in] Model to order
+);
+
+/**
+ * @brief Returns the index of the first parameter of a domain of a clustered
+ * model. The range of the domain ends where the one of the next domain
+ * starts, the last one ends with the last parameter.
+ *
+ * @return index of the first parameter, the number of parameters if neither
+ * the domain nor any following domain has parameters
+ */
+uint32_t
+ConfigTool_ConfigModelGetDomainStart(
+    const ConfigTool_ConfigModel_t* self, //!< [in] Clustered model
+    uint32_t domainIndex                  //!< [in] Index of the domain
+);
+
+/**
+ * @brief Returns the NUL terminated value text of a parameter.
+ *
+ * @return pointer to the value text, owned by the model
+ */
+const char*
+ConfigTool_ConfigModelGetValue(
+    const ConfigTool_ConfigModel_t* self,      //!< [in] Model holding the parameter
+    const ConfigTool_ConfigModelParam_t* param //!< [in] Parameter of the model
+);
+
+/**
+ * @brief Builds the path of the file holding the value of a blob parameter.
+ *
+ * @return dynamically allocated path that must be freed by the caller, NULL if
+ * the memory allocation failed
+ */
+char*
+ConfigTool_ConfigModelGetBlobPath(
+    const ConfigTool_ConfigModel_t* self,      //!< [in] Model holding the parameter
+    const ConfigTool_ConfigModelParam_t* param //!< [in] Blob parameter of the model
+);
+
+/**
+ * @brief Returns the cached content of a blob parameter. The blob file is read
+ * only once while the model is filled.
+ *
+ * @return pointer to the blob cache entry, owned by the model
+ */
+const ConfigTool_BlobCacheEntry_t*
+ConfigTool_ConfigModelGetBlob(
+    const ConfigTool_ConfigModel_t* self,      //!< [in] Model holding the parameter
+    const ConfigTool_ConfigModelParam_t* param //!< [in] Blob parameter of the model
+);
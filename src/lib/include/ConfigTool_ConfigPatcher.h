@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @file
+ * @brief Rewrites the values of single parameters in existing configuration
+ * library backends.
+ *
+ * Only the records of the patched parameters are rewritten. A string or blob
+ * record shared with another parameter and a blob growing beyond its blocks
+ * cannot be patched in place, the configuration has to be rebuilt then.
+ *
+ * @ingroup ConfigProvisioningTool
+ */
+#pragma once
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+
+#include "ConfigTool_ConfigService.h"
+
+
+/* Exported types/enums ------------------------------------------------------*/
+/**
+ * @brief New value of a parameter.
+ */
+typedef struct
+{
+    const char* name;  /**< parameter as "<domain>.<parameter>" */
+    const char* value; /**< value text, the file path for blobs */
+} ConfigTool_ConfigPatcherValue_t;
+
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief Rewrites the records of the passed parameters. Blob file paths are
+ * appended to the passed directory like the blob paths of an XML file.
+ *
+ * @param configLib [in] pointer to a configuration library instance that was
+ * opened on the existing backend files
+ * @param values [in] new values of the parameters
+ * @param valueCount [in] number of values
+ * @param blobDir [in] directory the blob file paths are relative to
+ * @retval OS_SUCCESS if all values were patched successfully
+ * @retval OS_ERROR_NOT_FOUND if a parameter does not exist
+ * @retval OS_ERROR_INVALID_PARAMETER if a value is invalid for its parameter
+ * @retval OS_ERROR_NOT_SUPPORTED if a value cannot be patched in place
+ * @retval OS_ERROR_GENERIC if reading or writing a record failed
+ */
+OS_Error_t
+ConfigTool_ConfigPatcherRun(
+    OS_ConfigServiceLib_t* configLib,
+    const ConfigTool_ConfigPatcherValue_t* values,
+    size_t valueCount,
+    const char* blobDir
+);
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @file
+ * @brief Read-only access to the records of existing backend files.
+ *
+ * The backend files are plain arrays of records. Host files are mapped as
+ * they are, the files of a partition image are read at once from a private
+ * copy of the image, so the image itself is never mounted. All records are
+ * then accessed in memory without further file access.
+ *
+ * @ingroup ConfigProvisioningTool
+ */
+#pragma once
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ConfigTool_ConfigService.h"
+
+
+/* Defines -------------------------------------------------------------------*/
+// Number of backend files written by the configuration library
+#define CONFIG_TOOL_CONFIG_READER_FILE_COUNT  4
+
+
+/* Exported types/enums ------------------------------------------------------*/
+/**
+ * @brief Records of the backend files of one configuration.
+ */
+typedef struct
+{
+    void* files[CONFIG_TOOL_CONFIG_READER_FILE_COUNT]; /**< content of each
+                                                            backend file */
+    size_t fileSizes[CONFIG_TOOL_CONFIG_READER_FILE_COUNT]; /**< size of each
+                                                                 backend file */
+    bool isMapped;  /**< files are mappings of host files, not allocated */
+    const OS_ConfigServiceLibTypes_Domain_t* domains; /**< DOMAIN.BIN records */
+    size_t domainCount;                               /**< number of domains */
+    const OS_ConfigServiceLibTypes_Parameter_t* params; /**< PARAM.BIN records */
+    size_t paramCount;                                /**< number of parameters */
+    const char* strings;  /**< STRING.BIN records */
+    size_t stringCount;   /**< number of string records */
+    const uint8_t* blobs; /**< BLOB.BIN records */
+    size_t blobCount;     /**< number of blob records */
+    void* indexFile;      /**< content of INDEX.BIN, NULL without index */
+    size_t indexSize;     /**< size of INDEX.BIN */
+} ConfigTool_ConfigReader_t;
+
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief Loads the backend files of a partition image or, without a
+ * filesystem type, of a directory of host files.
+ * The parameter name index INDEX.BIN is loaded too if it exists, it is not
+ * validated.
+ *
+ * @retval OS_SUCCESS - if all backend files were loaded
+ * @retval OS_ERROR_NOT_FOUND - if the image or a backend file does not exist
+ * @retval OS_ERROR_INVALID_STATE - if a backend file is no array of records
+ * @retval OS_ERROR_INSUFFICIENT_SPACE - if the memory allocation failed
+ * @retval OS_ERROR_GENERIC - if a file could not be read or the image could
+ * not be mounted
+ */
+OS_Error_t
+ConfigTool_ConfigReaderOpen(
+    ConfigTool_ConfigReader_t* self, //!< [out] Reader to initialize
+    OS_FileSystem_Type_t fsType,     //!< [in] Filesystem type of the image,
+                                     //!<      none for host files
+    const char* path                 //!< [in] Image file or directory of the
+                                     //!<      host files
+);
+
+/**
+ * @brief Returns the string value of a parameter record.
+ *
+ * @retval OS_SUCCESS - if the string was returned
+ * @retval OS_ERROR_INVALID_STATE - if the record refers to an invalid string
+ */
+OS_Error_t
+ConfigTool_ConfigReaderGetString(
+    const ConfigTool_ConfigReader_t* self,             //!< [in] Reader
+    const OS_ConfigServiceLibTypes_Parameter_t* param, //!< [in] String parameter
+    const char** str,                                  //!< [out] String record
+    size_t* length                                     //!< [out] Length without
+                                                       //!<       terminator
+);
+
+/**
+ * @brief Returns the blob value of a parameter record.
+ *
+ * @retval OS_SUCCESS - if the blob was returned
+ * @retval OS_ERROR_INVALID_STATE - if the record refers to invalid blocks
+ */
+OS_Error_t
+ConfigTool_ConfigReaderGetBlob(
+    const ConfigTool_ConfigReader_t* self,             //!< [in] Reader
+    const OS_ConfigServiceLibTypes_Parameter_t* param, //!< [in] Blob parameter
+    const void** data,                                 //!< [out] First block
+    size_t* length                                     //!< [out] Length without
+                                                       //!<       terminator
+);
+
+/**
+ * @brief Returns whether the passed access rights grant any access. Rights
+ * per component are not supported, so they are either all or nothing.
+ */
+bool
+ConfigTool_ConfigReaderHasAccess(
+    const OS_ConfigServiceAccessRights_t* rights //!< [in] Access rights
+);
+
+/**
+ * @brief Returns whether the records have the domain-clustered layout of
+ * ConfigTool_ConfigModelClusterDomains(). The layout is told by the domain
+ * enumerators, which hold the start of the parameter range of each domain.
+ * If they are all 0, the layout is clustered only if the parameters all
+ * belong to the last domain, which is then decided by their name order. Where
+ * both layouts yield the same records, they are reported as clustered.
+ */
+bool
+ConfigTool_ConfigReaderIsClustered(
+    const ConfigTool_ConfigReader_t* self //!< [in] Reader
+);
+
+/**
+ * @brief Unmaps or frees the backend files.
+ */
+void
+ConfigTool_ConfigReaderClose(
+    ConfigTool_ConfigReader_t* self //!< [in] Reader to close
+);
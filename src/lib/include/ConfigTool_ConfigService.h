@@ -21,6 +21,8 @@
  */
 
 /* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
 #include "OS_Error.h"
 #include "OS_ConfigService.h"
 
@@ -62,10 +64,10 @@ typedef struct
  */
 typedef struct
 {
-    unsigned int param_count;    /**< number of params present  */
-    unsigned int domain_count;   /**< number of domains present */
-    unsigned int string_count;   /**< number of strings present */
-    unsigned int blob_count;     /**< number of blobs present   */
+    uint32_t param_count;    /**< number of params present  */
+    uint32_t domain_count;   /**< number of domains present */
+    uint32_t string_count;   /**< number of strings present */
+    uint32_t blob_count;     /**< number of blobs present   */
 } ConfigTool_ConfigServiceCounter_t;
 
 
@@ -91,3 +93,19 @@ ConfigTool_ConfigServiceInit(
     OS_FileSystem_Handle_t hFs,
     ConfigTool_ConfigServiceCounter_t* configCounter
 );
+
+/**
+ * @brief Initializes the configuration service library on the backend files
+ * already present on the filesystem, e.g. to modify records of an existing
+ * configuration.
+ *
+ * @param configLib [out] pointer to the configuration library instance
+ * @param hFs [in] filesystem handle
+ * @retval OS_SUCCESS if the configuration backend was initilazed successfully
+ * @retval OS_ERROR_GENERIC if a backend file could not be opened
+ */
+OS_Error_t
+ConfigTool_ConfigServiceOpen(
+    OS_ConfigServiceLib_t* configLib,
+    OS_FileSystem_Handle_t hFs
+);
@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @file
+ * @brief Compares the records of existing backend files with a configuration
+ * model.
+ *
+ * Domains and parameters are compared record by record, in the order the
+ * writer produces them. String and blob values are compared by content, so
+ * the layout of STRING.BIN and BLOB.BIN, like the sharing of records, does
+ * not matter. If the records come with a parameter name index, every record
+ * has to be found through it. Every difference is reported on stdout.
+ *
+ * @ingroup ConfigProvisioningTool
+ */
+#pragma once
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+
+#include "ConfigTool_ConfigModel.h"
+#include "ConfigTool_ConfigReader.h"
+
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief Compares the passed records with the passed model.
+ *
+ * @retval OS_SUCCESS - if the comparison was done, the differences are counted
+ * @retval OS_ERROR_GENERIC - if a blob file of the model could not be read
+ */
+OS_Error_t
+ConfigTool_ConfigVerifierRun(
+    const ConfigTool_ConfigReader_t* reader, //!< [in] Records to verify
+    const ConfigTool_ConfigModel_t* model,   //!< [in] Expected configuration
+    size_t* mismatchCount                    //!< [out] Number of differences
+);
@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @file
+ * @brief Writes a parsed configuration model to the configuration library
+ * backends.
+ *
+ * @ingroup ConfigProvisioningTool
+ */
+#pragma once
+
+/* Includes ------------------------------------------------------------------*/
+#include "ConfigTool_ConfigService.h"
+#include "ConfigTool_ConfigModel.h"
+
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief Writes all domains and parameters of the model to the configuration
+ * library instance.
+ *
+ * @param configLib [in] pointer to a configuration library instance that was
+ * initialized with the counters of the model
+ * @param model [in] pointer to the configuration model to write
+ * @retval OS_SUCCESS if all records were written successfully
+ * @retval OS_ERROR_GENERIC if something went wrong during the writing process
+ */
+OS_Error_t
+ConfigTool_ConfigWriterRun(
+    OS_ConfigServiceLib_t* configLib,
+    const ConfigTool_ConfigModel_t* model
+);
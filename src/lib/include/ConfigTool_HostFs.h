@@ -16,6 +16,10 @@
 #pragma once
 
 /* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
 #include "OS_FileSystem.h"
 #include "OS_FileSystem_int.h"
 
@@ -24,6 +28,77 @@
  * @ingroup  ConfigProvisioningTool
  */
 
+/* Defines -------------------------------------------------------------------*/
+#ifndef CONFIG_TOOL_HOST_FS_WRITE_BUFFER_SIZE
+// Size of the per-handle buffer combining adjacent writes, 0 disables it
+#define CONFIG_TOOL_HOST_FS_WRITE_BUFFER_SIZE   (64 * 1024)
+#endif
+
+#ifndef CONFIG_TOOL_HOST_FS_MAX_MAPPED_FILES
+// The configuration library uses four backend files
+#define CONFIG_TOOL_HOST_FS_MAX_MAPPED_FILES    8
+#endif
+
+/* Exported types/enums ------------------------------------------------------*/
+/**
+ * @brief How the host filesystem accesses the files.
+ */
+typedef enum
+{
+    CONFIG_TOOL_HOST_FS_MODE_WRITE, /**< positional reads and writes */
+    CONFIG_TOOL_HOST_FS_MODE_MAP    /**< stores into memory mapped files */
+} ConfigTool_HostFs_Mode_t;
+
+/**
+ * @brief A memory mapped file of the host filesystem.
+ */
+typedef struct
+{
+    char* name;        /**< name of the file, NULL if the slot is unused */
+    int fd;            /**< host file descriptor */
+    uint8_t* data;     /**< mapping of the file */
+    size_t size;       /**< size of the file content */
+    size_t mappedSize; /**< size of the file and its mapping */
+} ConfigTool_HostFsMappedFile_t;
+
+/**
+ * @brief State of an open file of the host filesystem.
+ */
+typedef struct
+{
+    int fd;             /**< host file descriptor, -1 if the handle is unused */
+    char* name;         /**< name the file was opened with */
+    off_t size;         /**< size of the file including buffered writes */
+    uint8_t* buffer;    /**< data of adjacent writes not yet written */
+    off_t bufferOffset; /**< file offset of the buffered data */
+    size_t bufferLength; /**< length of the buffered data */
+    ConfigTool_HostFsMappedFile_t* mappedFile; /**< file of the handle in
+                                                    mapped mode */
+} ConfigTool_HostFsHandle_t;
+
+/**
+ * @brief Instance of the host filesystem. The generic filesystem object is the
+ * first member, so the handle passed to the file operations can be converted
+ * back to the instance holding the per-file state.
+ *
+ * The files are accessed with positional reads and writes on plain file
+ * descriptors, so different handles can be used from different threads. File
+ * names are relative to the directory of the instance, not to the working
+ * directory, so several instances can write to different directories.
+ */
+typedef struct
+{
+    OS_FileSystem_t fs;                          /**< generic filesystem object */
+    ConfigTool_HostFsHandle_t handle[MAX_FILE_HANDLES]; /**< state of the open
+                                                             handles */
+    ConfigTool_HostFs_Mode_t mode;               /**< access mode of the files */
+    int dirFd;                                   /**< directory of the files,
+                                                      AT_FDCWD for the working
+                                                      directory */
+    ConfigTool_HostFsMappedFile_t mappedFile[CONFIG_TOOL_HOST_FS_MAX_MAPPED_FILES];
+    /**< files mapped in mapped mode */
+} ConfigTool_HostFs_t;
+
 /* Public functions ----------------------------------------------------------*/
 /**
  * @brief Initializes the filesystem handle with the host filesystem file
@@ -32,15 +107,20 @@
  * @retval OS_SUCCESS - if the filesystem handle was initilazed successfully
  * @retval OS_ERROR_INSUFFICIENT_SPACE - if the memory allocation for the
  * filesystem handle fails
+ * @retval OS_ERROR_GENERIC - if the directory could not be opened
  */
 OS_Error_t
 ConfigTool_HostFsInit(
-    OS_FileSystem_Handle_t*       self, //!< [out] Pointer to a filesystem handle
-    const OS_FileSystem_Config_t* cfg   //!< [in] Pointer to a filesystem config
+    OS_FileSystem_Handle_t*       self,   //!< [out] Pointer to a filesystem handle
+    const OS_FileSystem_Config_t* cfg,    //!< [in] Pointer to a filesystem config
+    ConfigTool_HostFs_Mode_t      mode,   //!< [in] Access mode of the files
+    const char*                   dirPath //!< [in] Directory of the files, NULL
+                                          //!<      for the working directory
 );
 
 /**
- * @brief Frees the passed filesystem handle.
+ * @brief Frees the passed filesystem handle. In mapped mode the files are
+ * flushed with msync() and cut to their final size.
  *
  * @retval OS_SUCCESS - if the filesystem handle was freed successfully
  * @retval OS_ERROR_INVALID_PARAMETER - if an empty handle was passed
@@ -42,6 +42,7 @@ ConfigTool_HostFsFileOpen(
  *
  * @retval OS_SUCCESS - if the requested file was closed successfully
  * @retval OS_ERROR_GENERIC - if the file could not be closed successfully
+ * @retval OS_ERROR_ABORTED - if writing the buffered data failed
  */
 OS_Error_t
 ConfigTool_HostFsFileClose(
@@ -67,7 +68,9 @@ ConfigTool_HostFsFileRead(
 
 /**
  * @brief Writes the requested length from the passed buffer into the file
- * assigned to the file handle.
+ * assigned to the file handle. Adjacent small writes are combined in a buffer
+ * of the handle, which is written to the file when a non-adjacent write,
+ * a read or closing the file requires it.
  *
  * @retval OS_SUCCESS - if write operation succeeded
  * @retval OS_ERROR_ABORTED - if the write operation failed
@@ -96,10 +99,8 @@ ConfigTool_HostFsFileDelete(
 /**
  * @brief Returns the size of the file identified by the passed file name.
  *
- * @retval OS_SUCCESS - if the requested file was opened successfully
- * @retval OS_ERROR_GENERIC - if the file could not be opened or closed
- * successfully
- * @retval OS_ERROR_ABORTED - if adjusting the offset failed
+ * @retval OS_SUCCESS - if the size was returned successfully
+ * @retval OS_ERROR_GENERIC - if the file status could not be retrieved
  */
 OS_Error_t
 ConfigTool_HostFsFileGetSize(
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @file
+ * @brief Memory mapped file operations of the host FileSystem.
+ *
+ * Each file is mapped once on its first use and stays mapped until the
+ * filesystem is freed, so the records written by the configuration library
+ * become plain stores into the mapping. A file reserved ahead is extended and
+ * mapped once at its final size, other files grow in large steps as needed.
+ * Every file is cut to its content size when it is unmapped.
+ *
+ * @ingroup ConfigTool_HostFs
+ *
+ */
+#pragma once
+
+/* Includes ------------------------------------------------------------------*/
+#include "OS_FileSystem.h"
+#include "OS_FileSystem_int.h"
+
+
+/* Public functions ----------------------------------------------------------*/
+/**
+ * @brief Opens a requested file by the passed file name, mapping it if it is
+ * not mapped yet.
+ *
+ * @retval OS_SUCCESS - if the requested file was opened successfully
+ * @retval OS_ERROR_GENERIC - if the file could not be opened or mapped
+ * @retval OS_ERROR_INVALID_PARAMETER - if the passed mode is not supported
+ * @retval OS_ERROR_INSUFFICIENT_SPACE - if no more files can be mapped
+ */
+OS_Error_t
+ConfigTool_HostFsMappedFileOpen(
+    OS_FileSystem_Handle_t          self,  //!< [in] Filesystem handle
+    OS_FileSystemFile_Handle_t      hFile, //!< [in] File handle
+    const char*                     name,  //!< [in] File name
+    const OS_FileSystem_OpenMode_t  mode,  //!< [in] Mode when opening a file
+    const OS_FileSystem_OpenFlags_t flags  //!< [in] Flags when opening a file
+);
+
+/**
+ * @brief Closes the file handle. The file stays mapped.
+ *
+ * @retval OS_SUCCESS - always
+ */
+OS_Error_t
+ConfigTool_HostFsMappedFileClose(
+    OS_FileSystem_Handle_t     self, //!< [in] Filesystem handle
+    OS_FileSystemFile_Handle_t hFile //!< [in] File handle
+);
+
+/**
+ * @brief Copies the requested length from the mapping of the file into the
+ * passed buffer.
+ *
+ * @retval OS_SUCCESS - if the read operation succeeded
+ * @retval OS_ERROR_NOT_FOUND - if the file was deleted
+ * @retval OS_ERROR_ABORTED - if the range exceeds the file size
+ */
+OS_Error_t
+ConfigTool_HostFsMappedFileRead(
+    OS_FileSystem_Handle_t     self,   //!< [in] Filesystem handle
+    OS_FileSystemFile_Handle_t hFile,  //!< [in] File handle
+    const off_t                offset, //!< [in] Offset to read from
+    const size_t               len,    //!< [in] Length to read
+    void*                      buffer  //!< [out] Buffer to write the read data
+);
+
+/**
+ * @brief Copies the requested length from the passed buffer into the mapping
+ * of the file, growing the file if needed.
+ *
+ * @retval OS_SUCCESS - if write operation succeeded
+ * @retval OS_ERROR_NOT_FOUND - if the file was deleted
+ * @retval OS_ERROR_ABORTED - if the file could not be grown
+ */
+OS_Error_t
+ConfigTool_HostFsMappedFileWrite(
+    OS_FileSystem_Handle_t     self,   //!< [in] Filesystem handle
+    OS_FileSystemFile_Handle_t hFile,  //!< [in] File handle
+    const off_t                offset, //!< [in] Offset to write to
+    const size_t               len,    //!< [in] Length to write
+    const void*                buffer  //!< [in] Buffer filled with data to write
+);
+
+/**
+ * @brief Deletes the file identified by the passed file name, unmapping it
+ * first if it is mapped.
+ *
+ * @retval OS_SUCCESS - if the requested file was deleted successfully
+ * @retval OS_ERROR_GENERIC - if the file could not be deleted successfully
+ */
+OS_Error_t
+ConfigTool_HostFsMappedFileDelete(
+    OS_FileSystem_Handle_t self, //!< [in] Filesystem handle
+    const char*            name  //!< [in] File name
+);
+
+/**
+ * @brief Returns the size of the file identified by the passed file name.
+ *
+ * @retval OS_SUCCESS - if the size was returned successfully
+ * @retval OS_ERROR_GENERIC - if the file status could not be retrieved
+ */
+OS_Error_t
+ConfigTool_HostFsMappedFileGetSize(
+    OS_FileSystem_Handle_t self, //!< [in] Filesystem handle
+    const char*            name, //!< [in] File name
+    off_t*                 sz    //!< [out] Pointer to set the file size to
+);
+
+/**
+ * @brief Creates the file identified by the passed file name empty and maps
+ * it at the passed size, so writes up to that size do not grow it.
+ *
+ * @retval OS_SUCCESS - if the file was created and mapped successfully
+ * @retval OS_ERROR_GENERIC - if the file could not be created
+ * @retval OS_ERROR_ABORTED - if the file could not be extended or mapped
+ * @retval OS_ERROR_INSUFFICIENT_SPACE - if no more files can be mapped
+ */
+OS_Error_t
+ConfigTool_HostFsMappedFileReserve(
+    OS_FileSystem_Handle_t self, //!< [in] Filesystem handle
+    const char*            name, //!< [in] File name
+    size_t                 size  //!< [in] Final size of the file
+);
+
+/**
+ * @brief Flushes all mapped files with msync(), cuts them to their final size
+ * and unmaps them.
+ *
+ * @retval OS_SUCCESS - if all files were flushed successfully
+ * @retval OS_ERROR_GENERIC - if a file could not be flushed or cut
+ */
+OS_Error_t
+ConfigTool_HostFsMappedFileUnmapAll(
+    OS_FileSystem_Handle_t self //!< [in] Filesystem handle
+);
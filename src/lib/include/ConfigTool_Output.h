@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @file
+ * @brief Private output directory of a provisioning run.
+ *
+ * The host storage of lib_host creates the image in the working directory.
+ * Each run therefore writes into a private temporary directory created next
+ * to its final output and only publishes the complete files afterwards, so
+ * concurrent runs do not interfere and a published file is never seen half
+ * written. Only image builds have to enter the directory, which changes the
+ * working directory of the whole process. The host filesystem writes into it
+ * by its descriptor instead.
+ *
+ * Every file is published on its own, it is synced and renamed over its final
+ * name, so it stays a regular file that is replaced atomically.
+ *
+ * @ingroup ConfigProvisioningTool
+ */
+#pragma once
+
+/* Includes ------------------------------------------------------------------*/
+#include "OS_Error.h"
+
+
+/* Exported types/enums ------------------------------------------------------*/
+/**
+ * @brief Private output directory of a provisioning run.
+ */
+typedef struct
+{
+    char* tmpDir; /**< temporary directory the files are written to */
+    int dirFd;    /**< descriptor of the temporary directory */
+    int cwdFd;    /**< working directory to return to, -1 if not entered */
+} ConfigTool_Output_t;
+
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief Creates a new temporary directory inside the passed directory. It has
+ * to be on the same filesystem as the published files.
+ *
+ * @retval OS_SUCCESS - if the directory was created successfully
+ * @retval OS_ERROR_INSUFFICIENT_SPACE - if the memory allocation failed
+ * @retval OS_ERROR_GENERIC - if the directory could not be created
+ */
+OS_Error_t
+ConfigTool_OutputInit(
+    ConfigTool_Output_t* self, //!< [out] Output to initialize
+    const char* dir            //!< [in] Directory to create the output in
+);
+
+/**
+ * @brief Makes the temporary directory the working directory.
+ *
+ * @retval OS_SUCCESS - if the working directory was changed successfully
+ * @retval OS_ERROR_GENERIC - if the working directory could not be changed
+ */
+OS_Error_t
+ConfigTool_OutputEnter(
+    ConfigTool_Output_t* self //!< [in] Output to enter
+);
+
+/**
+ * @brief Returns to the working directory active before entering the output.
+ *
+ * @retval OS_SUCCESS - if the working directory was restored successfully
+ * @retval OS_ERROR_GENERIC - if the working directory could not be restored
+ */
+OS_Error_t
+ConfigTool_OutputLeave(
+    ConfigTool_Output_t* self //!< [in] Output to leave
+);
+
+/**
+ * @brief Copies an existing file into the temporary directory, so it can be
+ * modified there and published again.
+ *
+ * @retval OS_SUCCESS - if the file was copied successfully
+ * @retval OS_ERROR_NOT_FOUND - if there is no such file
+ * @retval OS_ERROR_GENERIC - if the file could not be copied
+ */
+OS_Error_t
+ConfigTool_OutputImport(
+    ConfigTool_Output_t* self, //!< [in] Output to copy the file to
+    const char* name,          //!< [in] Name of the file in the output
+    const char* path           //!< [in] Path of the file to copy
+);
+
+/**
+ * @brief Syncs a file of the temporary directory to disk and atomically
+ * renames it to the passed path, replacing an existing file. Relative paths
+ * are relative to the working directory outside of the output.
+ *
+ * @retval OS_SUCCESS - if the file was published successfully
+ * @retval OS_ERROR_GENERIC - if the file could not be synced or renamed
+ */
+OS_Error_t
+ConfigTool_OutputPublish(
+    ConfigTool_Output_t* self, //!< [in] Output holding the file
+    const char* name,          //!< [in] Name of the file in the output
+    const char* path           //!< [in] Path to publish the file to
+);
+
+/**
+ * @brief Leaves the output if needed and removes the temporary directory
+ * together with all files not published.
+ */
+void
+ConfigTool_OutputFree(
+    ConfigTool_Output_t* self //!< [in] Output to free
+);
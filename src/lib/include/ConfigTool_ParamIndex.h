@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @file
+ * @brief Name index of the parameter records.
+ *
+ * INDEX.BIN holds a minimal perfect hash over the domain index and name of
+ * every parameter, mapping it to its record in PARAM.BIN, so a lookup on the
+ * device takes constant time instead of a scan of all records. The file is
+ * an array of 32-bit words in the byte order of the records:
+ *
+ * - a header of CONFIG_TOOL_PARAM_INDEX_HEADER_WORDS words, see
+ *   ConfigTool_ParamIndexHeader_t
+ * - one displacement per bucket
+ * - one PARAM.BIN record index per slot, there are as many slots as records
+ *
+ * A lookup hashes the key with ConfigTool_ParamIndexHash() and looks up the
+ * slot with ConfigTool_ParamIndexGetSlot(). Every key maps to a slot, so the
+ * record found has to be compared with the key to reject unknown names.
+ *
+ * @ingroup ConfigProvisioningTool
+ */
+#pragma once
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ConfigTool_ConfigModel.h"
+
+
+/* Defines -------------------------------------------------------------------*/
+#define INDEX_FILE  "INDEX.BIN"
+
+#define CONFIG_TOOL_PARAM_INDEX_MAGIC    0x49545043 // "CPTI"
+#define CONFIG_TOOL_PARAM_INDEX_VERSION  1
+
+#define CONFIG_TOOL_PARAM_INDEX_HEADER_WORDS \
+    (sizeof(ConfigTool_ParamIndexHeader_t) / sizeof(uint32_t))
+
+// Average number of keys per bucket
+#define CONFIG_TOOL_PARAM_INDEX_BUCKET_SIZE  4
+
+
+/* Exported types/enums ------------------------------------------------------*/
+/**
+ * @brief Header of INDEX.BIN.
+ */
+typedef struct
+{
+    uint32_t magic;       /**< CONFIG_TOOL_PARAM_INDEX_MAGIC */
+    uint32_t version;     /**< CONFIG_TOOL_PARAM_INDEX_VERSION */
+    uint32_t seed;        /**< seed of the key hash */
+    uint32_t slotCount;   /**< number of slots, the number of parameters */
+    uint32_t bucketCount; /**< number of buckets */
+} ConfigTool_ParamIndexHeader_t;
+
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief Returns the size of the index of the passed number of parameters.
+ *
+ * @return size of INDEX.BIN in bytes
+ */
+size_t
+ConfigTool_ParamIndexGetSize(
+    uint32_t paramCount //!< [in] Number of parameters
+);
+
+/**
+ * @brief Builds the index of the parameters of the passed model.
+ *
+ * @retval OS_SUCCESS - if the index was built
+ * @retval OS_ERROR_INVALID_PARAMETER - if a domain holds two parameters of
+ * the same name
+ * @retval OS_ERROR_INSUFFICIENT_SPACE - if the memory allocation failed
+ * @retval OS_ERROR_GENERIC - if no perfect hash was found
+ */
+OS_Error_t
+ConfigTool_ParamIndexBuild(
+    const ConfigTool_ConfigModel_t* model, //!< [in] Model of the parameters
+    uint32_t** index,                      //!< [out] Words of INDEX.BIN, to
+                                           //!<       be freed by the caller
+    size_t* size                           //!< [out] Size of the index in bytes
+);
+
+/**
+ * @brief Writes the index of the parameters of the passed model to INDEX.BIN.
+ *
+ * @retval OS_SUCCESS - if the index was written
+ * @retval other - if building or writing the index failed
+ */
+OS_Error_t
+ConfigTool_ParamIndexWrite(
+    const ConfigTool_ConfigModel_t* model, //!< [in] Model of the parameters
+    OS_FileSystem_Handle_t hFs             //!< [in] Filesystem to write to
+);
+
+/**
+ * @brief Calculates the hash of a key, a 64-bit FNV-1a hash over the seed,
+ * the domain index and the name as stored in the parameter record, without
+ * its terminator.
+ *
+ * @return hash of the key
+ */
+uint64_t
+ConfigTool_ParamIndexHash(
+    uint32_t seed,        //!< [in] Seed from the header
+    uint32_t domainIndex, //!< [in] Index of the domain
+    const char* name      //!< [in] Name of the parameter
+);
+
+/**
+ * @brief Looks up the slot of a key hash in a validated index.
+ *
+ * @return the PARAM.BIN record index stored in the slot
+ */
+uint32_t
+ConfigTool_ParamIndexGetSlot(
+    const uint32_t* index, //!< [in] Words of INDEX.BIN
+    uint64_t hash          //!< [in] Hash of the key
+);
+
+/**
+ * @brief Checks that the passed data is an index of the passed number of
+ * parameters.
+ *
+ * @retval OS_SUCCESS - if the index is valid
+ * @retval OS_ERROR_INVALID_STATE - if it is not
+ */
+OS_Error_t
+ConfigTool_ParamIndexValidate(
+    const void* data,   //!< [in] Content of INDEX.BIN
+    size_t size,        //!< [in] Size of INDEX.BIN
+    size_t paramCount   //!< [in] Number of parameter records
+);
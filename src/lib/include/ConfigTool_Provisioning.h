@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @file
+ * @brief Provisioning of a configuration from an XML file to a filesystem
+ * backend.
+ *
+ * The parsed configuration and the backend are held in the passed context.
+ * Writing an image changes the working directory and the host storage of the
+ * image is global, so there can only be one provisioning run per process.
+ * Parsed contexts may be kept, but parallel runs need a process of their own
+ * each, as in batch mode and the server.
+ *
+ * @ingroup ConfigProvisioningTool
+ */
+#pragma once
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+
+#include "ConfigTool_Backend.h"
+#include "ConfigTool_ConfigModel.h"
+#include "ConfigTool_ConfigPatcher.h"
+#include "ConfigTool_ConfigService.h"
+
+
+/* Exported types/enums ------------------------------------------------------*/
+/**
+ * @brief Context of a provisioning run.
+ */
+typedef struct
+{
+    ConfigTool_ConfigModel_t model;  /**< parsed configuration */
+    ConfigTool_Backend_t backend;    /**< backend the records are written to */
+    OS_ConfigServiceLib_t configLib; /**< configuration library on the backend */
+} ConfigTool_Provisioning_t;
+
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief Initializes the context and parses the XML file into its model. Blob
+ * values are resolved relative to the directory of the XML file. With
+ * clustered domains, the parameters of a domain are written as one range of
+ * records, which the record of the domain refers to.
+ *
+ * @retval OS_SUCCESS - if the file was parsed successfully
+ * @retval OS_ERROR_INSUFFICIENT_SPACE - if the memory allocation failed
+ * @retval OS_ERROR_GENERIC - if the file could not be parsed
+ */
+OS_Error_t
+ConfigTool_ProvisioningLoad(
+    ConfigTool_Provisioning_t* self, //!< [out] Context to initialize
+    const char* filePath,            //!< [in] Path to the XML file
+    bool useStreamParser,            /*!< [in] Parse with the streaming parser
+                                               instead of building a DOM */
+    bool clusterDomains              /*!< [in] Order the parameters by domain
+                                               and name */
+);
+
+/**
+ * @brief Writes the parsed configuration to a newly initialized filesystem
+ * backend of the configured type. The image size
+ * CONFIG_TOOL_BACKEND_IMAGE_SIZE_AUTO selects the smallest image fitting the
+ * configuration, plus a safety margin.
+ *
+ * @retval OS_SUCCESS - if the configuration was written successfully
+ * @retval OS_ERROR_NOT_SUPPORTED - if the filesystem type is not supported
+ * @retval OS_ERROR_INSUFFICIENT_SPACE - if the configuration does not fit into
+ * the image
+ * @retval OS_ERROR_GENERIC - if something went wrong during the writing process
+ */
+OS_Error_t
+ConfigTool_ProvisioningWrite(
+    ConfigTool_Provisioning_t* self,      //!< [in] Context holding the parsed model
+    const ConfigTool_BackendConfig_t* cfg //!< [in] Backend configuration
+);
+
+/**
+ * @brief Writes the parsed configuration like ConfigTool_ProvisioningWrite(),
+ * but from a private temporary directory created next to the output, and
+ * renames the complete files to the passed output path afterwards. The path
+ * is the image file or, without a filesystem type, the directory of the
+ * backend files.
+ *
+ * The working directory of the process is changed while writing an image, so
+ * the template cache directory of the backend configuration has to be
+ * absolute. Backend files are written by the descriptor of the private
+ * directory instead, every file is replaced atomically on its own.
+ *
+ * @retval OS_SUCCESS - if the configuration was published successfully
+ * @retval OS_ERROR_INVALID_PARAMETER - if the template cache directory is
+ * relative
+ * @retval other - the error of ConfigTool_ProvisioningWrite() or of creating
+ * and publishing the output
+ */
+OS_Error_t
+ConfigTool_ProvisioningPublish(
+    ConfigTool_Provisioning_t* self,       //!< [in] Context holding the parsed model
+    const ConfigTool_BackendConfig_t* cfg, //!< [in] Backend configuration
+    const char* outPath                    //!< [in] Path of the output
+);
+
+/**
+ * @brief Rewrites the values of single parameters in an existing output of
+ * the configured backend type, the image file or, without a filesystem type,
+ * the directory of the backend files. The output is copied to a private
+ * temporary directory, patched there and renamed back once complete, so it
+ * is never seen partially patched.
+ *
+ * The working directory of the process is changed only while patching an
+ * image, backend files are patched and published like in
+ * ConfigTool_ProvisioningPublish().
+ *
+ * @retval OS_SUCCESS - if all values were patched successfully
+ * @retval OS_ERROR_NOT_SUPPORTED - if a value cannot be patched in place and
+ * the output has to be rebuilt, the output is left unchanged then
+ * @retval other - the error of ConfigTool_ConfigPatcherRun() or of opening and
+ * publishing the output
+ */
+OS_Error_t
+ConfigTool_ProvisioningPatch(
+    const ConfigTool_BackendConfig_t* cfg,         //!< [in] Backend configuration
+    const char* outPath,                           //!< [in] Path of the output
+    const ConfigTool_ConfigPatcherValue_t* values, //!< [in] New parameter values
+    size_t valueCount,                             //!< [in] Number of values
+    const char* blobDir                            /*!< [in] Absolute directory
+                                                             of the blob files */
+);
+
+/**
+ * @brief Frees all resources held by the context.
+ */
+void
+ConfigTool_ProvisioningFree(
+    ConfigTool_Provisioning_t* self //!< [in] Context to free
+);
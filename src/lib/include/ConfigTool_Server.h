@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @file
+ * @brief Provisioning server answering build requests on a Unix socket.
+ *
+ * The server keeps every configuration it parsed, including its blob cache,
+ * until the XML file changes, so a request only pays for writing the output.
+ * Each connection carries one request, a line of tab separated fields:
+ *
+ *     build <xml_path> <filesystem_type> <output_path> [<domain>.<param>=<value>]...
+ *
+ * The filesystem type "-" writes the binary files into the output directory
+ * instead of an image. Both paths must be absolute. The reply is a line
+ * "OK <usec>" or "ERROR <error> <usec>" with the time taken by the request in
+ * microseconds. A request not received within a few seconds is answered with
+ * an error.
+ *
+ * The socket is only accessible by the user running the server.
+ *
+ * Every build runs in a process forked from the server, so the overrides of a
+ * request never reach the cached configuration.
+ *
+ * @ingroup ConfigProvisioningTool
+ */
+#pragma once
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "OS_Error.h"
+#include "ConfigTool_Backend.h"
+
+
+/* Exported types/enums ------------------------------------------------------*/
+/**
+ * @brief Configuration of the server.
+ */
+typedef struct
+{
+    const char* socketPath;                /**< path of the Unix socket */
+    size_t maxWorkers;                     /**< parallel builds, 0 for one per
+                                                CPU */
+    bool useStreamParser;                  /**< parse with the streaming parser */
+    bool clusterDomains;                   /**< order the parameters by domain
+                                                and name */
+    ConfigTool_BackendConfig_t cfgBackend; /**< backend of all builds, except
+                                                for the filesystem type */
+} ConfigTool_ServerConfig_t;
+
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief Serves build requests until SIGINT or SIGTERM is received.
+ *
+ * @retval OS_SUCCESS - if the server was stopped by a signal
+ * @retval OS_ERROR_GENERIC - if the socket could not be set up
+ */
+OS_Error_t
+ConfigTool_ServerRun(
+    const ConfigTool_ServerConfig_t* cfg //!< [in] Configuration of the server
+);
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @file
+ * @brief In-memory filesystem staging the backend files before they are
+ * written to the target filesystem.
+ *
+ * The record writes of the configuration library are small and scattered.
+ * Staging the files in memory turns them into a single sequential write per
+ * file on the target filesystem, which avoids the metadata updates and block
+ * rewrites each small write would cause there. A file holding bulk data, like
+ * BLOB.BIN, can be written directly to the target instead, so its content is
+ * never held in memory.
+ *
+ * @ingroup ConfigProvisioningTool
+ */
+#pragma once
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "OS_FileSystem.h"
+#include "OS_FileSystem_int.h"
+
+
+/* Defines -------------------------------------------------------------------*/
+#ifndef CONFIG_TOOL_STAGING_FS_MAX_FILES
+// The configuration library uses four backend files
+#define CONFIG_TOOL_STAGING_FS_MAX_FILES    8
+#endif
+
+#ifndef CONFIG_TOOL_STAGING_FS_LIMIT
+// Configurations with larger staged files are written directly
+#define CONFIG_TOOL_STAGING_FS_LIMIT        (16 * 1024 * 1024)
+#endif
+
+
+/* Exported types/enums ------------------------------------------------------*/
+/**
+ * @brief A file staged in memory.
+ */
+typedef struct
+{
+    char* name;      /**< name of the file, NULL if the slot is unused */
+    uint8_t* data;   /**< content of the file */
+    size_t size;     /**< size of the file */
+    size_t capacity; /**< allocated bytes of the content */
+} ConfigTool_StagingFsFile_t;
+
+/**
+ * @brief Instance of the staging filesystem. The generic filesystem object is
+ * the first member, so the handle passed to the file operations can be
+ * converted back to the instance holding the staged files.
+ */
+typedef struct
+{
+    OS_FileSystem_t fs;            /**< generic filesystem object */
+    OS_FileSystem_Handle_t target; /**< filesystem the files are flushed to */
+    const char* directName;        /**< file written directly to the target,
+                                        NULL if all files are staged */
+    ConfigTool_StagingFsFile_t files[CONFIG_TOOL_STAGING_FS_MAX_FILES]; /**< staged files */
+    ConfigTool_StagingFsFile_t* openFile[MAX_FILE_HANDLES]; /**< files of the open handles */
+    OS_FileSystemFile_Handle_t targetFile[MAX_FILE_HANDLES]; /**< target files of the direct handles */
+    bool isDirect[MAX_FILE_HANDLES]; /**< handle refers to the direct file */
+} ConfigTool_StagingFs_t;
+
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief Initializes an empty staging filesystem for the passed target. The
+ * file of the passed name is not staged, all operations on it are passed to
+ * the target right away.
+ *
+ * @retval OS_SUCCESS - if the filesystem handle was initialized successfully
+ * @retval OS_ERROR_INSUFFICIENT_SPACE - if the memory allocation failed
+ */
+OS_Error_t
+ConfigTool_StagingFsInit(
+    OS_FileSystem_Handle_t* self,   //!< [out] Pointer to a filesystem handle
+    OS_FileSystem_Handle_t  target, //!< [in] Filesystem to flush the files to
+    const char*             directName //!< [in] File to write directly, NULL
+                                       //!<      to stage all files
+);
+
+/**
+ * @brief Writes every staged file to the target filesystem, each one in a
+ * single write.
+ *
+ * @retval OS_SUCCESS - if all files were written successfully
+ * @retval other - the error of the target filesystem
+ */
+OS_Error_t
+ConfigTool_StagingFsFlush(
+    OS_FileSystem_Handle_t self //!< [in] Filesystem handle
+);
+
+/**
+ * @brief Frees the passed filesystem handle and all staged files, without
+ * writing them.
+ *
+ * @retval OS_SUCCESS - if the filesystem handle was freed successfully
+ * @retval OS_ERROR_INVALID_PARAMETER - if an empty handle was passed
+ */
+OS_Error_t
+ConfigTool_StagingFsFree(
+    OS_FileSystem_Handle_t self //!< [in] Filesystem handle
+);
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @file
+ * @brief Phase timers and I/O counters of a run of the tool.
+ *
+ * The statistics are kept in a shared anonymous mapping set up before any
+ * worker is forked, so the workers add to the same counters as the main
+ * process. The times of a phase are summed over all processes running it.
+ * As long as the statistics are not enabled, all functions but
+ * ConfigTool_StatsEnable() do nothing.
+ *
+ * @ingroup ConfigProvisioningTool
+ */
+#pragma once
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "OS_Error.h"
+
+
+/* Exported types/enums ------------------------------------------------------*/
+/**
+ * @brief Phases of building or patching an output.
+ */
+typedef enum
+{
+    CONFIG_TOOL_STATS_PHASE_PARSE,   /**< parsing and counting the XML file */
+    CONFIG_TOOL_STATS_PHASE_FORMAT,  /**< formatting or mounting a backend */
+    CONFIG_TOOL_STATS_PHASE_WRITE,   /**< writing or patching the records */
+    CONFIG_TOOL_STATS_PHASE_UNMOUNT, /**< unmounting a backend */
+    CONFIG_TOOL_STATS_PHASE_PUBLISH, /**< renaming the outputs into place */
+    CONFIG_TOOL_STATS_PHASE_COUNT
+} ConfigTool_StatsPhase_t;
+
+/**
+ * @brief Files written to a backend.
+ */
+typedef enum
+{
+    CONFIG_TOOL_STATS_FILE_DOMAIN, /**< DOMAIN.BIN */
+    CONFIG_TOOL_STATS_FILE_PARAM,  /**< PARAM.BIN */
+    CONFIG_TOOL_STATS_FILE_STRING, /**< STRING.BIN */
+    CONFIG_TOOL_STATS_FILE_BLOB,   /**< BLOB.BIN */
+    CONFIG_TOOL_STATS_FILE_INDEX,  /**< INDEX.BIN */
+    CONFIG_TOOL_STATS_FILE_COUNT
+} ConfigTool_StatsFile_t;
+
+/**
+ * @brief Operations on the HostStorage of lib_host.
+ */
+typedef enum
+{
+    CONFIG_TOOL_STATS_STORAGE_READ,
+    CONFIG_TOOL_STATS_STORAGE_WRITE,
+    CONFIG_TOOL_STATS_STORAGE_ERASE,
+    CONFIG_TOOL_STATS_STORAGE_COUNT
+} ConfigTool_StatsStorageOp_t;
+
+/**
+ * @brief Formats of the report.
+ */
+typedef enum
+{
+    CONFIG_TOOL_STATS_FORMAT_TABLE, /**< human readable table */
+    CONFIG_TOOL_STATS_FORMAT_JSON   /**< single JSON object */
+} ConfigTool_StatsFormat_t;
+
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief Enables the statistics and starts the total time. Has to be called
+ * before any worker is forked.
+ *
+ * @retval OS_SUCCESS - if the statistics were enabled
+ * @retval OS_ERROR_INSUFFICIENT_SPACE - if the shared mapping failed
+ */
+OS_Error_t
+ConfigTool_StatsEnable(void);
+
+/**
+ * @brief Returns whether the statistics are enabled.
+ */
+bool
+ConfigTool_StatsIsEnabled(void);
+
+/**
+ * @brief Returns the current time of the monotonic clock.
+ *
+ * @return time in nanoseconds, 0 if the statistics are not enabled
+ */
+uint64_t
+ConfigTool_StatsGetTime(void);
+
+/**
+ * @brief Adds the time passed since the start time to a phase.
+ */
+void
+ConfigTool_StatsAddPhase(
+    ConfigTool_StatsPhase_t phase, //!< [in] Phase that ended
+    uint64_t startTime             //!< [in] Start of the phase, taken with
+                                   //!<      ConfigTool_StatsGetTime()
+);
+
+/**
+ * @brief Counts records written to a backend file.
+ */
+void
+ConfigTool_StatsAddRecords(
+    ConfigTool_StatsFile_t file, //!< [in] File written to
+    uint64_t records,            //!< [in] Number of records
+    uint64_t bytes               //!< [in] Size of the records in bytes
+);
+
+/**
+ * @brief Counts an operation on the HostStorage.
+ */
+void
+ConfigTool_StatsAddStorageOp(
+    ConfigTool_StatsStorageOp_t op, //!< [in] Operation
+    uint64_t bytes                  //!< [in] Bytes read, written or erased
+);
+
+/**
+ * @brief Counts bytes read from blob files.
+ */
+void
+ConfigTool_StatsAddBlobRead(
+    uint64_t bytes //!< [in] Bytes read
+);
+
+/**
+ * @brief Counts an output that was completed.
+ */
+void
+ConfigTool_StatsAddOutput(void);
+
+/**
+ * @brief Prints the statistics to stderr or to the passed file, together with
+ * the total time since they were enabled and the peak resident set size of
+ * the process and its finished workers.
+ *
+ * @retval OS_SUCCESS - if the statistics are disabled or were printed
+ * @retval OS_ERROR_GENERIC - if the file could not be written
+ */
+OS_Error_t
+ConfigTool_StatsPrint(
+    ConfigTool_StatsFormat_t format, //!< [in] Format of the report
+    const char* path                 //!< [in] File to write the report to,
+                                     //!<      NULL for stderr
+);
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @file
+ * @brief Pool of the unique string values of a configuration.
+ *
+ * Every string value is interned once, equal values resolve to the same pool
+ * entry and thereby to the same record in STRING.BIN. The pool does not copy
+ * the values, it refers to them by their offset in the value buffer of the
+ * configuration model.
+ *
+ * @ingroup ConfigProvisioningTool
+ */
+#pragma once
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "OS_Error.h"
+#include "ConfigTool_Util.h"
+
+
+/* Exported types/enums ------------------------------------------------------*/
+/**
+ * @brief A unique string value.
+ */
+typedef struct
+{
+    uint64_t hash;      /**< hash of the value */
+    size_t valueOffset; /**< offset of the value in the value buffer */
+    size_t length;      /**< length of the value without terminator */
+} ConfigTool_StringPoolEntry_t;
+
+/**
+ * @brief Pool of unique string values.
+ */
+typedef struct
+{
+    ConfigTool_StringPoolEntry_t* entries; /**< unique values in first use order */
+    uint32_t count;                        /**< number of unique values */
+    uint32_t capacity;                     /**< allocated entries */
+    ConfigTool_UtilHashTable_t table;      /**< hash table of the entries */
+    uint32_t references;                   /**< number of interned values */
+} ConfigTool_StringPool_t;
+
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief Initializes an empty string pool.
+ */
+void
+ConfigTool_StringPoolInit(
+    ConfigTool_StringPool_t* self //!< [out] Pool to initialize
+);
+
+/**
+ * @brief Frees all resources held by the string pool.
+ */
+void
+ConfigTool_StringPoolFree(
+    ConfigTool_StringPool_t* self //!< [in] Pool to free
+);
+
+/**
+ * @brief Returns the pool entry of the passed value, adding the value to the
+ * pool if it is not pooled yet.
+ *
+ * @retval OS_SUCCESS - if the entry index was returned
+ * @retval OS_ERROR_INSUFFICIENT_SPACE - if the memory allocation failed
+ */
+OS_Error_t
+ConfigTool_StringPoolIntern(
+    ConfigTool_StringPool_t* self, //!< [in] Pool to look up the value in
+    const char* values,            //!< [in] Value buffer holding all values
+    size_t valueOffset,            //!< [in] Offset of the value in the buffer
+    size_t length,                 //!< [in] Length of the value
+    uint32_t* entryIndex           //!< [out] Index of the pool entry
+);
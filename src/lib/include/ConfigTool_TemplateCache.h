@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @file
+ * @brief On-disk cache of freshly formatted, empty partition images.
+ *
+ * Formatting is a large fixed cost of every image. The first run formatting
+ * an image of a filesystem type and size stores the blank image in the cache
+ * directory, later runs clone it, sharing the blocks by reflink where the
+ * host filesystem supports it, and only need to mount it. Templates are
+ * stored atomically, so concurrent runs can share one cache directory.
+ *
+ * @ingroup ConfigProvisioningTool
+ */
+#pragma once
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+
+#include "OS_Error.h"
+#include "OS_FileSystem.h"
+
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief Clones the cached template of the passed filesystem type and size to
+ * the passed path.
+ *
+ * @retval OS_SUCCESS - if the template was cloned successfully
+ * @retval OS_ERROR_NOT_FOUND - if no such template is cached
+ * @retval OS_ERROR_GENERIC - if the template could not be cloned
+ */
+OS_Error_t
+ConfigTool_TemplateCacheLoad(
+    const char* cacheDir,        //!< [in] Directory of the cache
+    OS_FileSystem_Type_t fsType, //!< [in] Filesystem type of the image
+    size_t size,                 //!< [in] Size of the image
+    const char* path             //!< [in] Path to clone the template to
+);
+
+/**
+ * @brief Stores the blank image at the passed path as template of the passed
+ * filesystem type and size, replacing an existing one.
+ *
+ * @retval OS_SUCCESS - if the template was stored successfully
+ * @retval OS_ERROR_GENERIC - if the template could not be stored
+ */
+OS_Error_t
+ConfigTool_TemplateCacheStore(
+    const char* cacheDir,        //!< [in] Directory of the cache
+    OS_FileSystem_Type_t fsType, //!< [in] Filesystem type of the image
+    size_t size,                 //!< [in] Size of the image
+    const char* path             //!< [in] Path of the blank image
+);
@@ -15,21 +15,33 @@
 #pragma once
 
 /* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+
 #include "OS_ConfigService.h"
 
 
-/* Exported functions --------------------------------------------------------*/
+/* Defines -------------------------------------------------------------------*/
+// Offset basis of the 64-bit FNV-1a hash
+#define CONFIG_TOOL_UTIL_HASH_INIT  0xcbf29ce484222325ULL
+
+// Number of buckets a hash table starts with, a power of two
+#define CONFIG_TOOL_UTIL_HASH_TABLE_INITIAL_BUCKETS  64
+
+
+/* Exported types/enums ------------------------------------------------------*/
 /**
- * @brief Helper function that copies the contents of the passed file to a
- * buffer that is dynamically allocated.
- *
- * @return char* pointer to the allocated buffer containing the file content
+ * @brief Open addressing hash table of entry indices. The entries and their
+ * keys are held by the user of the table. An entry that collides with another
+ * one is placed in the next free bucket.
  */
-char*
-ConfigTool_UtilCopyFileToBuf(
-    const char* filename //!< [in] Path to the file to copy to the buffer
-);
+typedef struct
+{
+    uint32_t* buckets;    /**< entry index + 1 per bucket, 0 if free */
+    uint32_t bucketCount; /**< number of buckets, a power of two */
+} ConfigTool_UtilHashTable_t;
 
+
+/* Exported functions --------------------------------------------------------*/
 /**
  * @brief Helper function that initializes a domain with the given name.
  */
@@ -59,5 +71,118 @@ ConfigTool_UtilInitializeName(
  */
 uint32_t
 ConfigTool_UtilCalculateNumberOfBlocks(
-    const char* blobValue //!< [in] Pointer to the blob value
+    size_t blobSize //!< [in] Size of the blob value
+);
+
+/**
+ * @brief Parses an unsigned integer value. Like in the XML file, the value can
+ * be decimal or hex, but it must not contain anything else.
+ *
+ * @retval OS_SUCCESS - if the value was parsed successfully
+ * @retval OS_ERROR_INVALID_PARAMETER - if the value is no integer or exceeds
+ *                                      the maximum
+ */
+OS_Error_t
+ConfigTool_UtilParseInteger(
+    const char* value, //!< [in] Value text
+    uint64_t max,      //!< [in] Largest valid value
+    uint64_t* result   //!< [out] Parsed value
+);
+
+/**
+ * @brief Calculates a 64-bit FNV-1a hash over the passed data.
+ *
+ * @return uint64_t hash of the data
+ */
+uint64_t
+ConfigTool_UtilHash(
+    const void* data, //!< [in] Pointer to the data to hash
+    size_t len        //!< [in] Length of the data
+);
+
+/**
+ * @brief Continues a 64-bit FNV-1a hash with the passed data, so data that is
+ * not available at once can be hashed piece by piece. Starting with
+ * CONFIG_TOOL_UTIL_HASH_INIT gives the same result as ConfigTool_UtilHash().
+ *
+ * @return uint64_t hash of all data passed so far
+ */
+uint64_t
+ConfigTool_UtilHashUpdate(
+    uint64_t hash,    //!< [in] Hash of the preceding data
+    const void* data, //!< [in] Pointer to the data to hash
+    size_t len        //!< [in] Length of the data
+);
+
+/**
+ * @brief Returns the first bucket an entry of the passed hash can be found in.
+ * The table must have buckets, see ConfigTool_UtilHashTableReserve().
+ *
+ * @return uint32_t* bucket to start probing with
+ */
+uint32_t*
+ConfigTool_UtilHashTableFirst(
+    const ConfigTool_UtilHashTable_t* self, //!< [in] Hash table
+    uint64_t hash                           //!< [in] Hash of the key
+);
+
+/**
+ * @brief Returns the bucket to probe after the passed one. Probing ends at the
+ * first free bucket, which is also where a new entry of the key goes.
+ *
+ * @return uint32_t* next bucket
+ */
+uint32_t*
+ConfigTool_UtilHashTableNext(
+    const ConfigTool_UtilHashTable_t* self, //!< [in] Hash table
+    const uint32_t* bucket                  //!< [in] Bucket probed last
+);
+
+/**
+ * @brief Places an entry in the first free bucket of its hash, without
+ * comparing it to the entries already in the table. The entry must be unique.
+ */
+void
+ConfigTool_UtilHashTableInsert(
+    ConfigTool_UtilHashTable_t* self, //!< [in] Hash table
+    uint64_t hash,                    //!< [in] Hash of the key of the entry
+    uint32_t entryIndex               //!< [in] Index of the entry
+);
+
+/**
+ * @brief Makes sure the table stays at most half full with one more entry
+ * than the passed count, so lookups stay short. If the table grows, its
+ * buckets are replaced by twice as many empty ones and all entries have to be
+ * inserted again.
+ *
+ * @retval OS_SUCCESS - if the table has room for one more entry
+ * @retval OS_ERROR_INSUFFICIENT_SPACE - if allocating the buckets failed, the
+ *                                       table is left unchanged
+ */
+OS_Error_t
+ConfigTool_UtilHashTableReserve(
+    ConfigTool_UtilHashTable_t* self, //!< [in] Hash table
+    uint32_t count,                   //!< [in] Number of entries in the table
+    bool* isRehashNeeded              //!< [out] Whether the table was emptied
+);
+
+/**
+ * @brief Frees the buckets of a hash table and leaves it empty.
+ */
+void
+ConfigTool_UtilHashTableFree(
+    ConfigTool_UtilHashTable_t* self //!< [in] Hash table
+);
+
+/**
+ * @brief Copies the whole content of a file to another, empty file, sharing
+ * the blocks by reflink where the host filesystem supports it.
+ *
+ * @retval OS_SUCCESS - if the file was copied successfully
+ * @retval OS_ERROR_GENERIC - if reading or writing failed
+ */
+OS_Error_t
+ConfigTool_UtilCopyFile(
+    int srcFd, //!< [in] File to copy
+    int dstFd  //!< [in] File to copy to
 );
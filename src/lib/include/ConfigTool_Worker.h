@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @file
+ * @brief Runs independent jobs in parallel worker processes.
+ *
+ * The host storage of lib_host is a single instance per process and located
+ * in the working directory, so outputs cannot be built by threads of one
+ * process. Each job runs in a process of its own instead, forked after the
+ * shared state like the parsed configuration is set up, so the workers share
+ * that state copy-on-write without parsing it again.
+ *
+ * @ingroup ConfigProvisioningTool
+ */
+#pragma once
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+
+#include "OS_Error.h"
+
+
+/* Exported types/enums ------------------------------------------------------*/
+/**
+ * @brief A job run by a worker, gets the index of the job.
+ */
+typedef OS_Error_t (*ConfigTool_WorkerJob_t)(
+    size_t index, //!< [in] Index of the job
+    void* ctx     //!< [in] Context passed to ConfigTool_WorkerRun()
+);
+
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief Runs the passed number of jobs with at most the passed number of
+ * worker processes at a time and waits for all of them. A single job is run
+ * in the calling process.
+ *
+ * @retval OS_SUCCESS - if all jobs succeeded
+ * @retval OS_ERROR_GENERIC - if a job failed or a worker could not be started
+ */
+OS_Error_t
+ConfigTool_WorkerRun(
+    size_t jobCount,            //!< [in] Number of jobs
+    size_t maxWorkers,          /*!< [in] Maximum number of parallel workers, 0
+                                          for the number of online CPUs */
+    ConfigTool_WorkerJob_t job, //!< [in] Function running a job
+    void* ctx                   //!< [in] Context passed to the jobs
+);
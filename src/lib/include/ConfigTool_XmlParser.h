@@ -8,8 +8,9 @@
 
 /**
  * @file
- * @brief Collection of functions to parse an XML file into an image usable by
- * the Configuration Service library.
+ * @brief Collection of functions to parse an XML file into a configuration
+ * model that can be written to an image usable by the Configuration Service
+ * library.
  *
  * @ingroup ConfigProvisioningTool
  */
@@ -19,39 +20,38 @@
 #include <libxml/parser.h>
 #include <libxml/tree.h>
 #include "ConfigTool_ConfigService.h"
+#include "ConfigTool_ConfigModel.h"
 #include "ConfigTool_Util.h"
 
 
 /* Exported functions --------------------------------------------------------*/
 /**
- * @brief Iterates over the XML nodes and writes the values of the domains and
- * parameter elements to the configuration library instance
+ * @brief Iterates over the XML nodes and adds the domains and parameter
+ * elements to the configuration model
  *
- * @param configLib [in] pointer to an initiliazed configuration library instance
  * @param a_node [in] pointer to the first XML node of the document
- * @param configCounter [in] pointer to the ConfigCounter object
- * @param dirPath [in] pointer to the directory path containing files to be read
- * into the blob values
+ * @param model [in] pointer to an initialized configuration model
+ * @retval OS_SUCCESS if all elements were added successfully
+ * @retval OS_ERROR_GENERIC if an element is invalid
  */
-void ConfigTool_XmlParserRun(
-    OS_ConfigServiceLib_t* configLib,
+OS_Error_t ConfigTool_XmlParserBuildModel(
     xmlNode* a_node,
-    ConfigTool_ConfigServiceCounter_t* configCounter,
-    const char* dirPath
+    ConfigTool_ConfigModel_t* model
 );
 
 /**
- * @brief Iterates over the XML nodes and counts the number of domains and
- * different parameter elements that need to be written to the config
- * provisioning image
+ * @brief Streams through the XML file and adds the domains and parameter
+ * elements to the configuration model as they are read. No DOM is built, so
+ * the memory consumption of the parser is bound by the largest single element
+ * instead of the size of the document.
  *
- * @param a_node [in] pointer to the first XML node of the document
- * @param configCounter [out] pointer to the ConfigCounter object
- * @param dirPath [in] pointer to the directory path containing files to be read
- * into the blob values
+ * @param fileName [in] path to the XML file
+ * @param model [in] pointer to an initialized configuration model
+ * @retval OS_SUCCESS if all elements were added successfully
+ * @retval OS_ERROR_GENERIC if the file could not be parsed or an element is
+ * invalid
  */
-void ConfigTool_XmlParserGetElementCount(
-    xmlNode* a_node,
-    ConfigTool_ConfigServiceCounter_t* configCounter,
-    const char* dirPath
+OS_Error_t ConfigTool_XmlParserBuildModelStream(
+    const char* fileName,
+    ConfigTool_ConfigModel_t* model
 );
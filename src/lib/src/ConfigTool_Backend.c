@@ -9,25 +9,233 @@
  */
 
 /* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <unistd.h>
+
 #include "lib_debug/Debug.h"
 
 #include "ConfigTool_Backend.h"
+#include "ConfigTool_HostFsMappedFile.h"
+#include "ConfigTool_ParamIndex.h"
+#include "ConfigTool_Stats.h"
+#include "ConfigTool_TemplateCache.h"
+
+
+/* Defines -------------------------------------------------------------------*/
+#define DIV_ROUND_UP(x, y) (((x) + (y) - 1) / (y))
+
+// Number of backend files written by the configuration library, plus the
+// parameter name index
+#define BACKEND_FILE_COUNT              5
+
+// FAT: sectors, the root directory and two FATs with 16-bit entries
+#define BACKEND_FAT_SECTOR_SIZE         512
+#define BACKEND_FAT_RESERVED_SECTORS    1
+#define BACKEND_FAT_ROOT_DIR_SECTORS    32
+#define BACKEND_FAT_MIN_SECTORS         128
+
+// LittleFS: the superblock pair holds the root directory, files are stored in
+// blocks prefixed with their skip-list pointers
+#define BACKEND_LITTLEFS_BLOCK_SIZE     4096
+#define BACKEND_LITTLEFS_BLOCK_HEADER   16
+#define BACKEND_LITTLEFS_META_BLOCKS    2
+#define BACKEND_LITTLEFS_SPARE_BLOCKS   4
+
+// SPIFFS: every block starts with a lookup page, every page has a header and
+// every file an index header page followed by further index pages
+#define BACKEND_SPIFFS_BLOCK_SIZE       4096
+#define BACKEND_SPIFFS_PAGE_SIZE        256
+#define BACKEND_SPIFFS_PAGE_HEADER      5
+#define BACKEND_SPIFFS_LOOKUP_PAGES     1
+#define BACKEND_SPIFFS_INDEX_HEADER_REFS 96
+#define BACKEND_SPIFFS_INDEX_REFS       122
+#define BACKEND_SPIFFS_SPARE_BLOCKS     2
+
+// Images are sized in multiples of the largest block size of all filesystems
+#define BACKEND_IMAGE_ALIGNMENT         4096
+
+// Automatically sized images get an eighth and a few blocks more than needed
+#define BACKEND_IMAGE_MARGIN_SHIFT      3
+#define BACKEND_IMAGE_MARGIN_BLOCKS     4
 
 
 /* Private variables ---------------------------------------------------------*/
 extern FakeDataport_t* hostStorage_port;
-static OS_FileSystem_Config_t cfgFs =
-{
-    .size = OS_FileSystem_USE_STORAGE_MAX,
-    .storage = IF_OS_STORAGE_ASSIGN(
-        HostStorage,
-        hostStorage_port),
-};
 
 
 /* Private functions ---------------------------------------------------------*/
+/* The storage interface passes no context, so the counting functions call the
+ * single HostStorage of lib_host directly. The wrapped interface is kept in
+ * the configuration of each backend.
+ */
 static OS_Error_t
-ConfigTool_BackendPrepareFileSystem(
+ConfigTool_BackendStorageWrite(
+    off_t const offset,
+    size_t const size,
+    size_t* const written)
+{
+    OS_Error_t err = HostStorage_write(offset, size, written);
+    ConfigTool_StatsAddStorageOp(CONFIG_TOOL_STATS_STORAGE_WRITE,
+                                 (err == OS_SUCCESS) ? *written : 0);
+
+    return err;
+}
+
+static OS_Error_t
+ConfigTool_BackendStorageRead(
+    off_t const offset,
+    size_t const size,
+    size_t* const read)
+{
+    OS_Error_t err = HostStorage_read(offset, size, read);
+    ConfigTool_StatsAddStorageOp(CONFIG_TOOL_STATS_STORAGE_READ,
+                                 (err == OS_SUCCESS) ? *read : 0);
+
+    return err;
+}
+
+static OS_Error_t
+ConfigTool_BackendStorageErase(
+    off_t const offset,
+    off_t const size,
+    off_t* const erased)
+{
+    OS_Error_t err = HostStorage_erase(offset, size, erased);
+    ConfigTool_StatsAddStorageOp(CONFIG_TOOL_STATS_STORAGE_ERASE,
+                                 (err == OS_SUCCESS) ? *erased : 0);
+
+    return err;
+}
+
+// Returns the sizes of the backend files holding the counted records
+static size_t
+ConfigTool_BackendGetFileSizes(
+    const ConfigTool_ConfigServiceCounter_t* counter,
+    bool hasIndex,
+    uint64_t fileSize[BACKEND_FILE_COUNT])
+{
+    fileSize[0] = (uint64_t)counter->domain_count
+                  * sizeof(OS_ConfigServiceLibTypes_Domain_t);
+    fileSize[1] = (uint64_t)counter->param_count
+                  * sizeof(OS_ConfigServiceLibTypes_Parameter_t);
+    fileSize[2] = (uint64_t)counter->string_count
+                  * OS_CONFIG_LIB_PARAMETER_MAX_STRING_SIZE;
+    fileSize[3] = (uint64_t)counter->blob_count
+                  * OS_CONFIG_LIB_PARAMETER_MAX_BLOB_BLOCK_SIZE;
+
+    if (!hasIndex)
+    {
+        return BACKEND_FILE_COUNT - 1;
+    }
+
+    fileSize[4] = ConfigTool_ParamIndexGetSize(counter->param_count);
+
+    return BACKEND_FILE_COUNT;
+}
+
+// Returns the sectors of a FAT volume of the passed size per cluster
+static uint64_t
+ConfigTool_BackendGetFatSectors(
+    const uint64_t fileSize[BACKEND_FILE_COUNT],
+    size_t fileCount,
+    uint64_t clusterSectors)
+{
+    uint64_t clusters = 0;
+
+    for (size_t i = 0; i < fileCount; i++)
+    {
+        clusters += DIV_ROUND_UP(fileSize[i],
+                                 clusterSectors * BACKEND_FAT_SECTOR_SIZE);
+    }
+
+    // The first two entries of a FAT are reserved
+    uint64_t fatSectors = DIV_ROUND_UP((clusters + 2) * 2,
+                                       BACKEND_FAT_SECTOR_SIZE);
+
+    return BACKEND_FAT_RESERVED_SECTORS
+           + (2 * fatSectors)
+           + BACKEND_FAT_ROOT_DIR_SECTORS
+           + (clusters * clusterSectors);
+}
+
+static uint64_t
+ConfigTool_BackendGetFatImageSize(
+    const uint64_t fileSize[BACKEND_FILE_COUNT],
+    size_t fileCount)
+{
+    /* The cluster size is chosen by the formatter from the volume size, one
+     * sector for volumes below 1 MiB doubling with every fourfold volume
+     * size. Start with the smallest clusters and enlarge them until the
+     * volume needing them is large enough to get them assigned.
+     */
+    uint64_t clusterSectors = 1;
+    uint64_t sectors = ConfigTool_BackendGetFatSectors(fileSize, fileCount,
+                                                      clusterSectors);
+
+    for (uint64_t limit = 2048; sectors >= limit; limit *= 4)
+    {
+        clusterSectors *= 2;
+        sectors = ConfigTool_BackendGetFatSectors(fileSize, fileCount,
+                                                  clusterSectors);
+    }
+
+    if (sectors < BACKEND_FAT_MIN_SECTORS)
+    {
+        sectors = BACKEND_FAT_MIN_SECTORS;
+    }
+
+    return sectors * BACKEND_FAT_SECTOR_SIZE;
+}
+
+static uint64_t
+ConfigTool_BackendGetLittleFsImageSize(
+    const uint64_t fileSize[BACKEND_FILE_COUNT],
+    size_t fileCount)
+{
+    uint64_t blocks = BACKEND_LITTLEFS_META_BLOCKS
+                      + BACKEND_LITTLEFS_SPARE_BLOCKS;
+
+    for (size_t i = 0; i < fileCount; i++)
+    {
+        blocks += DIV_ROUND_UP(fileSize[i],
+                               BACKEND_LITTLEFS_BLOCK_SIZE
+                               - BACKEND_LITTLEFS_BLOCK_HEADER);
+    }
+
+    return blocks * BACKEND_LITTLEFS_BLOCK_SIZE;
+}
+
+static uint64_t
+ConfigTool_BackendGetSpiffsImageSize(
+    const uint64_t fileSize[BACKEND_FILE_COUNT],
+    size_t fileCount)
+{
+    const uint64_t pagesPerBlock = BACKEND_SPIFFS_BLOCK_SIZE
+                                   / BACKEND_SPIFFS_PAGE_SIZE;
+    uint64_t pages = 0;
+
+    for (size_t i = 0; i < fileCount; i++)
+    {
+        uint64_t dataPages = DIV_ROUND_UP(fileSize[i],
+                                          BACKEND_SPIFFS_PAGE_SIZE
+                                          - BACKEND_SPIFFS_PAGE_HEADER);
+        pages += dataPages + 1;
+        if (dataPages > BACKEND_SPIFFS_INDEX_HEADER_REFS)
+        {
+            pages += DIV_ROUND_UP(dataPages - BACKEND_SPIFFS_INDEX_HEADER_REFS,
+                                  BACKEND_SPIFFS_INDEX_REFS);
+        }
+    }
+
+    uint64_t blocks = DIV_ROUND_UP(pages,
+                                   pagesPerBlock - BACKEND_SPIFFS_LOOKUP_PAGES)
+                      + BACKEND_SPIFFS_SPARE_BLOCKS;
+
+    return blocks * BACKEND_SPIFFS_BLOCK_SIZE;
+}
+
+static OS_Error_t
+ConfigTool_BackendMountFileSystem(
     OS_FileSystem_Handle_t* hFs,
     const OS_FileSystem_Config_t* cfgFs)
 {
@@ -38,6 +246,50 @@ ConfigTool_BackendPrepareFileSystem(
         return err;
     }
 
+    err = OS_FileSystem_mount(*hFs);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("OS_FileSystem_mount() failed with %d.", err);
+        OS_FileSystem_free(*hFs);
+        return err;
+    }
+
+    return OS_SUCCESS;
+}
+
+static OS_Error_t
+ConfigTool_BackendPrepareFileSystem(
+    OS_FileSystem_Handle_t* hFs,
+    const OS_FileSystem_Config_t* cfgFs,
+    const char* templateCacheDir)
+{
+    // A cached blank image only needs to be mounted
+    bool cloned = false;
+    if (templateCacheDir != NULL)
+    {
+        cloned = (ConfigTool_TemplateCacheLoad(
+                      templateCacheDir,
+                      cfgFs->type,
+                      cfgFs->size,
+                      HOSTSTORAGE_FILE_NAME) == OS_SUCCESS);
+    }
+
+    OS_Error_t err = OS_FileSystem_init(hFs, cfgFs);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("OS_FileSystem_init() failed with %d.", err);
+        return err;
+    }
+
+    if (cloned)
+    {
+        if (OS_FileSystem_mount(*hFs) == OS_SUCCESS)
+        {
+            return OS_SUCCESS;
+        }
+        Debug_LOG_WARNING("Mounting the cached template failed, formatting.");
+    }
+
     err = OS_FileSystem_format(*hFs);
     if (err != OS_SUCCESS)
     {
@@ -45,6 +297,21 @@ ConfigTool_BackendPrepareFileSystem(
         return err;
     }
 
+    // The image is used anyway, a template that cannot be stored is not fatal
+    if (templateCacheDir != NULL)
+    {
+        err = ConfigTool_TemplateCacheStore(
+                  templateCacheDir,
+                  cfgFs->type,
+                  cfgFs->size,
+                  HOSTSTORAGE_FILE_NAME);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_WARNING("ConfigTool_TemplateCacheStore() failed with %d.",
+                              err);
+        }
+    }
+
     err = OS_FileSystem_mount(*hFs);
     if (err != OS_SUCCESS)
     {
@@ -57,23 +324,143 @@ ConfigTool_BackendPrepareFileSystem(
 
 
 /* Exported functions --------------------------------------------------------*/
-OS_Error_t ConfigTool_BackendInit(
-    OS_FileSystem_Handle_t* hFs,
-    OS_FileSystem_Type_t fsType)
+uint64_t ConfigTool_BackendGetMinImageSize(
+    OS_FileSystem_Type_t fsType,
+    const ConfigTool_ConfigServiceCounter_t* counter,
+    bool hasIndex)
+{
+    uint64_t fileSize[BACKEND_FILE_COUNT];
+    uint64_t imageSize;
+
+    size_t fileCount = ConfigTool_BackendGetFileSizes(counter, hasIndex,
+                                                      fileSize);
+
+    switch (fsType)
+    {
+    case OS_FileSystem_Type_FATFS:
+        imageSize = ConfigTool_BackendGetFatImageSize(fileSize, fileCount);
+        break;
+    case OS_FileSystem_Type_LITTLEFS:
+        imageSize = ConfigTool_BackendGetLittleFsImageSize(fileSize, fileCount);
+        break;
+    case OS_FileSystem_Type_SPIFFS:
+        imageSize = ConfigTool_BackendGetSpiffsImageSize(fileSize, fileCount);
+        break;
+    default:
+        return 0;
+    }
+
+    return DIV_ROUND_UP(imageSize, BACKEND_IMAGE_ALIGNMENT)
+           * BACKEND_IMAGE_ALIGNMENT;
+}
+
+uint64_t ConfigTool_BackendGetAutoImageSize(
+    OS_FileSystem_Type_t fsType,
+    const ConfigTool_ConfigServiceCounter_t* counter,
+    bool hasIndex)
+{
+    uint64_t imageSize = ConfigTool_BackendGetMinImageSize(fsType, counter,
+                                                           hasIndex);
+    if (imageSize == 0)
+    {
+        return 0;
+    }
+
+    return imageSize + DIV_ROUND_UP(imageSize >> BACKEND_IMAGE_MARGIN_SHIFT,
+                                    BACKEND_IMAGE_ALIGNMENT)
+           * BACKEND_IMAGE_ALIGNMENT
+           + (BACKEND_IMAGE_MARGIN_BLOCKS * BACKEND_IMAGE_ALIGNMENT);
+}
+
+OS_Error_t ConfigTool_BackendReserveFiles(
+    ConfigTool_Backend_t* self,
+    const ConfigTool_ConfigServiceCounter_t* counter,
+    bool hasIndex)
+{
+    static const char* const fileNames[BACKEND_FILE_COUNT] =
+    {
+        DOMAIN_FILE, PARAMETER_FILE, STRING_FILE, BLOB_FILE, INDEX_FILE
+    };
+    uint64_t fileSize[BACKEND_FILE_COUNT];
+
+    if ((self->cfgFs.type != OS_FileSystem_Type_NONE)
+        || (((ConfigTool_HostFs_t*)self->hFs)->mode
+            != CONFIG_TOOL_HOST_FS_MODE_MAP))
+    {
+        return OS_SUCCESS;
+    }
+
+    size_t fileCount = ConfigTool_BackendGetFileSizes(counter, hasIndex,
+                                                      fileSize);
+
+    for (size_t i = 0; i < fileCount; i++)
+    {
+        OS_Error_t err = ConfigTool_HostFsMappedFileReserve(
+                             self->hFs,
+                             fileNames[i],
+                             fileSize[i]);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("ConfigTool_HostFsMappedFileReserve() failed "
+                            "for %s with %d", fileNames[i], err);
+            return err;
+        }
+    }
+
+    return OS_SUCCESS;
+}
+
+// Sets up a backend on a new image or host files, or on the existing ones
+static OS_Error_t
+ConfigTool_BackendSetup(
+    ConfigTool_Backend_t* self,
+    const ConfigTool_BackendConfig_t* cfg,
+    bool isExisting)
 {
     OS_Error_t err;
 
+    if ((cfg->fsType != OS_FileSystem_Type_NONE)
+        && ((cfg->imageSize == 0) || (cfg->imageSize > HOSTSTORAGE_SIZE)
+            || ((cfg->imageSize % BACKEND_IMAGE_ALIGNMENT) != 0)))
+    {
+        Debug_LOG_ERROR("Image size %zu is not a multiple of %d up to %zu",
+                        cfg->imageSize, BACKEND_IMAGE_ALIGNMENT,
+                        (size_t)HOSTSTORAGE_SIZE);
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
     // Set the filesystem type specified by the user input
-    cfgFs.type = fsType;
+    const OS_FileSystem_Config_t cfgFs =
+    {
+        .type = cfg->fsType,
+        .size = cfg->imageSize,
+        .storage = IF_OS_STORAGE_ASSIGN(
+            HostStorage,
+            hostStorage_port),
+    };
+    self->cfgFs = cfgFs;
 
-    switch (cfgFs.type)
+    // The operations on the storage are only counted for the statistics
+    if (ConfigTool_StatsIsEnabled())
+    {
+        self->cfgFs.storage.write = ConfigTool_BackendStorageWrite;
+        self->cfgFs.storage.read = ConfigTool_BackendStorageRead;
+        self->cfgFs.storage.erase = ConfigTool_BackendStorageErase;
+    }
+
+    switch (self->cfgFs.type)
     {
     case OS_FileSystem_Type_FATFS:
         __attribute__ ((fallthrough));
     case OS_FileSystem_Type_LITTLEFS:
         __attribute__ ((fallthrough));
     case OS_FileSystem_Type_SPIFFS:
-        err = ConfigTool_BackendPrepareFileSystem(hFs, &cfgFs);
+        err = isExisting ?
+              ConfigTool_BackendMountFileSystem(&self->hFs, &self->cfgFs) :
+              ConfigTool_BackendPrepareFileSystem(
+                  &self->hFs,
+                  &self->cfgFs,
+                  cfg->templateCacheDir);
         if (err != OS_SUCCESS)
         {
             Debug_LOG_ERROR("ConfigTool_BackendPrepareFileSystem() "
@@ -82,7 +469,8 @@ OS_Error_t ConfigTool_BackendInit(
         }
         break;
     case OS_FileSystem_Type_NONE:
-        err = ConfigTool_HostFsInit(hFs, &cfgFs);
+        err = ConfigTool_HostFsInit(&self->hFs, &self->cfgFs, cfg->hostFsMode,
+                                    cfg->hostDir);
         if (err != OS_SUCCESS)
         {
             Debug_LOG_ERROR("ConfigTool_HostFsInit() failed with %d.", err);
@@ -97,12 +485,35 @@ OS_Error_t ConfigTool_BackendInit(
     return OS_SUCCESS;
 }
 
-OS_Error_t ConfigTool_BackendDeInit(
-    OS_FileSystem_Handle_t hFs)
+OS_Error_t ConfigTool_BackendInit(
+    ConfigTool_Backend_t* self,
+    const ConfigTool_BackendConfig_t* cfg)
+{
+    uint64_t startTime = ConfigTool_StatsGetTime();
+    OS_Error_t err = ConfigTool_BackendSetup(self, cfg, false);
+    ConfigTool_StatsAddPhase(CONFIG_TOOL_STATS_PHASE_FORMAT, startTime);
+
+    return err;
+}
+
+OS_Error_t ConfigTool_BackendOpen(
+    ConfigTool_Backend_t* self,
+    const ConfigTool_BackendConfig_t* cfg)
 {
-    if (cfgFs.type == OS_FileSystem_Type_NONE)
+    uint64_t startTime = ConfigTool_StatsGetTime();
+    OS_Error_t err = ConfigTool_BackendSetup(self, cfg, true);
+    ConfigTool_StatsAddPhase(CONFIG_TOOL_STATS_PHASE_FORMAT, startTime);
+
+    return err;
+}
+
+static OS_Error_t
+ConfigTool_BackendRelease(
+    ConfigTool_Backend_t* self)
+{
+    if (self->cfgFs.type == OS_FileSystem_Type_NONE)
     {
-        const OS_Error_t err = ConfigTool_HostFsFree(hFs);
+        const OS_Error_t err = ConfigTool_HostFsFree(self->hFs);
         if (err != OS_SUCCESS)
         {
             Debug_LOG_ERROR("ConfigTool_HostFsFree() failed with %d.", err);
@@ -110,17 +521,17 @@ OS_Error_t ConfigTool_BackendDeInit(
         }
     }
 
-    if (cfgFs.type == OS_FileSystem_Type_FATFS
-        || cfgFs.type == OS_FileSystem_Type_SPIFFS)
+    if (self->cfgFs.type == OS_FileSystem_Type_FATFS
+        || self->cfgFs.type == OS_FileSystem_Type_SPIFFS)
     {
-        OS_Error_t err = OS_FileSystem_unmount(hFs);
+        OS_Error_t err = OS_FileSystem_unmount(self->hFs);
         if (err != OS_SUCCESS)
         {
             Debug_LOG_ERROR("OS_FileSystem_unmount() failed with %d.", err);
             return err;
         }
 
-        err = OS_FileSystem_free(hFs);
+        err = OS_FileSystem_free(self->hFs);
         if (err != OS_SUCCESS)
         {
             Debug_LOG_ERROR("OS_FileSystem_free() failed with %d.", err);
@@ -128,5 +539,30 @@ OS_Error_t ConfigTool_BackendDeInit(
         }
     }
 
+    /* The storage file only covers the blocks written by the filesystem, or
+     * still holds data beyond the partition from an earlier run.
+     */
+    if (self->cfgFs.type != OS_FileSystem_Type_NONE)
+    {
+        if (truncate(HOSTSTORAGE_FILE_NAME, self->cfgFs.size) != 0)
+        {
+            Debug_LOG_ERROR("Cutting %s to %zu bytes failed.",
+                            HOSTSTORAGE_FILE_NAME, self->cfgFs.size);
+            return OS_ERROR_GENERIC;
+        }
+    }
+
+    self->hFs = NULL;
+
     return OS_SUCCESS;
 }
+
+OS_Error_t ConfigTool_BackendDeInit(
+    ConfigTool_Backend_t* self)
+{
+    uint64_t startTime = ConfigTool_StatsGetTime();
+    OS_Error_t err = ConfigTool_BackendRelease(self);
+    ConfigTool_StatsAddPhase(CONFIG_TOOL_STATS_PHASE_UNMOUNT, startTime);
+
+    return err;
+}
@@ -0,0 +1,277 @@
+/*
+ * Table of per-device overrides for batch provisioning
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "lib_debug/Debug.h"
+#include "ConfigTool_BatchTable.h"
+
+
+/* Defines -------------------------------------------------------------------*/
+#define BATCH_TABLE_INITIAL_CELLS  64
+
+
+/* Private functions ---------------------------------------------------------*/
+static
+OS_Error_t
+ConfigTool_BatchTableReadFile(
+    ConfigTool_BatchTable_t* self,
+    const char* path)
+{
+    FILE* f = fopen(path, "rb");
+    if (f == NULL)
+    {
+        Debug_LOG_ERROR("Failed to open %s", path);
+        return OS_ERROR_GENERIC;
+    }
+
+    OS_Error_t err = OS_SUCCESS;
+    long size;
+
+    if ((fseek(f, 0, SEEK_END) != 0) || ((size = ftell(f)) < 0)
+        || (fseek(f, 0, SEEK_SET) != 0))
+    {
+        Debug_LOG_ERROR("Failed to determine the size of %s", path);
+        err = OS_ERROR_GENERIC;
+    }
+    else if ((self->data = malloc((size_t)size + 1)) == NULL)
+    {
+        Debug_LOG_ERROR("Failed to allocate memory");
+        err = OS_ERROR_INSUFFICIENT_SPACE;
+    }
+    else if (fread(self->data, 1, (size_t)size, f) != (size_t)size)
+    {
+        Debug_LOG_ERROR("Failed to read %s", path);
+        err = OS_ERROR_GENERIC;
+    }
+    else
+    {
+        self->data[size] = '\0';
+    }
+
+    fclose(f);
+
+    return err;
+}
+
+static
+OS_Error_t
+ConfigTool_BatchTableAddCell(
+    ConfigTool_BatchTable_t* self,
+    size_t* capacity,
+    size_t count,
+    char* cell)
+{
+    if (count == *capacity)
+    {
+        size_t newCapacity = (*capacity > 0) ? (*capacity * 2) :
+                             BATCH_TABLE_INITIAL_CELLS;
+        char** newCells = realloc(self->cells, newCapacity * sizeof(char*));
+        if (newCells == NULL)
+        {
+            Debug_LOG_ERROR("Failed to allocate memory");
+            return OS_ERROR_INSUFFICIENT_SPACE;
+        }
+        self->cells = newCells;
+        *capacity = newCapacity;
+    }
+
+    self->cells[count] = cell;
+
+    return OS_SUCCESS;
+}
+
+/* Splits the content into cells in place. Unquoting never makes a field
+ * longer, so the unquoted text is written over the raw text.
+ */
+static
+OS_Error_t
+ConfigTool_BatchTableParse(
+    ConfigTool_BatchTable_t* self,
+    char delimiter)
+{
+    char* in = self->data;
+    size_t capacity = 0;
+    size_t count = 0;
+    size_t rowStart = 0;
+    size_t line = 1;
+    bool isCellPending = false;
+
+    // Skips the byte order mark spreadsheet applications like to write
+    if (strncmp(in, "\xEF\xBB\xBF", 3) == 0)
+    {
+        in += 3;
+    }
+
+    // A delimiter at the end of the content is followed by an empty cell
+    while ((*in != '\0') || isCellPending)
+    {
+        // Empty lines do not form rows
+        if ((count == rowStart) && ((*in == '\n') || (*in == '\r')))
+        {
+            line += (*in == '\n') ? 1 : 0;
+            in++;
+            continue;
+        }
+
+        char* cell = in;
+        char* out = in;
+
+        if ((delimiter == ',') && (*in == '"'))
+        {
+            in++;
+            for (;;)
+            {
+                if (*in == '\0')
+                {
+                    Debug_LOG_ERROR("Unterminated quotes in line %zu", line);
+                    return OS_ERROR_INVALID_PARAMETER;
+                }
+                if (*in == '"')
+                {
+                    if (in[1] != '"')
+                    {
+                        in++;
+                        break;
+                    }
+                    in++;
+                }
+                line += (*in == '\n') ? 1 : 0;
+                *out++ = *in++;
+            }
+        }
+        else
+        {
+            while ((*in != '\0') && (*in != delimiter) && (*in != '\n')
+                   && (*in != '\r'))
+            {
+                *out++ = *in++;
+            }
+        }
+
+        if ((*in != '\0') && (*in != delimiter) && (*in != '\n')
+            && (*in != '\r'))
+        {
+            Debug_LOG_ERROR("Unexpected text after quotes in line %zu", line);
+            return OS_ERROR_INVALID_PARAMETER;
+        }
+
+        bool isRowEnd = (*in != delimiter);
+        if (*in == '\r')
+        {
+            in++;
+        }
+        if (*in != '\0')
+        {
+            line += (*in == '\n') ? 1 : 0;
+            in++;
+        }
+        *out = '\0';
+
+        OS_Error_t err = ConfigTool_BatchTableAddCell(self, &capacity, count,
+                                                      cell);
+        if (err != OS_SUCCESS)
+        {
+            return err;
+        }
+        count++;
+
+        isCellPending = !isRowEnd;
+        if (!isRowEnd)
+        {
+            continue;
+        }
+
+        // The header defines the number of columns
+        if (rowStart == 0)
+        {
+            self->columns = count;
+        }
+        else if ((count - rowStart) != self->columns)
+        {
+            Debug_LOG_ERROR("Row ending in line %zu has %zu instead of %zu "
+                            "columns", line - 1, count - rowStart,
+                            self->columns);
+            return OS_ERROR_INVALID_PARAMETER;
+        }
+        rowStart = count;
+    }
+
+    if (self->columns == 0)
+    {
+        Debug_LOG_ERROR("Table has no header");
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    self->rows = count / self->columns - 1;
+
+    return OS_SUCCESS;
+}
+
+
+/* Exported functions --------------------------------------------------------*/
+OS_Error_t
+ConfigTool_BatchTableLoad(
+    ConfigTool_BatchTable_t* self,
+    const char* path)
+{
+    memset(self, 0, sizeof(ConfigTool_BatchTable_t));
+
+    OS_Error_t err = ConfigTool_BatchTableReadFile(self, path);
+    if (err != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    size_t len = strlen(path);
+    char delimiter = ((len >= 4) && (strcmp(&path[len - 4], ".csv") == 0)) ?
+                     ',' : '\t';
+
+    err = ConfigTool_BatchTableParse(self, delimiter);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("Parsing %s failed with %d", path, err);
+        ConfigTool_BatchTableFree(self);
+        return err;
+    }
+
+    return OS_SUCCESS;
+}
+
+const char*
+ConfigTool_BatchTableGetHeader(
+    const ConfigTool_BatchTable_t* self,
+    size_t column)
+{
+    return self->cells[column];
+}
+
+const char*
+ConfigTool_BatchTableGetCell(
+    const ConfigTool_BatchTable_t* self,
+    size_t row,
+    size_t column)
+{
+    return self->cells[(row + 1) * self->columns + column];
+}
+
+void
+ConfigTool_BatchTableFree(
+    ConfigTool_BatchTable_t* self)
+{
+    free(self->cells);
+    free(self->data);
+
+    memset(self, 0, sizeof(ConfigTool_BatchTable_t));
+}
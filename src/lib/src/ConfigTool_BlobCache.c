@@ -0,0 +1,294 @@
+/*
+ * Cache of the blob files referenced by a configuration
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "lib_debug/Debug.h"
+#include "ConfigTool_BlobCache.h"
+#include "ConfigTool_Util.h"
+
+
+/* Private functions ---------------------------------------------------------*/
+static
+uint32_t*
+ConfigTool_BlobCacheFindBucket(
+    const ConfigTool_BlobCache_t* self,
+    const char* path,
+    uint64_t hash)
+{
+    uint32_t* bucket = ConfigTool_UtilHashTableFirst(&self->table, hash);
+
+    for (; *bucket != 0; bucket = ConfigTool_UtilHashTableNext(&self->table,
+                                                               bucket))
+    {
+        const ConfigTool_BlobCacheEntry_t* entry = &self->entries[*bucket - 1];
+        if ((entry->hash == hash) && (strcmp(entry->path, path) == 0))
+        {
+            break;
+        }
+    }
+
+    return bucket;
+}
+
+static
+OS_Error_t
+ConfigTool_BlobCacheFindContentBucket(
+    const ConfigTool_BlobCache_t* self,
+    const ConfigTool_BlobSource_t* source,
+    uint64_t contentHash,
+    uint32_t** bucket)
+{
+    for (*bucket = ConfigTool_UtilHashTableFirst(&self->contentTable,
+                                                 contentHash);
+         **bucket != 0;
+         *bucket = ConfigTool_UtilHashTableNext(&self->contentTable, *bucket))
+    {
+        const ConfigTool_BlobCacheEntry_t* entry = &self->entries[**bucket - 1];
+        if (entry->contentHash != contentHash)
+        {
+            continue;
+        }
+
+        // A hash match is confirmed by the content, so collisions are harmless
+        bool isEqual;
+        OS_Error_t err = ConfigTool_BlobSourceEqual(
+                             &entry->source,
+                             source,
+                             &isEqual);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("ConfigTool_BlobSourceEqual() failed with %d", err);
+            return err;
+        }
+
+        if (isEqual)
+        {
+            break;
+        }
+    }
+
+    return OS_SUCCESS;
+}
+
+static
+OS_Error_t
+ConfigTool_BlobCacheGrow(
+    ConfigTool_BlobCache_t* self)
+{
+    bool isRehashNeeded;
+    OS_Error_t err = ConfigTool_UtilHashTableReserve(&self->table, self->count,
+                                                     &isRehashNeeded);
+    if (err != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    // The resolved paths are unique, so no comparison is needed
+    for (uint32_t i = 0; isRehashNeeded && (i < self->count); i++)
+    {
+        ConfigTool_UtilHashTableInsert(&self->table, self->entries[i].hash, i);
+    }
+
+    err = ConfigTool_UtilHashTableReserve(&self->contentTable, self->count,
+                                          &isRehashNeeded);
+    if (err != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    // Entries holding content are unique by their content
+    for (uint32_t i = 0; isRehashNeeded && (i < self->count); i++)
+    {
+        if (self->entries[i].contentEntry == i)
+        {
+            ConfigTool_UtilHashTableInsert(&self->contentTable,
+                                           self->entries[i].contentHash, i);
+        }
+    }
+
+    if (self->count == self->capacity)
+    {
+        uint32_t capacity = (self->capacity > 0) ?
+                            (self->capacity * 2) :
+                            CONFIG_TOOL_UTIL_HASH_TABLE_INITIAL_BUCKETS;
+        ConfigTool_BlobCacheEntry_t* entries = realloc(
+                                                   self->entries,
+                                                   capacity * sizeof(ConfigTool_BlobCacheEntry_t));
+        if (entries == NULL)
+        {
+            Debug_LOG_ERROR("Failed to allocate memory");
+            return OS_ERROR_INSUFFICIENT_SPACE;
+        }
+
+        self->entries = entries;
+        self->capacity = capacity;
+    }
+
+    return OS_SUCCESS;
+}
+
+
+/* Public functions ----------------------------------------------------------*/
+void
+ConfigTool_BlobCacheInit(
+    ConfigTool_BlobCache_t* self)
+{
+    memset(self, 0, sizeof(ConfigTool_BlobCache_t));
+}
+
+void
+ConfigTool_BlobCacheFree(
+    ConfigTool_BlobCache_t* self)
+{
+    for (uint32_t i = 0; i < self->count; i++)
+    {
+        free(self->entries[i].path);
+        ConfigTool_BlobSourceClose(&self->entries[i].source);
+    }
+
+    free(self->entries);
+    ConfigTool_UtilHashTableFree(&self->table);
+    ConfigTool_UtilHashTableFree(&self->contentTable);
+
+    memset(self, 0, sizeof(ConfigTool_BlobCache_t));
+}
+
+OS_Error_t
+ConfigTool_BlobCacheLoad(
+    ConfigTool_BlobCache_t* self,
+    const char* filePath,
+    uint32_t* entryIndex,
+    bool* isNewContent)
+{
+    // Key the cache by the resolved path, so different spellings share an entry
+    char* path = realpath(filePath, NULL);
+    if (path == NULL)
+    {
+        Debug_LOG_ERROR("Failed to resolve blob file path %s", filePath);
+        return OS_ERROR_GENERIC;
+    }
+
+    OS_Error_t err = ConfigTool_BlobCacheGrow(self);
+    if (err != OS_SUCCESS)
+    {
+        free(path);
+        return err;
+    }
+
+    uint64_t hash = ConfigTool_UtilHash(path, strlen(path));
+    uint32_t* bucket = ConfigTool_BlobCacheFindBucket(self, path, hash);
+    if (*bucket != 0)
+    {
+        Debug_LOG_DEBUG("Blob file %s served from cache", path);
+        free(path);
+        *entryIndex = self->entries[*bucket - 1].contentEntry;
+        *isNewContent = false;
+        return OS_SUCCESS;
+    }
+
+    ConfigTool_BlobCacheEntry_t* entry = &self->entries[self->count];
+
+    err = ConfigTool_BlobSourceOpen(&entry->source, path);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_BlobSourceOpen() failed with %d", err);
+        free(path);
+        return err;
+    }
+
+    uint64_t contentHash;
+    err = ConfigTool_BlobSourceHash(&entry->source, &contentHash);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_BlobSourceHash() failed with %d", err);
+        ConfigTool_BlobSourceClose(&entry->source);
+        free(path);
+        return err;
+    }
+
+    uint32_t* contentBucket;
+    err = ConfigTool_BlobCacheFindContentBucket(
+              self,
+              &entry->source,
+              contentHash,
+              &contentBucket);
+    if (err != OS_SUCCESS)
+    {
+        ConfigTool_BlobSourceClose(&entry->source);
+        free(path);
+        return err;
+    }
+
+    entry->path = path;
+    entry->hash = hash;
+    entry->contentHash = contentHash;
+    /* The blob value is terminated by a zero byte as the consumers of textual
+     * blobs, e.g. PEM certificates, rely on it. The terminator is not part of
+     * the file, it is provided by the zero padding of the last block.
+     */
+    entry->size = entry->source.length + 1;
+    entry->mtime = entry->source.mtime;
+
+    if (*contentBucket != 0)
+    {
+        // The content is already held by another entry, so it is not kept twice
+        entry->contentEntry = *contentBucket - 1;
+        ConfigTool_BlobSourceClose(&entry->source);
+        Debug_LOG_DEBUG("Blob file %s has the same content as %s", path,
+                        self->entries[entry->contentEntry].path);
+        *isNewContent = false;
+    }
+    else
+    {
+        entry->contentEntry = self->count;
+        *contentBucket = self->count + 1;
+        *isNewContent = true;
+    }
+
+    *bucket = self->count + 1;
+    *entryIndex = entry->contentEntry;
+    self->count++;
+
+    return OS_SUCCESS;
+}
+
+const ConfigTool_BlobCacheEntry_t*
+ConfigTool_BlobCacheGetEntry(
+    const ConfigTool_BlobCache_t* self,
+    uint32_t entryIndex)
+{
+    return &self->entries[entryIndex];
+}
+
+bool
+ConfigTool_BlobCacheIsModified(
+    const ConfigTool_BlobCache_t* self)
+{
+    for (uint32_t i = 0; i < self->count; i++)
+    {
+        const ConfigTool_BlobCacheEntry_t* entry = &self->entries[i];
+        struct stat st;
+
+        if ((stat(entry->path, &st) != 0)
+            || (st.st_mtim.tv_sec != entry->mtime.tv_sec)
+            || (st.st_mtim.tv_nsec != entry->mtime.tv_nsec)
+            || ((uint64_t)st.st_size != (entry->size - 1)))
+        {
+            Debug_LOG_DEBUG("Blob file %s was modified", entry->path);
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,263 @@
+/*
+ * Read-only, binary-safe access to the content of a blob file
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "lib_debug/Debug.h"
+#include "ConfigTool_BlobSource.h"
+#include "ConfigTool_Stats.h"
+#include "ConfigTool_Util.h"
+
+
+/* Defines -------------------------------------------------------------------*/
+// Piece size in which streamed content is hashed and compared
+#define BLOB_SOURCE_CHUNK_SIZE  4096
+
+
+/* Public functions ----------------------------------------------------------*/
+OS_Error_t
+ConfigTool_BlobSourceOpen(
+    ConfigTool_BlobSource_t* self,
+    const char* filePath)
+{
+    memset(self, 0, sizeof(ConfigTool_BlobSource_t));
+    self->fd = -1;
+
+    int fd = open(filePath, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        Debug_LOG_ERROR("Failed to open file %s!", filePath);
+        return OS_ERROR_GENERIC;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        Debug_LOG_ERROR("fstat() failed for %s", filePath);
+        close(fd);
+        return OS_ERROR_GENERIC;
+    }
+
+    if (!S_ISREG(st.st_mode))
+    {
+        Debug_LOG_ERROR("%s is not a regular file", filePath);
+        close(fd);
+        return OS_ERROR_GENERIC;
+    }
+
+    self->mtime = st.st_mtim;
+
+    // Large files are kept open and read block by block when written
+    if (st.st_size > CONFIG_TOOL_BLOB_SOURCE_MAP_LIMIT)
+    {
+        self->length = st.st_size;
+        self->fd = fd;
+
+        return OS_SUCCESS;
+    }
+
+    // An empty file can not be mapped, it simply has no data
+    if (st.st_size > 0)
+    {
+        void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            Debug_LOG_ERROR("mmap() failed for %s", filePath);
+            close(fd);
+            return OS_ERROR_GENERIC;
+        }
+
+        self->data = data;
+        self->length = st.st_size;
+
+        // The mapping is read by the hash of the blob cache at the latest
+        ConfigTool_StatsAddBlobRead(st.st_size);
+    }
+
+    // The mapping stays valid after closing the file
+    close(fd);
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+ConfigTool_BlobSourceRead(
+    const ConfigTool_BlobSource_t* self,
+    size_t offset,
+    void* buffer,
+    size_t length)
+{
+    if ((offset > self->length) || (length > (self->length - offset)))
+    {
+        Debug_LOG_ERROR("Read of %zu bytes at %zu exceeds blob length %zu",
+                        length, offset, self->length);
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    if (self->fd < 0)
+    {
+        if (length > 0)
+        {
+            memcpy(buffer, (const char*)self->data + offset, length);
+        }
+        return OS_SUCCESS;
+    }
+
+    size_t bytesRead = 0;
+
+    while (bytesRead < length)
+    {
+        ssize_t ret = pread(self->fd,
+                            (char*)buffer + bytesRead,
+                            length - bytesRead,
+                            offset + bytesRead);
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            Debug_LOG_ERROR("pread() failed with errno %d", errno);
+            return OS_ERROR_GENERIC;
+        }
+
+        // The file was truncated after it has been sized
+        if (ret == 0)
+        {
+            Debug_LOG_ERROR("Unexpected end of blob file at %zu",
+                            offset + bytesRead);
+            return OS_ERROR_GENERIC;
+        }
+
+        bytesRead += ret;
+    }
+
+    ConfigTool_StatsAddBlobRead(bytesRead);
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+ConfigTool_BlobSourceHash(
+    const ConfigTool_BlobSource_t* self,
+    uint64_t* hash)
+{
+    if (!ConfigTool_BlobSourceIsStreamed(self))
+    {
+        *hash = ConfigTool_UtilHash(self->data, self->length);
+        return OS_SUCCESS;
+    }
+
+    char chunk[BLOB_SOURCE_CHUNK_SIZE];
+    uint64_t h = CONFIG_TOOL_UTIL_HASH_INIT;
+
+    for (size_t offset = 0; offset < self->length; offset += sizeof(chunk))
+    {
+        size_t length = self->length - offset;
+        if (length > sizeof(chunk))
+        {
+            length = sizeof(chunk);
+        }
+
+        OS_Error_t err = ConfigTool_BlobSourceRead(self, offset, chunk, length);
+        if (err != OS_SUCCESS)
+        {
+            return OS_ERROR_GENERIC;
+        }
+
+        h = ConfigTool_UtilHashUpdate(h, chunk, length);
+    }
+
+    *hash = h;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+ConfigTool_BlobSourceEqual(
+    const ConfigTool_BlobSource_t* self,
+    const ConfigTool_BlobSource_t* other,
+    bool* isEqual)
+{
+    if (self->length != other->length)
+    {
+        *isEqual = false;
+        return OS_SUCCESS;
+    }
+
+    if (!ConfigTool_BlobSourceIsStreamed(self)
+        && !ConfigTool_BlobSourceIsStreamed(other))
+    {
+        *isEqual = (self->length == 0)
+                   || (memcmp(self->data, other->data, self->length) == 0);
+        return OS_SUCCESS;
+    }
+
+    char chunk[BLOB_SOURCE_CHUNK_SIZE];
+    char otherChunk[BLOB_SOURCE_CHUNK_SIZE];
+
+    for (size_t offset = 0; offset < self->length; offset += sizeof(chunk))
+    {
+        size_t length = self->length - offset;
+        if (length > sizeof(chunk))
+        {
+            length = sizeof(chunk);
+        }
+
+        if ((ConfigTool_BlobSourceRead(self, offset, chunk, length)
+             != OS_SUCCESS)
+            || (ConfigTool_BlobSourceRead(other, offset, otherChunk, length)
+                != OS_SUCCESS))
+        {
+            return OS_ERROR_GENERIC;
+        }
+
+        if (memcmp(chunk, otherChunk, length) != 0)
+        {
+            *isEqual = false;
+            return OS_SUCCESS;
+        }
+    }
+
+    *isEqual = true;
+
+    return OS_SUCCESS;
+}
+
+bool
+ConfigTool_BlobSourceIsStreamed(
+    const ConfigTool_BlobSource_t* self)
+{
+    return (self->fd >= 0);
+}
+
+void
+ConfigTool_BlobSourceClose(
+    ConfigTool_BlobSource_t* self)
+{
+    if (self->data != NULL)
+    {
+        munmap((void*)self->data, self->length);
+    }
+
+    if (self->fd >= 0)
+    {
+        close(self->fd);
+    }
+
+    memset(self, 0, sizeof(ConfigTool_BlobSource_t));
+    self->fd = -1;
+}
@@ -0,0 +1,425 @@
+/*
+ * Decodes the records of existing backend files back into an XML
+ * configuration
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <libgen.h>
+#include <limits.h>
+
+#include "lib_debug/Debug.h"
+#include "ConfigTool_ConfigDumper.h"
+
+
+/* Defines -------------------------------------------------------------------*/
+// Output buffer of the XML file, large configurations are written in one pass
+#define DUMPER_BUFFER_SIZE  (1024 * 1024)
+
+
+/* Private types/enums -------------------------------------------------------*/
+// State of a single dumper run
+typedef struct
+{
+    const ConfigTool_ConfigReader_t* reader; /**< records to decode */
+    FILE* xml;             /**< XML file being written */
+    char* dirPath;         /**< directory of the XML and blob files */
+    const char* baseName;  /**< name of the XML file, prefix of blob files */
+    uint32_t* blobSizes;   /**< size + 1 of the blob written from each blob
+                                record, 0 if none was written */
+} ConfigTool_ConfigDumperContext_t;
+
+
+/* Private functions ---------------------------------------------------------*/
+// Writes text with the characters special to XML escaped
+static
+OS_Error_t
+ConfigTool_ConfigDumperWriteText(
+    FILE* xml,
+    const char* text,
+    size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        unsigned char c = text[i];
+
+        switch (c)
+        {
+        case '&':
+            fputs("&amp;", xml);
+            break;
+        case '<':
+            fputs("&lt;", xml);
+            break;
+        case '>':
+            fputs("&gt;", xml);
+            break;
+        case '"':
+            fputs("&quot;", xml);
+            break;
+        case '\t':
+        case '\n':
+            fputc(c, xml);
+            break;
+        case '\r':
+            // A literal carriage return would be normalized by the parser
+            fputs("&#13;", xml);
+            break;
+        default:
+            if (c < 0x20)
+            {
+                Debug_LOG_ERROR("Control character 0x%02x cannot be represented "
+                                "in XML", c);
+                return OS_ERROR_INVALID_STATE;
+            }
+            fputc(c, xml);
+            break;
+        }
+    }
+
+    return OS_SUCCESS;
+}
+
+// Writes the content of a blob to a file of its own, once per blob record
+static
+OS_Error_t
+ConfigTool_ConfigDumperWriteBlob(
+    ConfigTool_ConfigDumperContext_t* ctx,
+    const OS_ConfigServiceLibTypes_Parameter_t* param,
+    char* fileName,
+    size_t fileNameSize)
+{
+    const void* data;
+    size_t length;
+
+    OS_Error_t err = ConfigTool_ConfigReaderGetBlob(ctx->reader, param, &data,
+                                                    &length);
+    if (err != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    uint32_t index = param->parameterValue.valueBlob.index;
+    uint32_t size = param->parameterValue.valueBlob.size;
+
+    if (snprintf(fileName, fileNameSize, "%s.blob%" PRIu32, ctx->baseName,
+                 index) >= (int)fileNameSize)
+    {
+        Debug_LOG_ERROR("Blob file name for %s too long", ctx->baseName);
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    // Parameters sharing a blob share its records and thereby its file
+    if (ctx->blobSizes[index] != 0)
+    {
+        if (ctx->blobSizes[index] != (size + 1))
+        {
+            Debug_LOG_ERROR("Blob records from %u are shared with different "
+                            "sizes", index);
+            return OS_ERROR_INVALID_STATE;
+        }
+        return OS_SUCCESS;
+    }
+
+    char path[PATH_MAX];
+    if (snprintf(path, sizeof(path), "%s/%s", ctx->dirPath, fileName)
+        >= (int)sizeof(path))
+    {
+        Debug_LOG_ERROR("Blob file path in %s too long", ctx->dirPath);
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    FILE* f = fopen(path, "wb");
+    if (f == NULL)
+    {
+        Debug_LOG_ERROR("fopen() failed for %s with errno %d", path, errno);
+        return OS_ERROR_GENERIC;
+    }
+
+    size_t written = fwrite(data, 1, length, f);
+    if ((fclose(f) != 0) || (written != length))
+    {
+        Debug_LOG_ERROR("Writing %s failed", path);
+        return OS_ERROR_GENERIC;
+    }
+
+    ctx->blobSizes[index] = size + 1;
+
+    return OS_SUCCESS;
+}
+
+static
+OS_Error_t
+ConfigTool_ConfigDumperWriteValue(
+    ConfigTool_ConfigDumperContext_t* ctx,
+    const OS_ConfigServiceLibTypes_Parameter_t* param)
+{
+    FILE* xml = ctx->xml;
+    const char* str;
+    size_t length;
+    char fileName[NAME_MAX + 1];
+    OS_Error_t err;
+
+    switch (param->parameterType)
+    {
+    case OS_CONFIG_LIB_PARAMETER_TYPE_INTEGER32:
+        fprintf(xml, "%" PRIu32, (uint32_t)param->parameterValue.valueInteger32);
+        break;
+
+    case OS_CONFIG_LIB_PARAMETER_TYPE_INTEGER64:
+        fprintf(xml, "%" PRIu64, (uint64_t)param->parameterValue.valueInteger64);
+        break;
+
+    case OS_CONFIG_LIB_PARAMETER_TYPE_STRING:
+        err = ConfigTool_ConfigReaderGetString(ctx->reader, param, &str, &length);
+        if (err != OS_SUCCESS)
+        {
+            return err;
+        }
+        return ConfigTool_ConfigDumperWriteText(xml, str, length);
+
+    case OS_CONFIG_LIB_PARAMETER_TYPE_BLOB:
+        // Blob values are file paths appended to the directory of the XML file
+        err = ConfigTool_ConfigDumperWriteBlob(ctx, param, fileName,
+                                               sizeof(fileName));
+        if (err != OS_SUCCESS)
+        {
+            return err;
+        }
+        fputc('/', xml);
+        return ConfigTool_ConfigDumperWriteText(xml, fileName, strlen(fileName));
+
+    default:
+        Debug_LOG_ERROR("Unsupported parameter type %d", param->parameterType);
+        return OS_ERROR_INVALID_STATE;
+    }
+
+    return OS_SUCCESS;
+}
+
+static
+const char*
+ConfigTool_ConfigDumperGetTypeName(
+    OS_ConfigServiceLibTypes_ParameterType_t type)
+{
+    switch (type)
+    {
+    case OS_CONFIG_LIB_PARAMETER_TYPE_INTEGER32:
+        return "int32";
+    case OS_CONFIG_LIB_PARAMETER_TYPE_INTEGER64:
+        return "int64";
+    case OS_CONFIG_LIB_PARAMETER_TYPE_STRING:
+        return "string";
+    case OS_CONFIG_LIB_PARAMETER_TYPE_BLOB:
+        return "blob";
+    default:
+        return NULL;
+    }
+}
+
+static
+OS_Error_t
+ConfigTool_ConfigDumperWriteParam(
+    ConfigTool_ConfigDumperContext_t* ctx,
+    const OS_ConfigServiceLibTypes_Parameter_t* param)
+{
+    FILE* xml = ctx->xml;
+
+    const char* typeName = ConfigTool_ConfigDumperGetTypeName(
+                               param->parameterType);
+    if (typeName == NULL)
+    {
+        Debug_LOG_ERROR("Unsupported parameter type %d", param->parameterType);
+        return OS_ERROR_INVALID_STATE;
+    }
+
+    fputs("        <param_name>", xml);
+    OS_Error_t err = ConfigTool_ConfigDumperWriteText(
+                         xml,
+                         param->parameterName.name,
+                         strnlen(param->parameterName.name,
+                                 OS_CONFIG_LIB_PARAMETER_NAME_SIZE));
+    if (err != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    fprintf(xml,
+            "</param_name>\n"
+            "        <type>%s</type>\n"
+            "        <access_policy>\n"
+            "            <read>%s</read>\n"
+            "            <write>%s</write>\n"
+            "        </access_policy>\n"
+            "        <value>",
+            typeName,
+            ConfigTool_ConfigReaderHasAccess(&param->readAccess) ?
+            "true" : "false",
+            ConfigTool_ConfigReaderHasAccess(&param->writeAccess) ?
+            "true" : "false");
+
+    err = ConfigTool_ConfigDumperWriteValue(ctx, param);
+    if (err != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    fputs("</value>\n", xml);
+
+    return OS_SUCCESS;
+}
+
+/* Writes the domains with their parameters. The parameters are grouped by
+ * domain with a counting sort, which keeps their record order per domain.
+ */
+static
+OS_Error_t
+ConfigTool_ConfigDumperWriteDomains(
+    ConfigTool_ConfigDumperContext_t* ctx)
+{
+    const ConfigTool_ConfigReader_t* reader = ctx->reader;
+
+    size_t* first = calloc(reader->domainCount + 1, sizeof(size_t));
+    size_t* order = calloc(reader->paramCount + 1, sizeof(size_t));
+    if ((first == NULL) || (order == NULL))
+    {
+        Debug_LOG_ERROR("Failed to allocate memory");
+        free(first);
+        free(order);
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+
+    OS_Error_t err = OS_SUCCESS;
+
+    for (size_t i = 0; i < reader->paramCount; i++)
+    {
+        uint32_t domainIndex = reader->params[i].domain.index;
+        if (domainIndex >= reader->domainCount)
+        {
+            Debug_LOG_ERROR("Parameter record %zu refers to domain %u of %zu",
+                            i, domainIndex, reader->domainCount);
+            err = OS_ERROR_INVALID_STATE;
+            goto exit;
+        }
+        first[domainIndex + 1]++;
+    }
+
+    for (size_t i = 0; i < reader->domainCount; i++)
+    {
+        first[i + 1] += first[i];
+    }
+
+    for (size_t i = 0; i < reader->paramCount; i++)
+    {
+        order[first[reader->params[i].domain.index]++] = i;
+    }
+
+    // The loop above moved every start to the start of the next domain
+    size_t next = 0;
+
+    for (size_t i = 0; i < reader->domainCount; i++)
+    {
+        const char* name = reader->domains[i].name.name;
+
+        fputs("    <domain name=\"", ctx->xml);
+        err = ConfigTool_ConfigDumperWriteText(
+                  ctx->xml,
+                  name,
+                  strnlen(name, OS_CONFIG_LIB_DOMAIN_NAME_SIZE));
+        if (err != OS_SUCCESS)
+        {
+            goto exit;
+        }
+        fputs("\">\n", ctx->xml);
+
+        for (; next < first[i]; next++)
+        {
+            err = ConfigTool_ConfigDumperWriteParam(ctx,
+                                                    &reader->params[order[next]]);
+            if (err != OS_SUCCESS)
+            {
+                Debug_LOG_ERROR("Decoding parameter record %zu failed with %d",
+                                order[next], err);
+                goto exit;
+            }
+        }
+
+        fputs("    </domain>\n", ctx->xml);
+    }
+
+exit:
+    free(first);
+    free(order);
+
+    return err;
+}
+
+
+/* Exported functions --------------------------------------------------------*/
+OS_Error_t
+ConfigTool_ConfigDumperRun(
+    const ConfigTool_ConfigReader_t* reader,
+    const char* xmlPath)
+{
+    ConfigTool_ConfigDumperContext_t ctx = { .reader = reader };
+
+    // dirname() and basename() may modify their input
+    char* dirCopy = strdup(xmlPath);
+    char* baseCopy = strdup(xmlPath);
+    ctx.blobSizes = calloc(reader->blobCount + 1, sizeof(uint32_t));
+    if ((dirCopy == NULL) || (baseCopy == NULL) || (ctx.blobSizes == NULL))
+    {
+        Debug_LOG_ERROR("Failed to allocate memory");
+        free(dirCopy);
+        free(baseCopy);
+        free(ctx.blobSizes);
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+    ctx.dirPath = dirname(dirCopy);
+    ctx.baseName = basename(baseCopy);
+
+    OS_Error_t err = OS_SUCCESS;
+
+    if ((ctx.xml = fopen(xmlPath, "w")) == NULL)
+    {
+        Debug_LOG_ERROR("fopen() failed for %s with errno %d", xmlPath, errno);
+        err = OS_ERROR_GENERIC;
+        goto exit;
+    }
+    setvbuf(ctx.xml, NULL, _IOFBF, DUMPER_BUFFER_SIZE);
+
+    fputs("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+          "<config>\n", ctx.xml);
+
+    err = ConfigTool_ConfigDumperWriteDomains(&ctx);
+
+    fputs("</config>\n", ctx.xml);
+
+    int hasFailed = ferror(ctx.xml);
+    if ((fclose(ctx.xml) != 0) || hasFailed)
+    {
+        Debug_LOG_ERROR("Writing %s failed", xmlPath);
+        if (err == OS_SUCCESS)
+        {
+            err = OS_ERROR_GENERIC;
+        }
+    }
+
+exit:
+    free(dirCopy);
+    free(baseCopy);
+    free(ctx.blobSizes);
+
+    return err;
+}
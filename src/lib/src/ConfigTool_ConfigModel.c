@@ -0,0 +1,578 @@
+/*
+ * Intermediate representation of a parsed configuration
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lib_debug/Debug.h"
+#include "ConfigTool_ConfigModel.h"
+#include "ConfigTool_Util.h"
+
+
+/* Defines -------------------------------------------------------------------*/
+#define MODEL_INITIAL_CAPACITY  64
+
+
+/* Private functions ---------------------------------------------------------*/
+// Doubles the capacity of an array until it can hold the requested entries
+static
+OS_Error_t
+ConfigTool_ConfigModelReserve(
+    void** array,
+    size_t* capacity,
+    size_t required,
+    size_t entrySize)
+{
+    if (required <= *capacity)
+    {
+        return OS_SUCCESS;
+    }
+
+    size_t newCapacity = (*capacity > 0) ? *capacity : MODEL_INITIAL_CAPACITY;
+    while (newCapacity < required)
+    {
+        newCapacity *= 2;
+    }
+
+    void* newArray = realloc(*array, newCapacity * entrySize);
+    if (newArray == NULL)
+    {
+        Debug_LOG_ERROR("Failed to allocate memory");
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+
+    *array = newArray;
+    *capacity = newCapacity;
+
+    return OS_SUCCESS;
+}
+
+static
+OS_Error_t
+ConfigTool_ConfigModelAddValue(
+    ConfigTool_ConfigModel_t* self,
+    ConfigTool_ConfigModelParam_t* param,
+    const char* value)
+{
+    size_t length = strlen(value);
+
+    OS_Error_t err = ConfigTool_ConfigModelReserve(
+                         (void**)&self->values,
+                         &self->valuesCapacity,
+                         self->valuesSize + length + 1,
+                         sizeof(char));
+    if (err != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    memcpy(&self->values[self->valuesSize], value, length + 1);
+
+    param->valueOffset = self->valuesSize;
+    param->valueLength = length;
+    self->valuesSize += length + 1;
+
+    return OS_SUCCESS;
+}
+
+static
+OS_Error_t
+ConfigTool_ConfigModelSizeBlob(
+    ConfigTool_ConfigModel_t* self,
+    ConfigTool_ConfigModelParam_t* param,
+    bool* isNewContent)
+{
+    char* filePath = ConfigTool_ConfigModelGetBlobPath(self, param);
+    if (filePath == NULL)
+    {
+        Debug_LOG_ERROR("Failed to allocate memory");
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+    Debug_LOG_DEBUG("Generated file path %s", filePath);
+
+    OS_Error_t err = ConfigTool_BlobCacheLoad(
+                         &self->blobCache,
+                         filePath,
+                         &param->blobEntry,
+                         isNewContent);
+    free(filePath);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("Invalid blob passed!");
+        return err;
+    }
+
+    const ConfigTool_BlobCacheEntry_t* blob =
+        ConfigTool_ConfigModelGetBlob(self, param);
+
+    param->blobSize = blob->size;
+    param->numberOfBlocks = ConfigTool_UtilCalculateNumberOfBlocks(blob->size);
+
+    return OS_SUCCESS;
+}
+
+// Orders parameters by domain and name, ties by their position in the model
+static
+int
+ConfigTool_ConfigModelCompareParams(
+    const void* a,
+    const void* b)
+{
+    const ConfigTool_ConfigModelParam_t* paramA =
+        *(const ConfigTool_ConfigModelParam_t* const*)a;
+    const ConfigTool_ConfigModelParam_t* paramB =
+        *(const ConfigTool_ConfigModelParam_t* const*)b;
+
+    if (paramA->domainIndex != paramB->domainIndex)
+    {
+        return (paramA->domainIndex < paramB->domainIndex) ? -1 : 1;
+    }
+
+    int cmp = strncmp(paramA->name, paramB->name, sizeof(paramA->name));
+    if (cmp != 0)
+    {
+        return cmp;
+    }
+
+    return (paramA < paramB) ? -1 : (paramA > paramB);
+}
+
+
+/* Public functions ----------------------------------------------------------*/
+OS_Error_t
+ConfigTool_ConfigModelInit(
+    ConfigTool_ConfigModel_t* self,
+    const char* dirPath)
+{
+    memset(self, 0, sizeof(ConfigTool_ConfigModel_t));
+    ConfigTool_BlobCacheInit(&self->blobCache);
+    ConfigTool_StringPoolInit(&self->stringPool);
+
+    self->dirPath = strdup(dirPath);
+    if (self->dirPath == NULL)
+    {
+        Debug_LOG_ERROR("Failed to allocate memory");
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+
+    return OS_SUCCESS;
+}
+
+void
+ConfigTool_ConfigModelFree(
+    ConfigTool_ConfigModel_t* self)
+{
+    free(self->domains);
+    free(self->params);
+    free(self->values);
+    free(self->dirPath);
+    ConfigTool_BlobCacheFree(&self->blobCache);
+    ConfigTool_StringPoolFree(&self->stringPool);
+
+    memset(self, 0, sizeof(ConfigTool_ConfigModel_t));
+}
+
+OS_Error_t
+ConfigTool_ConfigModelAddDomain(
+    ConfigTool_ConfigModel_t* self,
+    const char* name)
+{
+    OS_Error_t err = ConfigTool_ConfigModelReserve(
+                         (void**)&self->domains,
+                         &self->domainCapacity,
+                         self->counter.domain_count + 1,
+                         sizeof(ConfigTool_ConfigModelDomain_t));
+    if (err != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    ConfigTool_ConfigModelDomain_t* domain =
+        &self->domains[self->counter.domain_count];
+
+    ConfigTool_UtilInitializeName(
+        domain->name,
+        sizeof(domain->name),
+        name);
+
+    self->counter.domain_count++;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+ConfigTool_ConfigModelAddParam(
+    ConfigTool_ConfigModel_t* self,
+    ConfigTool_ConfigServiceParamType_t type,
+    const char* name,
+    bool hasReadAccess,
+    bool hasWriteAccess,
+    const char* value)
+{
+    // Every parameter belongs to a domain, the records refer to it by index
+    if (self->counter.domain_count == 0)
+    {
+        Debug_LOG_ERROR("Parameter %s is not inside a domain", name);
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    bool isNewContent;
+    OS_Error_t err = ConfigTool_ConfigModelReserve(
+                         (void**)&self->params,
+                         &self->paramCapacity,
+                         self->counter.param_count + 1,
+                         sizeof(ConfigTool_ConfigModelParam_t));
+    if (err != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    ConfigTool_ConfigModelParam_t* param =
+        &self->params[self->counter.param_count];
+    memset(param, 0, sizeof(ConfigTool_ConfigModelParam_t));
+
+    param->type = type;
+    param->hasReadAccess = hasReadAccess;
+    param->hasWriteAccess = hasWriteAccess;
+
+    param->domainIndex = self->counter.domain_count - 1;
+
+    ConfigTool_UtilInitializeName(
+        param->name,
+        sizeof(param->name),
+        name);
+
+    err = ConfigTool_ConfigModelAddValue(self, param, value);
+    if (err != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    switch (type)
+    {
+    case INT32:
+    case INT64:
+        break;
+
+    case STRING:
+        /* Equal values share one record, the value is compared as stored,
+         * i.e. truncated to the maximum string size.
+         */
+        err = ConfigTool_StringPoolIntern(
+                  &self->stringPool,
+                  self->values,
+                  param->valueOffset,
+                  (param->valueLength < OS_CONFIG_LIB_PARAMETER_MAX_STRING_SIZE) ?
+                  param->valueLength : (OS_CONFIG_LIB_PARAMETER_MAX_STRING_SIZE - 1),
+                  &param->stringEntry);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("ConfigTool_StringPoolIntern() failed with %d", err);
+            return err;
+        }
+        self->counter.string_count = self->stringPool.count;
+        break;
+
+    case BLOB:
+        err = ConfigTool_ConfigModelSizeBlob(self, param, &isNewContent);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("ConfigTool_ConfigModelSizeBlob() failed with %d", err);
+            return err;
+        }
+        // Blobs with the same content share their records
+        if (!isNewContent)
+        {
+            break;
+        }
+        if (param->numberOfBlocks > (UINT32_MAX - self->counter.blob_count))
+        {
+            Debug_LOG_ERROR("Blob blocks exceed the addressable range of %s",
+                            BLOB_FILE);
+            return OS_ERROR_INSUFFICIENT_SPACE;
+        }
+        self->counter.blob_count += param->numberOfBlocks;
+        break;
+
+    default:
+        Debug_LOG_ERROR("Unsupported parameter type!");
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    self->counter.param_count++;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+ConfigTool_ConfigModelFindParam(
+    const ConfigTool_ConfigModel_t* self,
+    const char* domainName,
+    const char* paramName,
+    uint32_t* paramIndex)
+{
+    // Names are stored truncated to their fields, compare them the same way
+    char domain[OS_CONFIG_LIB_DOMAIN_NAME_SIZE];
+    char name[OS_CONFIG_LIB_PARAMETER_NAME_SIZE];
+
+    ConfigTool_UtilInitializeName(domain, sizeof(domain), domainName);
+    ConfigTool_UtilInitializeName(name, sizeof(name), paramName);
+
+    for (uint32_t i = 0; i < self->counter.param_count; i++)
+    {
+        const ConfigTool_ConfigModelParam_t* param = &self->params[i];
+        if ((strncmp(param->name, name, sizeof(name)) == 0)
+            && (strncmp(self->domains[param->domainIndex].name, domain,
+                        sizeof(domain)) == 0))
+        {
+            *paramIndex = i;
+            return OS_SUCCESS;
+        }
+    }
+
+    return OS_ERROR_NOT_FOUND;
+}
+
+OS_Error_t
+ConfigTool_ConfigModelFindQualifiedParam(
+    const ConfigTool_ConfigModel_t* self,
+    const char* qualifiedName,
+    uint32_t* paramIndex)
+{
+    char* name = strdup(qualifiedName);
+    if (name == NULL)
+    {
+        Debug_LOG_ERROR("Failed to allocate memory");
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+
+    OS_Error_t err = OS_ERROR_NOT_FOUND;
+    for (char* dot = strchr(name, '.'); dot != NULL; dot = strchr(dot + 1, '.'))
+    {
+        *dot = '\0';
+        err = ConfigTool_ConfigModelFindParam(self, name, dot + 1, paramIndex);
+        *dot = '.';
+        if (err == OS_SUCCESS)
+        {
+            break;
+        }
+    }
+
+    free(name);
+
+    return err;
+}
+
+OS_Error_t
+ConfigTool_ConfigModelSetValue(
+    ConfigTool_ConfigModel_t* self,
+    uint32_t paramIndex,
+    const char* value)
+{
+    ConfigTool_ConfigModelParam_t* param = &self->params[paramIndex];
+    uint64_t integer;
+    OS_Error_t err;
+
+    // Unlike the XML file, a new value is checked before it replaces the old
+    if ((param->type == INT32) || (param->type == INT64))
+    {
+        err = ConfigTool_UtilParseInteger(
+                  value,
+                  (param->type == INT32) ? UINT32_MAX : UINT64_MAX,
+                  &integer);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("Invalid value %s for parameter %s", value,
+                            param->name);
+            return err;
+        }
+    }
+
+    err = ConfigTool_ConfigModelAddValue(self, param, value);
+    if (err != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    // The records of the blob are counted by ConfigTool_ConfigModelRecount()
+    if (param->type == BLOB)
+    {
+        bool isNewContent;
+        err = ConfigTool_ConfigModelSizeBlob(self, param, &isNewContent);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("ConfigTool_ConfigModelSizeBlob() failed with %d", err);
+            return err;
+        }
+    }
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+ConfigTool_ConfigModelRecount(
+    ConfigTool_ConfigModel_t* self)
+{
+    // Blob cache entries no longer referenced must not be counted
+    bool* blobCounted = calloc(self->blobCache.count + 1, sizeof(bool));
+    if (blobCounted == NULL)
+    {
+        Debug_LOG_ERROR("Failed to allocate memory");
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+
+    ConfigTool_StringPoolFree(&self->stringPool);
+    ConfigTool_StringPoolInit(&self->stringPool);
+    self->counter.string_count = 0;
+    self->counter.blob_count = 0;
+
+    OS_Error_t err = OS_SUCCESS;
+
+    for (uint32_t i = 0; i < self->counter.param_count; i++)
+    {
+        ConfigTool_ConfigModelParam_t* param = &self->params[i];
+
+        if (param->type == STRING)
+        {
+            err = ConfigTool_StringPoolIntern(
+                      &self->stringPool,
+                      self->values,
+                      param->valueOffset,
+                      (param->valueLength < OS_CONFIG_LIB_PARAMETER_MAX_STRING_SIZE) ?
+                      param->valueLength : (OS_CONFIG_LIB_PARAMETER_MAX_STRING_SIZE - 1),
+                      &param->stringEntry);
+            if (err != OS_SUCCESS)
+            {
+                Debug_LOG_ERROR("ConfigTool_StringPoolIntern() failed with %d", err);
+                break;
+            }
+        }
+        else if ((param->type == BLOB) && !blobCounted[param->blobEntry])
+        {
+            if (param->numberOfBlocks > (UINT32_MAX - self->counter.blob_count))
+            {
+                Debug_LOG_ERROR("Blob blocks exceed the addressable range of %s",
+                                BLOB_FILE);
+                err = OS_ERROR_INSUFFICIENT_SPACE;
+                break;
+            }
+            blobCounted[param->blobEntry] = true;
+            self->counter.blob_count += param->numberOfBlocks;
+        }
+    }
+
+    self->counter.string_count = self->stringPool.count;
+    free(blobCounted);
+
+    return err;
+}
+
+OS_Error_t
+ConfigTool_ConfigModelClusterDomains(
+    ConfigTool_ConfigModel_t* self)
+{
+    uint32_t paramCount = self->counter.param_count;
+
+    // The parameters are sorted by reference, then moved once
+    const ConfigTool_ConfigModelParam_t** order =
+        malloc((paramCount + 1) * sizeof(*order));
+    ConfigTool_ConfigModelParam_t* params =
+        malloc((paramCount + 1) * sizeof(*params));
+    if ((order == NULL) || (params == NULL))
+    {
+        Debug_LOG_ERROR("Failed to allocate memory");
+        free(order);
+        free(params);
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+
+    for (uint32_t i = 0; i < paramCount; i++)
+    {
+        order[i] = &self->params[i];
+    }
+    qsort(order, paramCount, sizeof(*order),
+          ConfigTool_ConfigModelCompareParams);
+
+    for (uint32_t i = 0; i < paramCount; i++)
+    {
+        params[i] = *order[i];
+    }
+    free(order);
+
+    free(self->params);
+    self->params = params;
+    self->paramCapacity = paramCount + 1;
+    self->isClustered = true;
+
+    // String records are numbered in the order of their first use
+    return ConfigTool_ConfigModelRecount(self);
+}
+
+uint32_t
+ConfigTool_ConfigModelGetDomainStart(
+    const ConfigTool_ConfigModel_t* self,
+    uint32_t domainIndex)
+{
+    uint32_t first = 0;
+    uint32_t end = self->counter.param_count;
+
+    // First parameter not belonging to an earlier domain
+    while (first < end)
+    {
+        uint32_t mid = first + ((end - first) / 2);
+        if (self->params[mid].domainIndex < domainIndex)
+        {
+            first = mid + 1;
+        }
+        else
+        {
+            end = mid;
+        }
+    }
+
+    return first;
+}
+
+const char*
+ConfigTool_ConfigModelGetValue(
+    const ConfigTool_ConfigModel_t* self,
+    const ConfigTool_ConfigModelParam_t* param)
+{
+    return &self->values[param->valueOffset];
+}
+
+char*
+ConfigTool_ConfigModelGetBlobPath(
+    const ConfigTool_ConfigModel_t* self,
+    const ConfigTool_ConfigModelParam_t* param)
+{
+    const char* value = ConfigTool_ConfigModelGetValue(self, param);
+
+    char* filePath = malloc(strlen(self->dirPath) + param->valueLength + 1);
+    if (filePath == NULL)
+    {
+        return NULL;
+    }
+
+    strcpy(filePath, self->dirPath);
+    strcat(filePath, value);
+
+    return filePath;
+}
+
+const ConfigTool_BlobCacheEntry_t*
+ConfigTool_ConfigModelGetBlob(
+    const ConfigTool_ConfigModel_t* self,
+    const ConfigTool_ConfigModelParam_t* param)
+{
+    return ConfigTool_BlobCacheGetEntry(&self->blobCache, param->blobEntry);
+}
@@ -0,0 +1,427 @@
+/*
+ * Rewrites the values of single parameters in existing configuration library
+ * backends
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "lib_debug/Debug.h"
+#include "ConfigTool_ConfigPatcher.h"
+#include "ConfigTool_Util.h"
+
+
+/* Private types/enums -------------------------------------------------------*/
+// Records of the backends, read once for all lookups
+typedef struct
+{
+    OS_ConfigServiceLib_t* configLib;             /**< library holding the records */
+    OS_ConfigServiceLibTypes_Domain_t* domains;   /**< all domain records */
+    size_t domainCount;                           /**< number of domains */
+    OS_ConfigServiceLibTypes_Parameter_t* params; /**< all parameter records */
+    size_t paramCount;                            /**< number of parameters */
+    const char* blobDir;                          /**< directory of blob files */
+} ConfigTool_ConfigPatcherContext_t;
+
+
+/* Private functions ---------------------------------------------------------*/
+static
+OS_Error_t
+ConfigTool_ConfigPatcherReadRecords(
+    OS_ConfigServiceBackend_t* backend,
+    size_t recordSize,
+    void** records,
+    size_t* recordCount)
+{
+    size_t count = OS_ConfigServiceBackend_getNumberOfRecords(backend);
+
+    // One extra record keeps the allocation valid for empty backends
+    char* buf = calloc(count + 1, recordSize);
+    if (buf == NULL)
+    {
+        Debug_LOG_ERROR("Failed to allocate memory");
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        OS_Error_t err = OS_ConfigServiceBackend_readRecord(
+                             backend,
+                             i,
+                             &buf[i * recordSize],
+                             recordSize);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("OS_ConfigServiceBackend_readRecord() failed with %d",
+                            err);
+            free(buf);
+            return err;
+        }
+    }
+
+    *records = buf;
+    *recordCount = count;
+
+    return OS_SUCCESS;
+}
+
+static
+OS_Error_t
+ConfigTool_ConfigPatcherFindParam(
+    const ConfigTool_ConfigPatcherContext_t* ctx,
+    const char* domainName,
+    const char* paramName,
+    size_t* paramIndex)
+{
+    char domain[OS_CONFIG_LIB_DOMAIN_NAME_SIZE];
+    char name[OS_CONFIG_LIB_PARAMETER_NAME_SIZE];
+
+    ConfigTool_UtilInitializeName(domain, sizeof(domain), domainName);
+    ConfigTool_UtilInitializeName(name, sizeof(name), paramName);
+
+    for (size_t d = 0; d < ctx->domainCount; d++)
+    {
+        if (strncmp(ctx->domains[d].name.name, domain, sizeof(domain)) != 0)
+        {
+            continue;
+        }
+
+        for (size_t i = 0; i < ctx->paramCount; i++)
+        {
+            if ((ctx->params[i].domain.index == d)
+                && (strncmp(ctx->params[i].parameterName.name, name,
+                            sizeof(name)) == 0))
+            {
+                *paramIndex = i;
+                return OS_SUCCESS;
+            }
+        }
+    }
+
+    return OS_ERROR_NOT_FOUND;
+}
+
+// Domain names may contain dots themselves, so every dot is tried as separator
+static
+OS_Error_t
+ConfigTool_ConfigPatcherFindQualifiedParam(
+    const ConfigTool_ConfigPatcherContext_t* ctx,
+    const char* qualifiedName,
+    size_t* paramIndex)
+{
+    char* name = strdup(qualifiedName);
+    if (name == NULL)
+    {
+        Debug_LOG_ERROR("Failed to allocate memory");
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+
+    OS_Error_t err = OS_ERROR_NOT_FOUND;
+    for (char* dot = strchr(name, '.'); dot != NULL; dot = strchr(dot + 1, '.'))
+    {
+        *dot = '\0';
+        err = ConfigTool_ConfigPatcherFindParam(ctx, name, dot + 1, paramIndex);
+        *dot = '.';
+        if (err == OS_SUCCESS)
+        {
+            break;
+        }
+    }
+
+    free(name);
+
+    return err;
+}
+
+// Checks whether another parameter refers to the same string or blob records
+static
+bool
+ConfigTool_ConfigPatcherIsShared(
+    const ConfigTool_ConfigPatcherContext_t* ctx,
+    size_t paramIndex)
+{
+    const OS_ConfigServiceLibTypes_Parameter_t* param = &ctx->params[paramIndex];
+
+    for (size_t i = 0; i < ctx->paramCount; i++)
+    {
+        const OS_ConfigServiceLibTypes_Parameter_t* other = &ctx->params[i];
+
+        if ((i == paramIndex) || (other->parameterType != param->parameterType))
+        {
+            continue;
+        }
+
+        if ((param->parameterType == OS_CONFIG_LIB_PARAMETER_TYPE_STRING)
+            && (other->parameterValue.valueString.index
+                == param->parameterValue.valueString.index))
+        {
+            return true;
+        }
+
+        if ((param->parameterType == OS_CONFIG_LIB_PARAMETER_TYPE_BLOB)
+            && (other->parameterValue.valueBlob.index
+                == param->parameterValue.valueBlob.index))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static
+OS_Error_t
+ConfigTool_ConfigPatcherSetString(
+    ConfigTool_ConfigPatcherContext_t* ctx,
+    OS_ConfigServiceLibTypes_Parameter_t* param,
+    const char* value)
+{
+    char str[OS_CONFIG_LIB_PARAMETER_MAX_STRING_SIZE];
+    memset(str, 0, sizeof(str));
+    strncpy(str, value, (sizeof(str) - 1));
+
+    OS_Error_t err = OS_ConfigServiceBackend_writeRecord(
+                         &ctx->configLib->stringBackend,
+                         param->parameterValue.valueString.index,
+                         str,
+                         sizeof(str));
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("OS_ConfigServiceBackend_writeRecord() failed with: %d", err);
+        return err;
+    }
+
+    param->parameterValue.valueString.size = strlen(str) + 1;
+
+    return OS_SUCCESS;
+}
+
+// Rewrites the blocks of the blob, the blocks no longer used are zeroed
+static
+OS_Error_t
+ConfigTool_ConfigPatcherSetBlob(
+    ConfigTool_ConfigPatcherContext_t* ctx,
+    OS_ConfigServiceLibTypes_Parameter_t* param,
+    const char* value)
+{
+    OS_ConfigServiceBackend_t* backend = &ctx->configLib->blobBackend;
+    size_t blobBlockSize = OS_ConfigServiceBackend_getSizeOfRecords(backend);
+    char block[OS_CONFIG_LIB_PARAMETER_MAX_BLOB_BLOCK_SIZE];
+
+    if (blobBlockSize > sizeof(block))
+    {
+        Debug_LOG_ERROR("Blob record size %zu exceeds the block buffer",
+                        blobBlockSize);
+        return OS_ERROR_GENERIC;
+    }
+
+    char* filePath = malloc(strlen(ctx->blobDir) + strlen(value) + 1);
+    if (filePath == NULL)
+    {
+        Debug_LOG_ERROR("Failed to allocate memory");
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+    strcpy(filePath, ctx->blobDir);
+    strcat(filePath, value);
+
+    FILE* f = fopen(filePath, "rb");
+    if (f == NULL)
+    {
+        Debug_LOG_ERROR("Failed to open %s", filePath);
+        free(filePath);
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    long size = -1;
+    if (fseek(f, 0, SEEK_END) == 0)
+    {
+        size = ftell(f);
+        rewind(f);
+    }
+
+    uint32_t numberOfBlocks = 0;
+    uint32_t oldNumberOfBlocks = param->parameterValue.valueBlob.numberOfBlocks;
+    OS_Error_t err = OS_SUCCESS;
+
+    /* Like the writer does, the size includes the terminating zero byte,
+     * which is provided by the zero padding of the last block
+     */
+    if ((size < 0) || (size >= UINT32_MAX))
+    {
+        Debug_LOG_ERROR("Failed to determine the size of %s", filePath);
+        err = OS_ERROR_INVALID_PARAMETER;
+    }
+    else if ((numberOfBlocks = ConfigTool_UtilCalculateNumberOfBlocks(size + 1))
+             > oldNumberOfBlocks)
+    {
+        Debug_LOG_ERROR("Blob %s needs %u blocks, only %u are available",
+                        filePath, numberOfBlocks, oldNumberOfBlocks);
+        err = OS_ERROR_NOT_SUPPORTED;
+    }
+
+    for (uint32_t i = 0; (err == OS_SUCCESS) && (i < oldNumberOfBlocks); i++)
+    {
+        size_t n = fread(block, 1, blobBlockSize, f);
+        if ((n < blobBlockSize) && ferror(f))
+        {
+            Debug_LOG_ERROR("Failed to read %s", filePath);
+            err = OS_ERROR_GENERIC;
+            break;
+        }
+        memset(&block[n], 0, blobBlockSize - n);
+
+        err = OS_ConfigServiceBackend_writeRecord(
+                  backend,
+                  param->parameterValue.valueBlob.index + i,
+                  block,
+                  blobBlockSize);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("OS_ConfigServiceBackend_writeRecord() failed with: %d",
+                            err);
+        }
+    }
+
+    fclose(f);
+    free(filePath);
+
+    if (err != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    param->parameterValue.valueBlob.numberOfBlocks = numberOfBlocks;
+    param->parameterValue.valueBlob.size = (uint32_t)size + 1;
+
+    return OS_SUCCESS;
+}
+
+static
+OS_Error_t
+ConfigTool_ConfigPatcherSetValue(
+    ConfigTool_ConfigPatcherContext_t* ctx,
+    const ConfigTool_ConfigPatcherValue_t* value)
+{
+    size_t paramIndex;
+    OS_Error_t err = ConfigTool_ConfigPatcherFindQualifiedParam(
+                         ctx,
+                         value->name,
+                         &paramIndex);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("Parameter %s not found", value->name);
+        return err;
+    }
+
+    OS_ConfigServiceLibTypes_Parameter_t* param = &ctx->params[paramIndex];
+    uint64_t integer;
+
+    switch (param->parameterType)
+    {
+    case OS_CONFIG_LIB_PARAMETER_TYPE_INTEGER32:
+        err = ConfigTool_UtilParseInteger(value->value, UINT32_MAX, &integer);
+        if (err == OS_SUCCESS)
+        {
+            param->parameterValue.valueInteger32 = (uint32_t)integer;
+        }
+        break;
+
+    case OS_CONFIG_LIB_PARAMETER_TYPE_INTEGER64:
+        err = ConfigTool_UtilParseInteger(value->value, UINT64_MAX, &integer);
+        if (err == OS_SUCCESS)
+        {
+            param->parameterValue.valueInteger64 = integer;
+        }
+        break;
+
+    case OS_CONFIG_LIB_PARAMETER_TYPE_STRING:
+    case OS_CONFIG_LIB_PARAMETER_TYPE_BLOB:
+        // Equal values share their records, which must not change for all
+        if (ConfigTool_ConfigPatcherIsShared(ctx, paramIndex))
+        {
+            Debug_LOG_ERROR("Value of %s is shared with other parameters",
+                            value->name);
+            return OS_ERROR_NOT_SUPPORTED;
+        }
+        err = (param->parameterType == OS_CONFIG_LIB_PARAMETER_TYPE_STRING) ?
+              ConfigTool_ConfigPatcherSetString(ctx, param, value->value) :
+              ConfigTool_ConfigPatcherSetBlob(ctx, param, value->value);
+        break;
+
+    default:
+        Debug_LOG_ERROR("Unsupported parameter type!");
+        return OS_ERROR_GENERIC;
+    }
+
+    if (err != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    err = OS_ConfigServiceBackend_writeRecord(
+              &ctx->configLib->parameterBackend,
+              paramIndex,
+              param,
+              sizeof(OS_ConfigServiceLibTypes_Parameter_t));
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("OS_ConfigServiceBackend_writeRecord() failed with: %d", err);
+        return err;
+    }
+
+    Debug_LOG_DEBUG("Patched parameter %s", value->name);
+
+    return OS_SUCCESS;
+}
+
+
+/* Exported functions --------------------------------------------------------*/
+OS_Error_t
+ConfigTool_ConfigPatcherRun(
+    OS_ConfigServiceLib_t* configLib,
+    const ConfigTool_ConfigPatcherValue_t* values,
+    size_t valueCount,
+    const char* blobDir)
+{
+    ConfigTool_ConfigPatcherContext_t ctx =
+    {
+        .configLib = configLib,
+        .blobDir = blobDir,
+    };
+
+    OS_Error_t err = ConfigTool_ConfigPatcherReadRecords(
+                         &configLib->domainBackend,
+                         sizeof(OS_ConfigServiceLibTypes_Domain_t),
+                         (void**)&ctx.domains,
+                         &ctx.domainCount);
+    if (err != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    err = ConfigTool_ConfigPatcherReadRecords(
+              &configLib->parameterBackend,
+              sizeof(OS_ConfigServiceLibTypes_Parameter_t),
+              (void**)&ctx.params,
+              &ctx.paramCount);
+
+    for (size_t i = 0; (err == OS_SUCCESS) && (i < valueCount); i++)
+    {
+        err = ConfigTool_ConfigPatcherSetValue(&ctx, &values[i]);
+    }
+
+    free(ctx.params);
+    free(ctx.domains);
+
+    return err;
+}
@@ -0,0 +1,524 @@
+/*
+ * Read-only access to the records of existing backend files
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "lib_debug/Debug.h"
+#include "ConfigTool_ConfigReader.h"
+#include "ConfigTool_Backend.h"
+#include "ConfigTool_Output.h"
+#include "ConfigTool_ParamIndex.h"
+
+
+/* Private variables ---------------------------------------------------------*/
+static const char* const backendFiles[CONFIG_TOOL_CONFIG_READER_FILE_COUNT] =
+{
+    DOMAIN_FILE, PARAMETER_FILE, STRING_FILE, BLOB_FILE
+};
+
+static const size_t recordSizes[CONFIG_TOOL_CONFIG_READER_FILE_COUNT] =
+{
+    sizeof(OS_ConfigServiceLibTypes_Domain_t),
+    sizeof(OS_ConfigServiceLibTypes_Parameter_t),
+    OS_CONFIG_LIB_PARAMETER_MAX_STRING_SIZE,
+    OS_CONFIG_LIB_PARAMETER_MAX_BLOB_BLOCK_SIZE
+};
+
+
+/* Private functions ---------------------------------------------------------*/
+// Maps a host file read-only, empty files are not mapped
+static
+OS_Error_t
+ConfigTool_ConfigReaderMapFile(
+    const char* path,
+    void** data,
+    size_t* size)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        Debug_LOG_ERROR("open() failed for %s with errno %d", path, errno);
+        return (errno == ENOENT) ? OS_ERROR_NOT_FOUND : OS_ERROR_GENERIC;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        Debug_LOG_ERROR("fstat() failed for %s with errno %d", path, errno);
+        close(fd);
+        return OS_ERROR_GENERIC;
+    }
+
+    *data = NULL;
+    *size = st.st_size;
+
+    if (*size > 0)
+    {
+        void* addr = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED)
+        {
+            Debug_LOG_ERROR("mmap() failed for %s with errno %d", path, errno);
+            close(fd);
+            return OS_ERROR_GENERIC;
+        }
+        // The records are scanned front to back once
+        madvise(addr, *size, MADV_SEQUENTIAL);
+        *data = addr;
+    }
+
+    // The mapping stays valid without the file descriptor
+    close(fd);
+
+    return OS_SUCCESS;
+}
+
+static
+OS_Error_t
+ConfigTool_ConfigReaderMapHostFiles(
+    ConfigTool_ConfigReader_t* self,
+    const char* dirPath)
+{
+    self->isMapped = true;
+
+    for (size_t i = 0; i < CONFIG_TOOL_CONFIG_READER_FILE_COUNT; i++)
+    {
+        char path[PATH_MAX];
+        if (snprintf(path, sizeof(path), "%s/%s", dirPath, backendFiles[i])
+            >= (int)sizeof(path))
+        {
+            Debug_LOG_ERROR("Path for %s too long", backendFiles[i]);
+            return OS_ERROR_INVALID_PARAMETER;
+        }
+
+        OS_Error_t err = ConfigTool_ConfigReaderMapFile(
+                             path,
+                             &self->files[i],
+                             &self->fileSizes[i]);
+        if (err != OS_SUCCESS)
+        {
+            return err;
+        }
+    }
+
+    // The index is optional
+    char path[PATH_MAX];
+    struct stat st;
+    if ((snprintf(path, sizeof(path), "%s/%s", dirPath, INDEX_FILE)
+         >= (int)sizeof(path))
+        || (stat(path, &st) != 0))
+    {
+        return OS_SUCCESS;
+    }
+
+    return ConfigTool_ConfigReaderMapFile(path, &self->indexFile,
+                                          &self->indexSize);
+}
+
+// Reads a backend file of the mounted filesystem at once
+static
+OS_Error_t
+ConfigTool_ConfigReaderReadFile(
+    OS_FileSystem_Handle_t hFs,
+    const char* name,
+    void** data,
+    size_t* size)
+{
+    off_t fileSize;
+    OS_Error_t err = OS_FileSystemFile_getSize(hFs, name, &fileSize);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("OS_FileSystemFile_getSize() failed for %s with %d",
+                        name, err);
+        return OS_ERROR_NOT_FOUND;
+    }
+
+    // One extra byte keeps the allocation valid for empty files
+    char* buf = malloc((size_t)fileSize + 1);
+    if (buf == NULL)
+    {
+        Debug_LOG_ERROR("Failed to allocate memory");
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+
+    OS_FileSystemFile_Handle_t hFile;
+    err = OS_FileSystemFile_open(
+              hFs,
+              &hFile,
+              name,
+              OS_FileSystem_OpenMode_RDONLY,
+              OS_FileSystem_OpenFlags_NONE);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("OS_FileSystemFile_open() failed for %s with %d", name,
+                        err);
+        free(buf);
+        return err;
+    }
+
+    if (fileSize > 0)
+    {
+        err = OS_FileSystemFile_read(hFs, hFile, 0, fileSize, buf);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("OS_FileSystemFile_read() failed for %s with %d",
+                            name, err);
+        }
+    }
+
+    OS_Error_t errClose = OS_FileSystemFile_close(hFs, hFile);
+    if (err == OS_SUCCESS)
+    {
+        err = errClose;
+    }
+
+    if (err != OS_SUCCESS)
+    {
+        free(buf);
+        return err;
+    }
+
+    *data = buf;
+    *size = fileSize;
+
+    return OS_SUCCESS;
+}
+
+// Reads all backend files from the image in the working directory
+static
+OS_Error_t
+ConfigTool_ConfigReaderReadImageFiles(
+    ConfigTool_ConfigReader_t* self,
+    const ConfigTool_BackendConfig_t* cfg)
+{
+    ConfigTool_Backend_t backend;
+
+    OS_Error_t err = ConfigTool_BackendOpen(&backend, cfg);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_BackendOpen() failed with %d", err);
+        return err;
+    }
+
+    for (size_t i = 0;
+         (err == OS_SUCCESS) && (i < CONFIG_TOOL_CONFIG_READER_FILE_COUNT);
+         i++)
+    {
+        err = ConfigTool_ConfigReaderReadFile(
+                  backend.hFs,
+                  backendFiles[i],
+                  &self->files[i],
+                  &self->fileSizes[i]);
+    }
+
+    // The index is optional
+    off_t indexSize;
+    if ((err == OS_SUCCESS)
+        && (OS_FileSystemFile_getSize(backend.hFs, INDEX_FILE, &indexSize)
+            == OS_SUCCESS))
+    {
+        err = ConfigTool_ConfigReaderReadFile(
+                  backend.hFs,
+                  INDEX_FILE,
+                  &self->indexFile,
+                  &self->indexSize);
+    }
+
+    OS_Error_t errDeInit = ConfigTool_BackendDeInit(&backend);
+    if (errDeInit != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_BackendDeInit() failed with %d", errDeInit);
+    }
+
+    return (err == OS_SUCCESS) ? errDeInit : err;
+}
+
+/* Mounting may write to the image, e.g. to replay a journal, so a private
+ * copy is mounted instead. The copy is placed in the temporary directory of
+ * the host, so images in read-only locations can be read as well.
+ */
+static
+OS_Error_t
+ConfigTool_ConfigReaderLoadImage(
+    ConfigTool_ConfigReader_t* self,
+    OS_FileSystem_Type_t fsType,
+    const char* imagePath)
+{
+    struct stat st;
+    if (stat(imagePath, &st) != 0)
+    {
+        Debug_LOG_ERROR("Cannot access %s", imagePath);
+        return OS_ERROR_NOT_FOUND;
+    }
+
+    ConfigTool_BackendConfig_t cfg =
+    {
+        .fsType = fsType,
+        .hostFsMode = CONFIG_TOOL_HOST_FS_MODE_WRITE,
+        .imageSize = st.st_size,
+        .templateCacheDir = NULL,
+        .writeIndex = false,
+        .hostDir = NULL,
+    };
+
+    const char* tmpDir = getenv("TMPDIR");
+    if ((tmpDir == NULL) || (tmpDir[0] == '\0'))
+    {
+        tmpDir = "/tmp";
+    }
+
+    ConfigTool_Output_t output;
+    OS_Error_t err = ConfigTool_OutputInit(&output, tmpDir);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_OutputInit() failed with %d", err);
+        return err;
+    }
+
+    err = ConfigTool_OutputImport(&output, HOSTSTORAGE_FILE_NAME, imagePath);
+    if (err == OS_SUCCESS)
+    {
+        err = ConfigTool_OutputEnter(&output);
+    }
+
+    if (err == OS_SUCCESS)
+    {
+        err = ConfigTool_ConfigReaderReadImageFiles(self, &cfg);
+
+        OS_Error_t errLeave = ConfigTool_OutputLeave(&output);
+        if (err == OS_SUCCESS)
+        {
+            err = errLeave;
+        }
+    }
+
+    ConfigTool_OutputFree(&output);
+
+    return err;
+}
+
+// Checks that every backend file is an array of whole records
+static
+OS_Error_t
+ConfigTool_ConfigReaderCountRecords(
+    ConfigTool_ConfigReader_t* self)
+{
+    size_t counts[CONFIG_TOOL_CONFIG_READER_FILE_COUNT];
+
+    for (size_t i = 0; i < CONFIG_TOOL_CONFIG_READER_FILE_COUNT; i++)
+    {
+        if ((self->fileSizes[i] % recordSizes[i]) != 0)
+        {
+            Debug_LOG_ERROR("%s of %zu bytes is no array of %zu byte records",
+                            backendFiles[i], self->fileSizes[i], recordSizes[i]);
+            return OS_ERROR_INVALID_STATE;
+        }
+        counts[i] = self->fileSizes[i] / recordSizes[i];
+    }
+
+    self->domains = self->files[0];
+    self->domainCount = counts[0];
+    self->params = self->files[1];
+    self->paramCount = counts[1];
+    self->strings = self->files[2];
+    self->stringCount = counts[2];
+    self->blobs = self->files[3];
+    self->blobCount = counts[3];
+
+    return OS_SUCCESS;
+}
+
+
+/* Exported functions --------------------------------------------------------*/
+OS_Error_t
+ConfigTool_ConfigReaderOpen(
+    ConfigTool_ConfigReader_t* self,
+    OS_FileSystem_Type_t fsType,
+    const char* path)
+{
+    memset(self, 0, sizeof(ConfigTool_ConfigReader_t));
+
+    OS_Error_t err = (fsType == OS_FileSystem_Type_NONE) ?
+                     ConfigTool_ConfigReaderMapHostFiles(self, path) :
+                     ConfigTool_ConfigReaderLoadImage(self, fsType, path);
+    if (err == OS_SUCCESS)
+    {
+        err = ConfigTool_ConfigReaderCountRecords(self);
+    }
+
+    if (err != OS_SUCCESS)
+    {
+        ConfigTool_ConfigReaderClose(self);
+        return err;
+    }
+
+    Debug_LOG_DEBUG("Domain Count:%zu, String Count:%zu, Param Count:%zu, Blob Count:%zu",
+                    self->domainCount, self->stringCount, self->paramCount,
+                    self->blobCount);
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+ConfigTool_ConfigReaderGetString(
+    const ConfigTool_ConfigReader_t* self,
+    const OS_ConfigServiceLibTypes_Parameter_t* param,
+    const char** str,
+    size_t* length)
+{
+    const OS_ConfigServiceLibTypes_String_t* value =
+        &param->parameterValue.valueString;
+
+    if (value->index >= self->stringCount)
+    {
+        Debug_LOG_ERROR("String record %u exceeds the %zu records of %s",
+                        value->index, self->stringCount, STRING_FILE);
+        return OS_ERROR_INVALID_STATE;
+    }
+
+    const char* record = &self->strings[(size_t)value->index
+                                        * OS_CONFIG_LIB_PARAMETER_MAX_STRING_SIZE];
+
+    // The size includes the terminator, which has to end the string
+    if ((value->size == 0)
+        || (value->size > OS_CONFIG_LIB_PARAMETER_MAX_STRING_SIZE)
+        || (strnlen(record, value->size) != (value->size - 1)))
+    {
+        Debug_LOG_ERROR("String record %u does not hold %u bytes", value->index,
+                        value->size);
+        return OS_ERROR_INVALID_STATE;
+    }
+
+    *str = record;
+    *length = value->size - 1;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+ConfigTool_ConfigReaderGetBlob(
+    const ConfigTool_ConfigReader_t* self,
+    const OS_ConfigServiceLibTypes_Parameter_t* param,
+    const void** data,
+    size_t* length)
+{
+    const OS_ConfigServiceLibTypes_Blob_t* value =
+        &param->parameterValue.valueBlob;
+
+    if ((value->numberOfBlocks > self->blobCount)
+        || (value->index > (self->blobCount - value->numberOfBlocks)))
+    {
+        Debug_LOG_ERROR("Blob records %u+%u exceed the %zu records of %s",
+                        value->index, value->numberOfBlocks, self->blobCount,
+                        BLOB_FILE);
+        return OS_ERROR_INVALID_STATE;
+    }
+
+    // The size includes a terminating zero byte following the content
+    if ((value->size == 0)
+        || (value->size > ((size_t)value->numberOfBlocks
+                           * OS_CONFIG_LIB_PARAMETER_MAX_BLOB_BLOCK_SIZE)))
+    {
+        Debug_LOG_ERROR("Blob records %u+%u do not hold %u bytes", value->index,
+                        value->numberOfBlocks, value->size);
+        return OS_ERROR_INVALID_STATE;
+    }
+
+    *data = &self->blobs[(size_t)value->index
+                         * OS_CONFIG_LIB_PARAMETER_MAX_BLOB_BLOCK_SIZE];
+    *length = value->size - 1;
+
+    return OS_SUCCESS;
+}
+
+bool
+ConfigTool_ConfigReaderHasAccess(
+    const OS_ConfigServiceAccessRights_t* rights)
+{
+    static const OS_ConfigServiceAccessRights_t noAccess;
+
+    return memcmp(rights, &noAccess, sizeof(noAccess)) != 0;
+}
+
+bool
+ConfigTool_ConfigReaderIsClustered(
+    const ConfigTool_ConfigReader_t* self)
+{
+    for (size_t i = 0; i < self->domainCount; i++)
+    {
+        if (self->domains[i].enumerator.index != 0)
+        {
+            return true;
+        }
+    }
+
+    for (size_t i = 0; i < self->paramCount; i++)
+    {
+        const OS_ConfigServiceLibTypes_Parameter_t* param = &self->params[i];
+
+        if ((param->domain.index + 1) != self->domainCount)
+        {
+            return false;
+        }
+
+        if ((i > 0) && (strncmp(self->params[i - 1].parameterName.name,
+                                param->parameterName.name,
+                                sizeof(param->parameterName.name)) > 0))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void
+ConfigTool_ConfigReaderClose(
+    ConfigTool_ConfigReader_t* self)
+{
+    for (size_t i = 0; i < CONFIG_TOOL_CONFIG_READER_FILE_COUNT; i++)
+    {
+        if (self->files[i] == NULL)
+        {
+            continue;
+        }
+
+        if (self->isMapped)
+        {
+            munmap(self->files[i], self->fileSizes[i]);
+        }
+        else
+        {
+            free(self->files[i]);
+        }
+        self->files[i] = NULL;
+    }
+
+    if (self->indexFile != NULL)
+    {
+        if (self->isMapped)
+        {
+            munmap(self->indexFile, self->indexSize);
+        }
+        else
+        {
+            free(self->indexFile);
+        }
+        self->indexFile = NULL;
+    }
+}
@@ -203,3 +203,17 @@ OS_Error_t ConfigTool_ConfigServiceInit(
 
     return OS_SUCCESS;
 }
+
+OS_Error_t ConfigTool_ConfigServiceOpen(
+    OS_ConfigServiceLib_t* configLib,
+    OS_FileSystem_Handle_t hFs)
+{
+    OS_Error_t err = ConfigTool_ConfigServiceInitBackends(configLib, hFs);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_ConfigServiceInitBackends() failed with %d", err);
+        return err;
+    }
+
+    return OS_SUCCESS;
+}
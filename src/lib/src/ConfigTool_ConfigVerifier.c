@@ -0,0 +1,372 @@
+/*
+ * Compares the records of existing backend files with a configuration model
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "lib_debug/Debug.h"
+#include "ConfigTool_ConfigVerifier.h"
+#include "ConfigTool_ParamIndex.h"
+#include "ConfigTool_Util.h"
+
+
+/* Defines -------------------------------------------------------------------*/
+// Piece size in which streamed blob files are compared
+#define VERIFIER_CHUNK_SIZE  4096
+
+
+/* Private types/enums -------------------------------------------------------*/
+// State of a single verifier run
+typedef struct
+{
+    const ConfigTool_ConfigReader_t* reader; /**< records to verify */
+    const ConfigTool_ConfigModel_t* model;   /**< expected configuration */
+    size_t mismatchCount;                    /**< differences found so far */
+} ConfigTool_ConfigVerifierContext_t;
+
+
+/* Private functions ---------------------------------------------------------*/
+static
+void
+ConfigTool_ConfigVerifierReport(
+    ConfigTool_ConfigVerifierContext_t* ctx,
+    const ConfigTool_ConfigModelParam_t* param,
+    const char* difference)
+{
+    printf("%s.%s: %s\n", ctx->model->domains[param->domainIndex].name,
+           param->name, difference);
+    ctx->mismatchCount++;
+}
+
+static
+OS_ConfigServiceLibTypes_ParameterType_t
+ConfigTool_ConfigVerifierGetRecordType(
+    ConfigTool_ConfigServiceParamType_t type)
+{
+    switch (type)
+    {
+    case INT32:
+        return OS_CONFIG_LIB_PARAMETER_TYPE_INTEGER32;
+    case INT64:
+        return OS_CONFIG_LIB_PARAMETER_TYPE_INTEGER64;
+    case STRING:
+        return OS_CONFIG_LIB_PARAMETER_TYPE_STRING;
+    default:
+        return OS_CONFIG_LIB_PARAMETER_TYPE_BLOB;
+    }
+}
+
+// Compares the content of a blob file with the blob records
+static
+OS_Error_t
+ConfigTool_ConfigVerifierCompareBlob(
+    const ConfigTool_BlobSource_t* source,
+    const void* data,
+    bool* isEqual)
+{
+    if (!ConfigTool_BlobSourceIsStreamed(source))
+    {
+        *isEqual = (source->length == 0)
+                   || (memcmp(source->data, data, source->length) == 0);
+        return OS_SUCCESS;
+    }
+
+    char buf[VERIFIER_CHUNK_SIZE];
+
+    for (size_t offset = 0; offset < source->length; offset += sizeof(buf))
+    {
+        size_t length = source->length - offset;
+        if (length > sizeof(buf))
+        {
+            length = sizeof(buf);
+        }
+
+        OS_Error_t err = ConfigTool_BlobSourceRead(source, offset, buf, length);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("ConfigTool_BlobSourceRead() failed with %d", err);
+            return err;
+        }
+
+        if (memcmp(buf, (const char*)data + offset, length) != 0)
+        {
+            *isEqual = false;
+            return OS_SUCCESS;
+        }
+    }
+
+    *isEqual = true;
+
+    return OS_SUCCESS;
+}
+
+static
+OS_Error_t
+ConfigTool_ConfigVerifierCompareValue(
+    ConfigTool_ConfigVerifierContext_t* ctx,
+    const ConfigTool_ConfigModelParam_t* param,
+    const OS_ConfigServiceLibTypes_Parameter_t* record)
+{
+    const char* value = ConfigTool_ConfigModelGetValue(ctx->model, param);
+    const char* str;
+    const void* data;
+    size_t length;
+
+    // Integers are converted like the writer does, accepting decimal and hex
+    switch (param->type)
+    {
+    case INT32:
+        if (record->parameterValue.valueInteger32
+            != (uint32_t)strtoul(value, NULL, 0))
+        {
+            ConfigTool_ConfigVerifierReport(ctx, param, "value differs");
+        }
+        break;
+
+    case INT64:
+        if (record->parameterValue.valueInteger64
+            != (uint64_t)strtoull(value, NULL, 0))
+        {
+            ConfigTool_ConfigVerifierReport(ctx, param, "value differs");
+        }
+        break;
+
+    case STRING:
+        if (ConfigTool_ConfigReaderGetString(ctx->reader, record, &str, &length)
+            != OS_SUCCESS)
+        {
+            ConfigTool_ConfigVerifierReport(ctx, param, "invalid string record");
+            break;
+        }
+        // The writer truncates strings to the size of a string record
+        if ((length != strnlen(value, OS_CONFIG_LIB_PARAMETER_MAX_STRING_SIZE - 1))
+            || (memcmp(str, value, length) != 0))
+        {
+            ConfigTool_ConfigVerifierReport(ctx, param, "value differs");
+        }
+        break;
+
+    case BLOB:
+    {
+        if (ConfigTool_ConfigReaderGetBlob(ctx->reader, record, &data, &length)
+            != OS_SUCCESS)
+        {
+            ConfigTool_ConfigVerifierReport(ctx, param, "invalid blob records");
+            break;
+        }
+
+        const ConfigTool_BlobCacheEntry_t* blob =
+            ConfigTool_ConfigModelGetBlob(ctx->model, param);
+        if (blob->source.length != length)
+        {
+            ConfigTool_ConfigVerifierReport(ctx, param, "blob size differs");
+            break;
+        }
+
+        bool isEqual;
+        OS_Error_t err = ConfigTool_ConfigVerifierCompareBlob(&blob->source,
+                                                              data, &isEqual);
+        if (err != OS_SUCCESS)
+        {
+            return err;
+        }
+        if (!isEqual)
+        {
+            ConfigTool_ConfigVerifierReport(ctx, param, "blob content differs");
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    return OS_SUCCESS;
+}
+
+static
+OS_Error_t
+ConfigTool_ConfigVerifierCompareParam(
+    ConfigTool_ConfigVerifierContext_t* ctx,
+    const ConfigTool_ConfigModelParam_t* param,
+    const OS_ConfigServiceLibTypes_Parameter_t* record)
+{
+    char name[OS_CONFIG_LIB_PARAMETER_NAME_SIZE];
+    ConfigTool_UtilInitializeName(name, sizeof(name), param->name);
+
+    if (strncmp(record->parameterName.name, name, sizeof(name)) != 0)
+    {
+        printf("%s.%s: record holds %.*s instead\n",
+               ctx->model->domains[param->domainIndex].name, param->name,
+               (int)sizeof(name), record->parameterName.name);
+        ctx->mismatchCount++;
+        return OS_SUCCESS;
+    }
+
+    if (record->domain.index != param->domainIndex)
+    {
+        ConfigTool_ConfigVerifierReport(ctx, param, "domain differs");
+    }
+
+    if (ConfigTool_ConfigReaderHasAccess(&record->readAccess)
+        != param->hasReadAccess)
+    {
+        ConfigTool_ConfigVerifierReport(ctx, param, "read access differs");
+    }
+
+    if (ConfigTool_ConfigReaderHasAccess(&record->writeAccess)
+        != param->hasWriteAccess)
+    {
+        ConfigTool_ConfigVerifierReport(ctx, param, "write access differs");
+    }
+
+    if (record->parameterType != ConfigTool_ConfigVerifierGetRecordType(
+            param->type))
+    {
+        ConfigTool_ConfigVerifierReport(ctx, param, "type differs");
+        return OS_SUCCESS;
+    }
+
+    return ConfigTool_ConfigVerifierCompareValue(ctx, param, record);
+}
+
+static
+void
+ConfigTool_ConfigVerifierCompareDomains(
+    ConfigTool_ConfigVerifierContext_t* ctx)
+{
+    const ConfigTool_ConfigReader_t* reader = ctx->reader;
+    const ConfigTool_ConfigModel_t* model = ctx->model;
+
+    if (reader->domainCount != model->counter.domain_count)
+    {
+        printf("%s holds %zu domains instead of %u\n", DOMAIN_FILE,
+               reader->domainCount, model->counter.domain_count);
+        ctx->mismatchCount++;
+    }
+
+    for (size_t i = 0;
+         (i < reader->domainCount) && (i < model->counter.domain_count);
+         i++)
+    {
+        OS_ConfigServiceLibTypes_Domain_t domain;
+        ConfigTool_UtilInitializeDomain(&domain, model->domains[i].name);
+
+        if (strncmp(reader->domains[i].name.name, domain.name.name,
+                    sizeof(domain.name.name)) != 0)
+        {
+            printf("%s: record %zu holds %.*s instead\n", model->domains[i].name,
+                   i, (int)sizeof(domain.name.name),
+                   reader->domains[i].name.name);
+            ctx->mismatchCount++;
+        }
+
+        uint32_t start = model->isClustered ?
+                         ConfigTool_ConfigModelGetDomainStart(model, i) : 0;
+        if (reader->domains[i].enumerator.index != start)
+        {
+            printf("%s: parameters start at record %u instead of %u\n",
+                   model->domains[i].name, reader->domains[i].enumerator.index,
+                   start);
+            ctx->mismatchCount++;
+        }
+    }
+}
+
+// Checks that the index leads to every parameter record
+static
+void
+ConfigTool_ConfigVerifierCheckIndex(
+    ConfigTool_ConfigVerifierContext_t* ctx)
+{
+    const ConfigTool_ConfigReader_t* reader = ctx->reader;
+
+    if (ConfigTool_ParamIndexValidate(reader->indexFile, reader->indexSize,
+                                      reader->paramCount) != OS_SUCCESS)
+    {
+        printf("%s is invalid\n", INDEX_FILE);
+        ctx->mismatchCount++;
+        return;
+    }
+
+    const uint32_t* index = reader->indexFile;
+    ConfigTool_ParamIndexHeader_t header;
+    memcpy(&header, index, sizeof(header));
+
+    for (size_t i = 0; i < reader->paramCount; i++)
+    {
+        const OS_ConfigServiceLibTypes_Parameter_t* record = &reader->params[i];
+
+        uint64_t hash = ConfigTool_ParamIndexHash(
+                            header.seed,
+                            record->domain.index,
+                            record->parameterName.name);
+        if (ConfigTool_ParamIndexGetSlot(index, hash) != i)
+        {
+            printf("%s: lookup of record %zu %.*s fails\n", INDEX_FILE, i,
+                   (int)sizeof(record->parameterName.name),
+                   record->parameterName.name);
+            ctx->mismatchCount++;
+        }
+    }
+}
+
+
+/* Exported functions --------------------------------------------------------*/
+OS_Error_t
+ConfigTool_ConfigVerifierRun(
+    const ConfigTool_ConfigReader_t* reader,
+    const ConfigTool_ConfigModel_t* model,
+    size_t* mismatchCount)
+{
+    ConfigTool_ConfigVerifierContext_t ctx =
+    {
+        .reader = reader,
+        .model = model,
+    };
+
+    ConfigTool_ConfigVerifierCompareDomains(&ctx);
+
+    if (reader->paramCount != model->counter.param_count)
+    {
+        printf("%s holds %zu parameters instead of %u\n", PARAMETER_FILE,
+               reader->paramCount, model->counter.param_count);
+        ctx.mismatchCount++;
+    }
+
+    for (size_t i = 0;
+         (i < reader->paramCount) && (i < model->counter.param_count);
+         i++)
+    {
+        OS_Error_t err = ConfigTool_ConfigVerifierCompareParam(
+                             &ctx,
+                             &model->params[i],
+                             &reader->params[i]);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("ConfigTool_ConfigVerifierCompareParam() failed with %d",
+                            err);
+            return err;
+        }
+    }
+
+    if (reader->indexFile != NULL)
+    {
+        ConfigTool_ConfigVerifierCheckIndex(&ctx);
+    }
+
+    *mismatchCount = ctx.mismatchCount;
+
+    return OS_SUCCESS;
+}
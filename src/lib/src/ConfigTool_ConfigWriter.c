@@ -0,0 +1,678 @@
+/*
+ * Writes the domains and parameters of a configuration model to the
+ * configuration library instance
+ *
+ * Copyright (C) 2019-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "lib_debug/Debug.h"
+#include "ConfigTool_ConfigWriter.h"
+#include "ConfigTool_Util.h"
+
+
+/* Private types/enums -------------------------------------------------------*/
+// State of a single writer run
+typedef struct
+{
+    OS_ConfigServiceLib_t* configLib;      /**< library the records are written to */
+    const ConfigTool_ConfigModel_t* model; /**< model the records are taken from */
+    uint32_t parameterIndex;               /**< next record in PARAM.BIN */
+    uint32_t stringIndex;                  /**< next record in STRING.BIN */
+    uint32_t blobIndex;                    /**< next record in BLOB.BIN */
+    uint32_t* blobRecords;                 /**< first record + 1 of each blob
+                                                cache entry, 0 if not written */
+} ConfigTool_ConfigWriterContext_t;
+
+
+/* Private functions ---------------------------------------------------------*/
+/* Verifies that the records of the passed parameter fit into the backends that
+ * were sized with the counters of the model, so a mismatch can never overwrite
+ * records written earlier.
+ */
+static
+OS_Error_t
+ConfigTool_ConfigWriterCheckCapacity(
+    const ConfigTool_ConfigWriterContext_t* ctx,
+    const ConfigTool_ConfigModelParam_t* param)
+{
+    const ConfigTool_ConfigServiceCounter_t* counter = &ctx->model->counter;
+
+    if (ctx->parameterIndex >= counter->param_count)
+    {
+        Debug_LOG_ERROR("Parameter record %u exceeds the %u records of %s",
+                        ctx->parameterIndex, counter->param_count, PARAMETER_FILE);
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+
+    if ((param->type == STRING) && (param->stringEntry >= counter->string_count))
+    {
+        Debug_LOG_ERROR("String record %u exceeds the %u records of %s",
+                        param->stringEntry, counter->string_count, STRING_FILE);
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+
+    // Blobs sharing their content with an earlier one occupy no new records
+    if ((param->type == BLOB)
+        && (ctx->blobRecords[param->blobEntry] == 0)
+        && ((param->numberOfBlocks > counter->blob_count)
+            || (ctx->blobIndex > (counter->blob_count - param->numberOfBlocks))))
+    {
+        Debug_LOG_ERROR("Blob records %u-%u exceed the %u records of %s",
+                        ctx->blobIndex, ctx->blobIndex + param->numberOfBlocks - 1,
+                        counter->blob_count, BLOB_FILE);
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+
+    return OS_SUCCESS;
+}
+
+static
+OS_Error_t
+ConfigTool_ConfigWriterWriteVariableLengthBlob(
+    OS_ConfigServiceBackend_t* backend,
+    uint32_t index,
+    uint32_t numberOfBlocks,
+    const ConfigTool_BlobSource_t* source)
+{
+    size_t blobBlockSize = OS_ConfigServiceBackend_getSizeOfRecords(backend);
+    size_t blobCapacity = blobBlockSize * numberOfBlocks;
+
+    // We anticipate a maximum size here which should be ok to place on the stack.
+    char tmpBuf[OS_CONFIG_LIB_PARAMETER_MAX_BLOB_BLOCK_SIZE];
+
+    if (blobBlockSize > sizeof(tmpBuf))
+    {
+        Debug_LOG_DEBUG("Blob record size %zu exceeds the block buffer",
+                        blobBlockSize);
+        return OS_ERROR_GENERIC;
+    }
+
+    if (source->length > blobCapacity)
+    {
+        Debug_LOG_DEBUG("Passed buffer length exceeds available blob capacity");
+        return OS_ERROR_GENERIC;
+    }
+
+    size_t bytesWritten = 0;
+
+    /* The blob is written block by block, so only one block is held in memory
+     * at a time. Full blocks of a mapped file are written straight from the
+     * mapping, everything else goes through the block buffer. All blocks are
+     * written, the bytes following the data are zero, which also provides the
+     * terminator of the blob value.
+     */
+    for (uint32_t block = 0; block < numberOfBlocks; block++)
+    {
+        size_t bytesToCopy;
+        const void* record = tmpBuf;
+
+        if ((source->length - bytesWritten) >= blobBlockSize)
+        {
+            bytesToCopy = blobBlockSize;
+        }
+        else
+        {
+            bytesToCopy = source->length - bytesWritten;
+        }
+
+        if ((bytesToCopy == blobBlockSize)
+            && !ConfigTool_BlobSourceIsStreamed(source))
+        {
+            record = (const char*)source->data + bytesWritten;
+        }
+        else
+        {
+            OS_Error_t err = ConfigTool_BlobSourceRead(
+                                 source,
+                                 bytesWritten,
+                                 tmpBuf,
+                                 bytesToCopy);
+            if (OS_SUCCESS != err)
+            {
+                Debug_LOG_DEBUG("ConfigTool_BlobSourceRead() failed with %d",
+                                err);
+                return OS_ERROR_GENERIC;
+            }
+
+            memset(tmpBuf + bytesToCopy, 0, blobBlockSize - bytesToCopy);
+        }
+
+        OS_Error_t fetchResult = OS_ConfigServiceBackend_writeRecord(
+                                     backend,
+                                     index,
+                                     record,
+                                     blobBlockSize);
+
+        if (OS_SUCCESS != fetchResult)
+        {
+            Debug_LOG_DEBUG("OS_ConfigServiceBackend_writeRecord() failed \
+                            with %d", fetchResult);
+            return OS_ERROR_GENERIC;
+        }
+
+        bytesWritten += bytesToCopy;
+        index++;
+    }
+
+    return OS_SUCCESS;
+}
+
+static
+OS_Error_t
+ConfigTool_ConfigWriterAddIntParameter(
+    ConfigTool_ConfigWriterContext_t* ctx,
+    OS_ConfigServiceLibTypes_Parameter_t* parameter,
+    OS_ConfigServiceLibTypes_ParameterType_t parameterType,
+    uint32_t domainIndex,
+    const char* parameterName,
+    const void* parameterValue)
+{
+    parameter->domain.index = domainIndex;
+
+    if (parameterType == OS_CONFIG_LIB_PARAMETER_TYPE_INTEGER32)
+    {
+        parameter->parameterType = parameterType;
+        memcpy(&parameter->parameterValue, parameterValue, sizeof(uint32_t));
+    }
+
+    if (parameterType == OS_CONFIG_LIB_PARAMETER_TYPE_INTEGER64)
+    {
+        parameter->parameterType = parameterType;
+        memcpy(&parameter->parameterValue, parameterValue, sizeof(uint64_t));
+    }
+
+    ConfigTool_UtilInitializeName(
+        parameter->parameterName.name,
+        OS_CONFIG_LIB_PARAMETER_NAME_SIZE,
+        parameterName);
+
+    OS_Error_t err = OS_ConfigServiceBackend_writeRecord(
+                         &ctx->configLib->parameterBackend,
+                         ctx->parameterIndex,
+                         parameter,
+                         sizeof(OS_ConfigServiceLibTypes_Parameter_t));
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("OS_ConfigServiceBackend_writeRecord() failed with: %d", err);
+        return err;
+    }
+
+    ctx->parameterIndex++;
+
+    return OS_SUCCESS;
+}
+
+static
+OS_Error_t
+ConfigTool_ConfigWriterAddStringParameter(
+    ConfigTool_ConfigWriterContext_t* ctx,
+    OS_ConfigServiceLibTypes_Parameter_t* parameter,
+    uint32_t domainIndex,
+    const char* parameterName,
+    uint32_t stringEntry,
+    const void* parameterValue,
+    size_t parameterSize)
+{
+
+    char str[OS_CONFIG_LIB_PARAMETER_MAX_STRING_SIZE];
+    memset(str, 0, sizeof(str));
+    strncpy(str, (const char*)parameterValue, (sizeof(str) - 1));
+
+    parameter->domain.index = domainIndex;
+    parameter->parameterType = OS_CONFIG_LIB_PARAMETER_TYPE_STRING;
+
+    ConfigTool_UtilInitializeName(
+        parameter->parameterName.name,
+        OS_CONFIG_LIB_PARAMETER_NAME_SIZE,
+        parameterName);
+
+    parameter->parameterValue.valueString.index = stringEntry;
+    parameter->parameterValue.valueString.size = strlen(str) + 1;
+
+    OS_Error_t err = OS_ConfigServiceBackend_writeRecord(
+                         &ctx->configLib->parameterBackend,
+                         ctx->parameterIndex,
+                         parameter,
+                         sizeof(OS_ConfigServiceLibTypes_Parameter_t));;
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("OS_ConfigServiceBackend_writeRecord() failed with: %d", err);
+        return err;
+    }
+
+    ctx->parameterIndex++;
+
+    /* Pool entries are numbered in the order of their first use, which is the
+     * order the parameters are written in. So an entry below the next string
+     * record has already been written by a parameter with the same value.
+     */
+    if (stringEntry < ctx->stringIndex)
+    {
+        return OS_SUCCESS;
+    }
+
+    if (stringEntry != ctx->stringIndex)
+    {
+        Debug_LOG_ERROR("String record %u is written out of order, expected %u",
+                        stringEntry, ctx->stringIndex);
+        return OS_ERROR_INVALID_STATE;
+    }
+
+    err = OS_ConfigServiceBackend_writeRecord(
+              &ctx->configLib->stringBackend,
+              parameter->parameterValue.valueString.index,
+              str,
+              sizeof(str));
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("OS_ConfigServiceBackend_writeRecord() failed with: %d", err);
+        return err;
+    }
+
+    ctx->stringIndex++;
+
+    return OS_SUCCESS;
+}
+
+/* The configuration library stores large blobs in chunks of blocks and therfore
+ * it is first required to verify how many blocks need to be used to store the
+ * complete blob
+ */
+static
+OS_Error_t
+ConfigTool_ConfigWriterAddBlobParameter(
+    ConfigTool_ConfigWriterContext_t* ctx,
+    OS_ConfigServiceLibTypes_Parameter_t* parameter,
+    uint32_t domainIndex,
+    const char* parameterName,
+    uint32_t blobEntry,
+    const ConfigTool_BlobCacheEntry_t* blob)
+{
+    parameter->domain.index = domainIndex;
+    parameter->parameterType = OS_CONFIG_LIB_PARAMETER_TYPE_BLOB;
+
+    ConfigTool_UtilInitializeName(
+        parameter->parameterName.name,
+        OS_CONFIG_LIB_PARAMETER_NAME_SIZE,
+        parameterName);
+
+    uint32_t calcNumberOfBlocks = ConfigTool_UtilCalculateNumberOfBlocks(
+                                      blob->size);
+
+    Debug_LOG_DEBUG("Calculated number of blocks required: %u\n",
+                    calcNumberOfBlocks);
+
+    // Blobs with the same content point to the records written for the first
+    uint32_t firstRecord = ctx->blobRecords[blobEntry];
+    bool isWritten = (firstRecord != 0);
+
+    parameter->parameterValue.valueBlob.index = isWritten ?
+                                                (firstRecord - 1) : ctx->blobIndex;
+    parameter->parameterValue.valueBlob.numberOfBlocks = calcNumberOfBlocks;
+    parameter->parameterValue.valueBlob.size = blob->size;
+
+    OS_Error_t err = OS_ConfigServiceBackend_writeRecord(
+                         &ctx->configLib->parameterBackend,
+                         ctx->parameterIndex,
+                         parameter,
+                         sizeof(OS_ConfigServiceLibTypes_Parameter_t));
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("OS_ConfigServiceBackend_writeRecord() failed with: %d", err);
+        return err;
+    }
+
+    if (isWritten)
+    {
+        Debug_LOG_DEBUG("Blob of %s shares records from %u", parameterName,
+                        parameter->parameterValue.valueBlob.index);
+        ctx->parameterIndex++;
+        return OS_SUCCESS;
+    }
+
+    err = ConfigTool_ConfigWriterWriteVariableLengthBlob(
+              &ctx->configLib->blobBackend,
+              parameter->parameterValue.valueBlob.index,
+              parameter->parameterValue.valueBlob.numberOfBlocks,
+              &blob->source);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("OS_ConfigServiceBackend_writeRecord() failed with: %d", err);
+        return err;
+    }
+
+    ctx->blobRecords[blobEntry] = ctx->blobIndex + 1;
+    ctx->blobIndex += calcNumberOfBlocks;
+    ctx->parameterIndex++;
+
+    return OS_SUCCESS;
+}
+
+static
+OS_Error_t
+ConfigTool_HandleBlobParameter(
+    ConfigTool_ConfigWriterContext_t* ctx,
+    OS_ConfigServiceLibTypes_Parameter_t* parameter,
+    const ConfigTool_ConfigModelParam_t* param)
+{
+    // The blob was read while filling the model, so no file access is needed
+    const ConfigTool_BlobCacheEntry_t* blob =
+        ConfigTool_ConfigModelGetBlob(ctx->model, param);
+
+    Debug_LOG_DEBUG("Adding parameter %s to domain %u",
+                    param->name, param->domainIndex);
+    OS_Error_t err = ConfigTool_ConfigWriterAddBlobParameter(
+                         ctx,
+                         parameter,
+                         param->domainIndex,
+                         param->name,
+                         param->blobEntry,
+                         blob);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_ConfigWriterAddBlobParameter() failed with: %d",
+                        err);
+        return err;
+    }
+
+    return OS_SUCCESS;
+}
+
+static
+OS_Error_t
+ConfigTool_HandleInt32Parameter(
+    ConfigTool_ConfigWriterContext_t* ctx,
+    OS_ConfigServiceLibTypes_Parameter_t* parameter,
+    const ConfigTool_ConfigModelParam_t* param)
+{
+    /* Convert string to integer. Parameters can be entered either in
+     * decimal or hex format in the XML file, so base is set to 0
+     */
+    const char* value = ConfigTool_ConfigModelGetValue(ctx->model, param);
+    char* endPtr;
+    uint32_t parameterValue = strtoul(value, &endPtr, 0);
+    if (endPtr == value)
+    {
+        Debug_LOG_ERROR("strtoul() failed to convert to uint32_t value");
+        return OS_ERROR_GENERIC;
+    }
+
+    Debug_LOG_DEBUG("Adding parameter %s to domain %u",
+                    param->name, param->domainIndex);
+    OS_Error_t err = ConfigTool_ConfigWriterAddIntParameter(
+                         ctx,
+                         parameter,
+                         OS_CONFIG_LIB_PARAMETER_TYPE_INTEGER32,
+                         param->domainIndex,
+                         param->name,
+                         &parameterValue);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_ConfigWriterAddIntParameter() failed with: %d",
+                        err);
+        return err;
+    }
+
+    return OS_SUCCESS;
+}
+
+static
+OS_Error_t
+ConfigTool_HandleInt64Parameter(
+    ConfigTool_ConfigWriterContext_t* ctx,
+    OS_ConfigServiceLibTypes_Parameter_t* parameter,
+    const ConfigTool_ConfigModelParam_t* param)
+{
+    /* Convert string to long long integer. Parameters can be entered either in
+     * decimal or hex format in the XML file, so base is set to 0
+     */
+    const char* value = ConfigTool_ConfigModelGetValue(ctx->model, param);
+    char* endPtr;
+    uint64_t parameterValue = strtoull(value, &endPtr, 0);
+    if (endPtr == value)
+    {
+        Debug_LOG_ERROR("strtoull() failed to convert to uint64_t value");
+        return OS_ERROR_GENERIC;
+    }
+
+    Debug_LOG_DEBUG("Adding parameter %s to domain %u",
+                    param->name, param->domainIndex);
+    OS_Error_t err = ConfigTool_ConfigWriterAddIntParameter(
+                         ctx,
+                         parameter,
+                         OS_CONFIG_LIB_PARAMETER_TYPE_INTEGER64,
+                         param->domainIndex,
+                         param->name,
+                         &parameterValue);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_ConfigWriterAddIntParameter() failed with: %d",
+                        err);
+        return err;
+    }
+
+    return OS_SUCCESS;
+}
+
+static
+OS_Error_t
+ConfigTool_HandleStringParameter(
+    ConfigTool_ConfigWriterContext_t* ctx,
+    OS_ConfigServiceLibTypes_Parameter_t* parameter,
+    const ConfigTool_ConfigModelParam_t* param)
+{
+    Debug_LOG_DEBUG("Adding parameter %s to domain %u",
+                    param->name, param->domainIndex);
+    OS_Error_t err = ConfigTool_ConfigWriterAddStringParameter(
+                         ctx,
+                         parameter,
+                         param->domainIndex,
+                         param->name,
+                         param->stringEntry,
+                         ConfigTool_ConfigModelGetValue(ctx->model, param),
+                         param->valueLength);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_ConfigWriterAddStringParameter() failed with: %d",
+                        err);
+        return err;
+    }
+
+    return OS_SUCCESS;
+}
+
+static
+OS_Error_t
+ConfigTool_ConfigWriterWriteDomainValue(
+    ConfigTool_ConfigWriterContext_t* ctx,
+    uint32_t domainIndex,
+    const char* domainName)
+{
+    Debug_LOG_DEBUG("Domain: %s", domainName);
+
+    OS_ConfigServiceLibTypes_Domain_t domain;
+    ConfigTool_UtilInitializeDomain(&domain, domainName);
+
+    /* With clustered domains the enumerator holds the first PARAM.BIN record
+     * of the domain, its records end where the ones of the next domain start
+     */
+    if (ctx->model->isClustered)
+    {
+        domain.enumerator.index = ConfigTool_ConfigModelGetDomainStart(
+                                      ctx->model,
+                                      domainIndex);
+    }
+
+    OS_Error_t err = OS_ConfigServiceBackend_writeRecord(
+                         &ctx->configLib->domainBackend,
+                         domainIndex,
+                         &domain,
+                         sizeof(domain));
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("OS_ConfigServiceBackend_writeRecord() failed with: %d", err);
+        return err;
+    }
+
+    return OS_SUCCESS;
+}
+
+static
+OS_Error_t
+ConfigTool_ConfigWriterWriteParamValue(
+    ConfigTool_ConfigWriterContext_t* ctx,
+    const ConfigTool_ConfigModelParam_t* param)
+{
+    OS_Error_t err;
+    OS_ConfigServiceLibTypes_Parameter_t parameter = {0};
+
+    // Use _SetAll as access rights per component are currently not supported
+    if (param->hasReadAccess)
+    {
+        OS_ConfigServiceAccessRights_SetAll(&parameter.readAccess);
+    }
+
+    if (param->hasWriteAccess)
+    {
+        OS_ConfigServiceAccessRights_SetAll(&parameter.writeAccess);
+    }
+
+    Debug_LOG_DEBUG("Parameter: %s", param->name);
+
+    err = ConfigTool_ConfigWriterCheckCapacity(ctx, param);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_ConfigWriterCheckCapacity() failed with: %d", err);
+        return err;
+    }
+
+    switch (param->type)
+    {
+    case INT32:
+        Debug_LOG_DEBUG("Param Type:%s", "Int32");
+        err = ConfigTool_HandleInt32Parameter(ctx, &parameter, param);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("ConfigTool_HandleInt32Parameter() failed with: %d", err);
+            return err;
+        }
+        break;
+
+    case INT64:
+        Debug_LOG_DEBUG("Param Type:%s", "Int64");
+        err = ConfigTool_HandleInt64Parameter(ctx, &parameter, param);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("ConfigTool_HandleInt64Parameter() failed with: %d", err);
+            return err;
+        }
+        break;
+
+    case STRING:
+        Debug_LOG_DEBUG("Param Type:%s", "string");
+        Debug_LOG_DEBUG("Param Value:%s",
+                        ConfigTool_ConfigModelGetValue(ctx->model, param));
+        err = ConfigTool_HandleStringParameter(ctx, &parameter, param);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("ConfigTool_HandleStringParameter() failed with: %d", err);
+            return err;
+        }
+        break;
+
+    case BLOB:
+        Debug_LOG_DEBUG("Param Type:%s", "Blob");
+        Debug_LOG_DEBUG("Param Value:%s",
+                        ConfigTool_ConfigModelGetValue(ctx->model, param));
+        err = ConfigTool_HandleBlobParameter(ctx, &parameter, param);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("ConfigTool_HandleBlobParameter() failed with: %d", err);
+            return err;
+        }
+        break;
+
+    default:
+        Debug_LOG_ERROR("Unsupported parameter type!");
+        err = OS_ERROR_GENERIC;
+        break;
+    }
+
+    return err;
+} // end of ConfigTool_ConfigWriterWriteParamValue()
+
+
+static
+OS_Error_t
+ConfigTool_ConfigWriterWriteRecords(
+    ConfigTool_ConfigWriterContext_t* ctx)
+{
+    OS_Error_t err;
+    const ConfigTool_ConfigModel_t* model = ctx->model;
+
+    for (uint32_t i = 0; i < model->counter.domain_count; i++)
+    {
+        err = ConfigTool_ConfigWriterWriteDomainValue(
+                  ctx,
+                  i,
+                  model->domains[i].name);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("ConfigTool_ConfigWriterWriteDomainValue() failed with %d",
+                            err);
+            return err;
+        }
+    }
+
+    for (uint32_t i = 0; i < model->counter.param_count; i++)
+    {
+        err = ConfigTool_ConfigWriterWriteParamValue(
+                  ctx,
+                  &model->params[i]);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("ConfigTool_ConfigWriterWriteParamValue() failed with %d",
+                            err);
+            return err;
+        }
+    }
+
+    return OS_SUCCESS;
+}
+
+
+/* Exported functions --------------------------------------------------------*/
+OS_Error_t
+ConfigTool_ConfigWriterRun(
+    OS_ConfigServiceLib_t* configLib,
+    const ConfigTool_ConfigModel_t* model)
+{
+    ConfigTool_ConfigWriterContext_t ctx =
+    {
+        .configLib = configLib,
+        .model = model,
+    };
+
+    ctx.blobRecords = calloc(model->blobCache.count + 1, sizeof(uint32_t));
+    if (ctx.blobRecords == NULL)
+    {
+        Debug_LOG_ERROR("Failed to allocate memory");
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+
+    OS_Error_t err = ConfigTool_ConfigWriterWriteRecords(&ctx);
+
+    free(ctx.blobRecords);
+
+    return err;
+}
@@ -9,10 +9,16 @@
  */
 
 /* Includes ------------------------------------------------------------------*/
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
 #include "lib_debug/Debug.h"
 
 #include "ConfigTool_HostFs.h"
 #include "ConfigTool_HostFsFile.h"
+#include "ConfigTool_HostFsMappedFile.h"
 
 
 /* Private variables ---------------------------------------------------------*/
@@ -26,24 +32,58 @@ static const OS_FileSystem_FileOps_t hostFsFile_ops =
     .getSize    = ConfigTool_HostFsFileGetSize,
 };
 
+static const OS_FileSystem_FileOps_t hostFsMappedFile_ops =
+{
+    .open       = ConfigTool_HostFsMappedFileOpen,
+    .close      = ConfigTool_HostFsMappedFileClose,
+    .read       = ConfigTool_HostFsMappedFileRead,
+    .write      = ConfigTool_HostFsMappedFileWrite,
+    .delete     = ConfigTool_HostFsMappedFileDelete,
+    .getSize    = ConfigTool_HostFsMappedFileGetSize,
+};
+
 
 /* Public functions ----------------------------------------------------------*/
 OS_Error_t
 ConfigTool_HostFsInit(
     OS_FileSystem_Handle_t*       self,
-    const OS_FileSystem_Config_t* cfg)
+    const OS_FileSystem_Config_t* cfg,
+    ConfigTool_HostFs_Mode_t      mode,
+    const char*                   dirPath)
 {
-    OS_FileSystem_Handle_t fs;
+    ConfigTool_HostFs_t* hostFs;
 
-    if ((fs = calloc(1, sizeof(OS_FileSystem_t))) == NULL)
+    if ((hostFs = calloc(1, sizeof(ConfigTool_HostFs_t))) == NULL)
     {
         Debug_LOG_ERROR("Failed to allocate memory");
         return OS_ERROR_INSUFFICIENT_SPACE;
     }
 
-    fs->fileOps = &hostFsFile_ops;
+    hostFs->dirFd = AT_FDCWD;
+    if ((dirPath != NULL)
+        && ((hostFs->dirFd = open(dirPath, O_RDONLY | O_DIRECTORY | O_CLOEXEC))
+            < 0))
+    {
+        Debug_LOG_ERROR("open() failed for %s with errno %d", dirPath, errno);
+        free(hostFs);
+        return OS_ERROR_GENERIC;
+    }
+
+    hostFs->fs.fileOps = (mode == CONFIG_TOOL_HOST_FS_MODE_MAP) ?
+                         &hostFsMappedFile_ops : &hostFsFile_ops;
+    hostFs->mode = mode;
 
-    *self = fs;
+    for (size_t i = 0; i < MAX_FILE_HANDLES; i++)
+    {
+        hostFs->handle[i].fd = -1;
+    }
+
+    for (size_t i = 0; i < CONFIG_TOOL_HOST_FS_MAX_MAPPED_FILES; i++)
+    {
+        hostFs->mappedFile[i].fd = -1;
+    }
+
+    *self = &hostFs->fs;
 
     return OS_SUCCESS;
 }
@@ -58,7 +98,44 @@ ConfigTool_HostFsFree(
         return OS_ERROR_INVALID_PARAMETER;
     }
 
-    free(self);
+    ConfigTool_HostFs_t* hostFs = (ConfigTool_HostFs_t*)self;
+    OS_Error_t result = OS_SUCCESS;
 
-    return OS_SUCCESS;
+    // Handles left open would otherwise lose their buffered writes
+    for (OS_FileSystemFile_Handle_t i = 0; i < MAX_FILE_HANDLES; i++)
+    {
+        if (hostFs->handle[i].fd >= 0)
+        {
+            Debug_LOG_WARNING("Closing file %s left open", hostFs->handle[i].name);
+            OS_Error_t err = ConfigTool_HostFsFileClose(self, i);
+            if (err != OS_SUCCESS)
+            {
+                result = err;
+            }
+        }
+    }
+
+    // The mapped files are written back only here, independent of the handles
+    if (hostFs->mode == CONFIG_TOOL_HOST_FS_MODE_MAP)
+    {
+        OS_Error_t err = ConfigTool_HostFsMappedFileUnmapAll(self);
+        if (err != OS_SUCCESS)
+        {
+            result = err;
+        }
+    }
+
+    for (size_t i = 0; i < MAX_FILE_HANDLES; i++)
+    {
+        free(hostFs->handle[i].buffer);
+    }
+
+    if (hostFs->dirFd >= 0)
+    {
+        close(hostFs->dirFd);
+    }
+
+    free(hostFs);
+
+    return result;
 }
@@ -9,14 +9,74 @@
  */
 
 /* Includes ------------------------------------------------------------------*/
-#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include "lib_debug/Debug.h"
+#include "ConfigTool_HostFs.h"
 #include "ConfigTool_HostFsFile.h"
 
 
-/* Private variables ---------------------------------------------------------*/
-static FILE* fileHandle[MAX_FILE_HANDLES];
+/* Defines -------------------------------------------------------------------*/
+// The generic filesystem object is the first member of the host instance
+#define HOST_FS(self) ((ConfigTool_HostFs_t*)(self))
+
+
+/* Private functions ---------------------------------------------------------*/
+// Writes the complete buffer, continuing after partial writes
+static
+OS_Error_t
+ConfigTool_HostFsFilePwrite(
+    int fd,
+    off_t offset,
+    size_t len,
+    const void* buffer)
+{
+    size_t written = 0;
+
+    while (written < len)
+    {
+        ssize_t rc = pwrite(fd, (const uint8_t*)buffer + written,
+                            len - written, offset + written);
+        if (rc < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            Debug_LOG_ERROR("pwrite() failed with errno %d", errno);
+            return OS_ERROR_ABORTED;
+        }
+        written += rc;
+    }
+
+    return OS_SUCCESS;
+}
+
+// Writes the data of combined writes to the file
+static
+OS_Error_t
+ConfigTool_HostFsFileFlush(
+    ConfigTool_HostFsHandle_t* handle)
+{
+    if (handle->bufferLength == 0)
+    {
+        return OS_SUCCESS;
+    }
+
+    OS_Error_t err = ConfigTool_HostFsFilePwrite(
+                         handle->fd,
+                         handle->bufferOffset,
+                         handle->bufferLength,
+                         handle->buffer);
+    handle->bufferLength = 0;
+
+    return err;
+}
 
 
 /* Public functions ----------------------------------------------------------*/
@@ -28,37 +88,61 @@ ConfigTool_HostFsFileOpen(
     const OS_FileSystem_OpenMode_t  mode,
     const OS_FileSystem_OpenFlags_t flags)
 {
-    FILE* fp;
-    char oMode[4];
+    ConfigTool_HostFsHandle_t* handle = &HOST_FS(self)->handle[hFile];
+    int oFlags;
 
     switch (mode)
     {
     case OS_FileSystem_OpenMode_RDONLY:
-        strcpy(oMode, "rb");
+        oFlags = O_RDONLY;
         break;
     case OS_FileSystem_OpenMode_WRONLY:
-        strcpy(oMode, "rb+");
+        oFlags = O_WRONLY;
         break;
     case OS_FileSystem_OpenMode_RDWR:
+        oFlags = O_RDWR;
+        // A created file starts out empty
         if (flags & OS_FileSystem_OpenFlags_CREATE)
         {
-            strcpy(oMode, "wb+");
-            break;
+            oFlags |= O_CREAT | O_TRUNC;
         }
-        strcpy(oMode, "rb+");
         break;
     default:
         Debug_LOG_ERROR("Unsupported file open mode");
         return OS_ERROR_INVALID_PARAMETER;
     }
 
-    if ((fp = fopen(name, oMode)) == NULL)
+    if ((mode != OS_FileSystem_OpenMode_RDONLY)
+        && (flags & OS_FileSystem_OpenFlags_TRUNCATE))
     {
-        Debug_LOG_ERROR("fopen() failed");
+        oFlags |= O_TRUNC;
+    }
+
+    int fd = openat(HOST_FS(self)->dirFd, name, oFlags | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        Debug_LOG_ERROR("open() failed for %s with errno %d", name, errno);
         return OS_ERROR_GENERIC;
     }
 
-    fileHandle[hFile] = fp;
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        Debug_LOG_ERROR("fstat() failed for %s with errno %d", name, errno);
+        close(fd);
+        return OS_ERROR_GENERIC;
+    }
+
+    if ((handle->name = strdup(name)) == NULL)
+    {
+        Debug_LOG_ERROR("Failed to allocate memory");
+        close(fd);
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+
+    handle->fd = fd;
+    handle->size = st.st_size;
+    handle->bufferLength = 0;
 
     return OS_SUCCESS;
 }
@@ -68,16 +152,28 @@ ConfigTool_HostFsFileClose(
     OS_FileSystem_Handle_t     self,
     OS_FileSystemFile_Handle_t hFile)
 {
-    FILE* fp = fileHandle[hFile];
-    int rc;
+    ConfigTool_HostFsHandle_t* handle = &HOST_FS(self)->handle[hFile];
 
-    if ((rc = fclose(fp)) < 0)
+    OS_Error_t err = ConfigTool_HostFsFileFlush(handle);
+    if (err != OS_SUCCESS)
     {
-        Debug_LOG_ERROR("fclose() failed with %d", rc);
-        return OS_ERROR_GENERIC;
+        Debug_LOG_ERROR("Writing the buffered data of %s failed", handle->name);
     }
 
-    return OS_SUCCESS;
+    int rc;
+    if ((rc = close(handle->fd)) < 0)
+    {
+        Debug_LOG_ERROR("close() failed with %d", rc);
+        err = OS_ERROR_GENERIC;
+    }
+
+    // The write buffer is kept for the next file opened with this handle
+    free(handle->name);
+    handle->name = NULL;
+    handle->fd = -1;
+    handle->size = 0;
+
+    return err;
 }
 
 OS_Error_t
@@ -88,23 +184,41 @@ ConfigTool_HostFsFileRead(
     const size_t               len,
     void*                      buffer)
 {
-    FILE* fp = fileHandle[hFile];
-    size_t sz;
-    int rc;
+    ConfigTool_HostFsHandle_t* handle = &HOST_FS(self)->handle[hFile];
 
-    if ((rc = fseek(fp, offset, SEEK_SET)) != 0)
+    // Reads have to see the data of all preceding writes
+    OS_Error_t err = ConfigTool_HostFsFileFlush(handle);
+    if (err != OS_SUCCESS)
     {
-        Debug_LOG_ERROR("fseek() failed with %d", rc);
-        fclose(fp);
-        return OS_ERROR_ABORTED;
+        return err;
+    }
+
+    size_t sz = 0;
+
+    while (sz < len)
+    {
+        ssize_t rc = pread(handle->fd, (uint8_t*)buffer + sz, len - sz,
+                           offset + sz);
+        if (rc < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            Debug_LOG_ERROR("pread() failed with errno %d", errno);
+            return OS_ERROR_ABORTED;
+        }
+        if (rc == 0)
+        {
+            break;
+        }
+        sz += rc;
     }
 
-    sz = fread(buffer, 1, len, fp);
     if (sz != len)
     {
-        Debug_LOG_ERROR("fread() read %zu bytes instead of %zu bytes",
+        Debug_LOG_ERROR("pread() read %zu bytes instead of %zu bytes",
                         sz, len);
-        fclose(fp);
         return OS_ERROR_ABORTED;
     }
 
@@ -119,23 +233,61 @@ ConfigTool_HostFsFileWrite(
     const size_t               len,
     const void*                buffer)
 {
-    FILE* fp = fileHandle[hFile];
-    size_t sz;
-    int rc;
+    ConfigTool_HostFsHandle_t* handle = &HOST_FS(self)->handle[hFile];
+    OS_Error_t err;
 
-    if ((rc = fseek(fp, offset, SEEK_SET)) != 0)
+    if (CONFIG_TOOL_HOST_FS_WRITE_BUFFER_SIZE > 0)
     {
-        Debug_LOG_ERROR("fseek() failed with %d", rc);
-        fclose(fp);
-        return OS_ERROR_ABORTED;
+        // A write not adjacent to the buffered data ends the combined write
+        if ((handle->bufferLength > 0)
+            && ((offset != (handle->bufferOffset + (off_t)handle->bufferLength))
+                || (len > (CONFIG_TOOL_HOST_FS_WRITE_BUFFER_SIZE
+                           - handle->bufferLength))))
+        {
+            if ((err = ConfigTool_HostFsFileFlush(handle)) != OS_SUCCESS)
+            {
+                return err;
+            }
+        }
+
+        if (len < CONFIG_TOOL_HOST_FS_WRITE_BUFFER_SIZE)
+        {
+            if (handle->buffer == NULL)
+            {
+                handle->buffer = malloc(CONFIG_TOOL_HOST_FS_WRITE_BUFFER_SIZE);
+                if (handle->buffer == NULL)
+                {
+                    Debug_LOG_ERROR("Failed to allocate memory");
+                    return OS_ERROR_INSUFFICIENT_SPACE;
+                }
+            }
+
+            if (handle->bufferLength == 0)
+            {
+                handle->bufferOffset = offset;
+            }
+
+            memcpy(&handle->buffer[handle->bufferLength], buffer, len);
+            handle->bufferLength += len;
+
+            if ((offset + (off_t)len) > handle->size)
+            {
+                handle->size = offset + len;
+            }
+
+            return OS_SUCCESS;
+        }
     }
 
-    sz = fwrite(buffer, 1, len, fp);
-    if (sz != len)
+    err = ConfigTool_HostFsFilePwrite(handle->fd, offset, len, buffer);
+    if (err != OS_SUCCESS)
     {
-        Debug_LOG_ERROR("fwrite() wrote %zu bytes instead of %zu bytes",
-                        sz, len);
-        return OS_ERROR_ABORTED;
+        return err;
+    }
+
+    if ((offset + (off_t)len) > handle->size)
+    {
+        handle->size = offset + len;
     }
 
     return OS_SUCCESS;
@@ -148,9 +300,9 @@ ConfigTool_HostFsFileDelete(
 {
     int rc;
 
-    if ((rc = remove(name)) < 0)
+    if ((rc = unlinkat(HOST_FS(self)->dirFd, name, 0)) < 0)
     {
-        Debug_LOG_ERROR("remove() failed with %d", rc);
+        Debug_LOG_ERROR("unlink() failed with %d", rc);
         return OS_ERROR_GENERIC;
     }
 
@@ -163,42 +315,25 @@ ConfigTool_HostFsFileGetSize(
     const char*            name,
     off_t*                 sz)
 {
-    FILE* fp;
-    int rc;
-
-    if ((fp = fopen(name, "rb")) == NULL)
+    // An open file knows its size, including the data not written yet
+    for (size_t i = 0; i < MAX_FILE_HANDLES; i++)
     {
-        Debug_LOG_ERROR("fopen() failed");
-        return OS_ERROR_GENERIC;
-    }
-
-    if ((rc = fseek(fp, 0L, SEEK_END)) != 0)
-    {
-        Debug_LOG_ERROR("fseek() failed with %d", rc);
-        fclose(fp);
-        return OS_ERROR_ABORTED;
-    }
-
-    if ((*sz = ftell(fp)) < 0)
-    {
-        Debug_LOG_ERROR("ftell() failed with %lu", *sz);
-        fclose(fp);
-        return OS_ERROR_ABORTED;
-    }
-
-    // Reset the offset again
-    if ((rc = fseek(fp, 0L, SEEK_SET)) != 0)
-    {
-        Debug_LOG_ERROR("fseek() failed with %d", rc);
-        fclose(fp);
-        return OS_ERROR_ABORTED;
+        const ConfigTool_HostFsHandle_t* handle = &HOST_FS(self)->handle[i];
+        if ((handle->fd >= 0) && (strcmp(handle->name, name) == 0))
+        {
+            *sz = handle->size;
+            return OS_SUCCESS;
+        }
     }
 
-    if ((rc = fclose(fp)) < 0)
+    struct stat st;
+    if (fstatat(HOST_FS(self)->dirFd, name, &st, 0) != 0)
     {
-        Debug_LOG_ERROR("fclose() failed with %d", rc);
+        Debug_LOG_ERROR("stat() failed for %s with errno %d", name, errno);
         return OS_ERROR_GENERIC;
     }
 
+    *sz = st.st_size;
+
     return OS_SUCCESS;
 }
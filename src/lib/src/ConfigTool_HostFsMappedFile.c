@@ -0,0 +1,491 @@
+/*
+ *  Memory mapped file operations of the host FileSystem
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "lib_debug/Debug.h"
+#include "ConfigTool_HostFs.h"
+#include "ConfigTool_HostFsMappedFile.h"
+
+
+/* Defines -------------------------------------------------------------------*/
+// The generic filesystem object is the first member of the host instance
+#define HOST_FS(self) ((ConfigTool_HostFs_t*)(self))
+
+/* Smallest step a mapped file that was not reserved grows by, doubling with
+ * every further step
+ */
+#define HOST_FS_MAPPED_FILE_MIN_GROWTH  (1024 * 1024)
+
+
+/* Private functions ---------------------------------------------------------*/
+static
+ConfigTool_HostFsMappedFile_t*
+ConfigTool_HostFsMappedFileFind(
+    ConfigTool_HostFs_t* self,
+    const char* name)
+{
+    for (size_t i = 0; i < CONFIG_TOOL_HOST_FS_MAX_MAPPED_FILES; i++)
+    {
+        if ((self->mappedFile[i].name != NULL)
+            && (strcmp(self->mappedFile[i].name, name) == 0))
+        {
+            return &self->mappedFile[i];
+        }
+    }
+
+    return NULL;
+}
+
+// Maps the passed size of the file, the file is extended with zeros to it
+static
+OS_Error_t
+ConfigTool_HostFsMappedFileMap(
+    ConfigTool_HostFsMappedFile_t* file,
+    size_t mappedSize)
+{
+    if (file->data != NULL)
+    {
+        munmap(file->data, file->mappedSize);
+        file->data = NULL;
+    }
+
+    if (mappedSize > file->mappedSize)
+    {
+        if (ftruncate(file->fd, mappedSize) != 0)
+        {
+            Debug_LOG_ERROR("ftruncate() failed for %s with errno %d",
+                            file->name, errno);
+            file->mappedSize = 0;
+            return OS_ERROR_ABORTED;
+        }
+    }
+
+    void* data = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      file->fd, 0);
+    if (data == MAP_FAILED)
+    {
+        Debug_LOG_ERROR("mmap() failed for %s with errno %d", file->name, errno);
+        file->mappedSize = 0;
+        return OS_ERROR_ABORTED;
+    }
+
+    file->data = data;
+    file->mappedSize = mappedSize;
+
+    return OS_SUCCESS;
+}
+
+// Grows the mapping so it covers at least the passed size
+static
+OS_Error_t
+ConfigTool_HostFsMappedFileGrow(
+    ConfigTool_HostFsMappedFile_t* file,
+    size_t size)
+{
+    if (size <= file->mappedSize)
+    {
+        return OS_SUCCESS;
+    }
+
+    size_t mappedSize = (file->mappedSize > HOST_FS_MAPPED_FILE_MIN_GROWTH) ?
+                        file->mappedSize : HOST_FS_MAPPED_FILE_MIN_GROWTH;
+    while (mappedSize < size)
+    {
+        mappedSize *= 2;
+    }
+
+    return ConfigTool_HostFsMappedFileMap(file, mappedSize);
+}
+
+// Unmaps and closes the file, cutting it to its content size if requested
+static
+OS_Error_t
+ConfigTool_HostFsMappedFileRelease(
+    ConfigTool_HostFsMappedFile_t* file,
+    bool flush)
+{
+    OS_Error_t err = OS_SUCCESS;
+
+    if (file->data != NULL)
+    {
+        if (flush && (msync(file->data, file->mappedSize, MS_SYNC) != 0))
+        {
+            Debug_LOG_ERROR("msync() failed for %s with errno %d",
+                            file->name, errno);
+            err = OS_ERROR_GENERIC;
+        }
+        munmap(file->data, file->mappedSize);
+    }
+
+    if (flush && (ftruncate(file->fd, file->size) != 0))
+    {
+        Debug_LOG_ERROR("ftruncate() failed for %s with errno %d",
+                        file->name, errno);
+        err = OS_ERROR_GENERIC;
+    }
+
+    if (close(file->fd) != 0)
+    {
+        Debug_LOG_ERROR("close() failed for %s with errno %d", file->name, errno);
+        err = OS_ERROR_GENERIC;
+    }
+
+    free(file->name);
+    memset(file, 0, sizeof(ConfigTool_HostFsMappedFile_t));
+    file->fd = -1;
+
+    return err;
+}
+
+static
+OS_Error_t
+ConfigTool_HostFsMappedFileCreate(
+    ConfigTool_HostFs_t* self,
+    const char* name,
+    int oFlags,
+    ConfigTool_HostFsMappedFile_t** mappedFile)
+{
+    ConfigTool_HostFsMappedFile_t* file = NULL;
+
+    for (size_t i = 0; i < CONFIG_TOOL_HOST_FS_MAX_MAPPED_FILES; i++)
+    {
+        if (self->mappedFile[i].name == NULL)
+        {
+            file = &self->mappedFile[i];
+            break;
+        }
+    }
+
+    if (file == NULL)
+    {
+        Debug_LOG_ERROR("No free slot to map file %s", name);
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+
+    int fd = openat(self->dirFd, name, oFlags | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        Debug_LOG_ERROR("open() failed for %s with errno %d", name, errno);
+        return OS_ERROR_GENERIC;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        Debug_LOG_ERROR("fstat() failed for %s with errno %d", name, errno);
+        close(fd);
+        return OS_ERROR_GENERIC;
+    }
+
+    if ((file->name = strdup(name)) == NULL)
+    {
+        Debug_LOG_ERROR("Failed to allocate memory");
+        close(fd);
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+
+    file->fd = fd;
+    file->size = st.st_size;
+    file->mappedSize = st.st_size;
+
+    // An empty file is mapped on its first write
+    if (file->size > 0)
+    {
+        OS_Error_t err = ConfigTool_HostFsMappedFileMap(file, file->size);
+        if (err != OS_SUCCESS)
+        {
+            ConfigTool_HostFsMappedFileRelease(file, false);
+            return OS_ERROR_GENERIC;
+        }
+    }
+
+    *mappedFile = file;
+
+    return OS_SUCCESS;
+}
+
+
+/* Public functions ----------------------------------------------------------*/
+OS_Error_t
+ConfigTool_HostFsMappedFileOpen(
+    OS_FileSystem_Handle_t          self,
+    OS_FileSystemFile_Handle_t      hFile,
+    const char*                     name,
+    const OS_FileSystem_OpenMode_t  mode,
+    const OS_FileSystem_OpenFlags_t flags)
+{
+    ConfigTool_HostFsHandle_t* handle = &HOST_FS(self)->handle[hFile];
+    bool truncate = false;
+    int oFlags = O_RDWR;
+
+    // The mapping is shared by all handles, so every file is mapped writable
+    switch (mode)
+    {
+    case OS_FileSystem_OpenMode_RDONLY:
+        break;
+    case OS_FileSystem_OpenMode_WRONLY:
+        truncate = (flags & OS_FileSystem_OpenFlags_TRUNCATE);
+        break;
+    case OS_FileSystem_OpenMode_RDWR:
+        // A created file starts out empty
+        truncate = (flags & (OS_FileSystem_OpenFlags_CREATE
+                             | OS_FileSystem_OpenFlags_TRUNCATE));
+        if (flags & OS_FileSystem_OpenFlags_CREATE)
+        {
+            oFlags |= O_CREAT;
+        }
+        break;
+    default:
+        Debug_LOG_ERROR("Unsupported file open mode");
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    ConfigTool_HostFsMappedFile_t* file = ConfigTool_HostFsMappedFileFind(
+                                              HOST_FS(self),
+                                              name);
+    if (file == NULL)
+    {
+        OS_Error_t err = ConfigTool_HostFsMappedFileCreate(
+                             HOST_FS(self),
+                             name,
+                             truncate ? (oFlags | O_TRUNC) : oFlags,
+                             &file);
+        if (err != OS_SUCCESS)
+        {
+            return err;
+        }
+    }
+    else if (truncate && (file->size > 0))
+    {
+        // Bytes beyond the content of the file have to read as zero
+        memset(file->data, 0, file->size);
+        file->size = 0;
+    }
+
+    handle->mappedFile = file;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+ConfigTool_HostFsMappedFileClose(
+    OS_FileSystem_Handle_t     self,
+    OS_FileSystemFile_Handle_t hFile)
+{
+    HOST_FS(self)->handle[hFile].mappedFile = NULL;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+ConfigTool_HostFsMappedFileRead(
+    OS_FileSystem_Handle_t     self,
+    OS_FileSystemFile_Handle_t hFile,
+    const off_t                offset,
+    const size_t               len,
+    void*                      buffer)
+{
+    const ConfigTool_HostFsMappedFile_t* file =
+        HOST_FS(self)->handle[hFile].mappedFile;
+
+    // The file may have been deleted while the handle was still open
+    if (file == NULL)
+    {
+        Debug_LOG_ERROR("File of handle %d no longer exists", hFile);
+        return OS_ERROR_NOT_FOUND;
+    }
+
+    if ((offset < 0) || ((size_t)offset > file->size)
+        || (len > (file->size - offset)))
+    {
+        Debug_LOG_ERROR("Reading %zu bytes at offset %jd exceeds the size "
+                        "of %s", len, (intmax_t)offset, file->name);
+        return OS_ERROR_ABORTED;
+    }
+
+    memcpy(buffer, &file->data[offset], len);
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+ConfigTool_HostFsMappedFileWrite(
+    OS_FileSystem_Handle_t     self,
+    OS_FileSystemFile_Handle_t hFile,
+    const off_t                offset,
+    const size_t               len,
+    const void*                buffer)
+{
+    ConfigTool_HostFsMappedFile_t* file = HOST_FS(self)->handle[hFile].mappedFile;
+
+    if (file == NULL)
+    {
+        Debug_LOG_ERROR("File of handle %d no longer exists", hFile);
+        return OS_ERROR_NOT_FOUND;
+    }
+
+    if (len == 0)
+    {
+        return OS_SUCCESS;
+    }
+
+    OS_Error_t err = ConfigTool_HostFsMappedFileGrow(file, offset + len);
+    if (err != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    memcpy(&file->data[offset], buffer, len);
+
+    if ((offset + len) > file->size)
+    {
+        file->size = offset + len;
+    }
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+ConfigTool_HostFsMappedFileDelete(
+    OS_FileSystem_Handle_t self,
+    const char*            name)
+{
+    ConfigTool_HostFsMappedFile_t* file = ConfigTool_HostFsMappedFileFind(
+                                              HOST_FS(self),
+                                              name);
+
+    // The content of a deleted file does not need to be written back
+    if (file != NULL)
+    {
+        for (size_t i = 0; i < MAX_FILE_HANDLES; i++)
+        {
+            if (HOST_FS(self)->handle[i].mappedFile == file)
+            {
+                HOST_FS(self)->handle[i].mappedFile = NULL;
+            }
+        }
+        ConfigTool_HostFsMappedFileRelease(file, false);
+    }
+
+    int rc;
+    if ((rc = unlinkat(HOST_FS(self)->dirFd, name, 0)) < 0)
+    {
+        Debug_LOG_ERROR("unlink() failed with %d", rc);
+        return OS_ERROR_GENERIC;
+    }
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+ConfigTool_HostFsMappedFileGetSize(
+    OS_FileSystem_Handle_t self,
+    const char*            name,
+    off_t*                 sz)
+{
+    // The file on the host is larger than the content while it is mapped
+    const ConfigTool_HostFsMappedFile_t* file = ConfigTool_HostFsMappedFileFind(
+                                                    HOST_FS(self),
+                                                    name);
+    if (file != NULL)
+    {
+        *sz = file->size;
+        return OS_SUCCESS;
+    }
+
+    struct stat st;
+    if (fstatat(HOST_FS(self)->dirFd, name, &st, 0) != 0)
+    {
+        Debug_LOG_ERROR("stat() failed for %s with errno %d", name, errno);
+        return OS_ERROR_GENERIC;
+    }
+
+    *sz = st.st_size;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+ConfigTool_HostFsMappedFileReserve(
+    OS_FileSystem_Handle_t self,
+    const char*            name,
+    size_t                 size)
+{
+    ConfigTool_HostFsMappedFile_t* file = ConfigTool_HostFsMappedFileFind(
+                                              HOST_FS(self),
+                                              name);
+    if (file == NULL)
+    {
+        OS_Error_t err = ConfigTool_HostFsMappedFileCreate(
+                             HOST_FS(self),
+                             name,
+                             O_RDWR | O_CREAT | O_TRUNC,
+                             &file);
+        if (err != OS_SUCCESS)
+        {
+            return err;
+        }
+    }
+    else if (file->size > 0)
+    {
+        memset(file->data, 0, file->size);
+        file->size = 0;
+    }
+
+    // The file is extended once and mapped as a whole
+    if (size > file->mappedSize)
+    {
+        return ConfigTool_HostFsMappedFileMap(file, size);
+    }
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+ConfigTool_HostFsMappedFileUnmapAll(
+    OS_FileSystem_Handle_t self)
+{
+    ConfigTool_HostFs_t* hostFs = HOST_FS(self);
+    OS_Error_t result = OS_SUCCESS;
+
+    for (size_t i = 0; i < MAX_FILE_HANDLES; i++)
+    {
+        hostFs->handle[i].mappedFile = NULL;
+    }
+
+    for (size_t i = 0; i < CONFIG_TOOL_HOST_FS_MAX_MAPPED_FILES; i++)
+    {
+        ConfigTool_HostFsMappedFile_t* file = &hostFs->mappedFile[i];
+        if (file->name == NULL)
+        {
+            continue;
+        }
+
+        Debug_LOG_DEBUG("Flushing %zu bytes of %s", file->size, file->name);
+
+        OS_Error_t err = ConfigTool_HostFsMappedFileRelease(file, true);
+        if (err != OS_SUCCESS)
+        {
+            result = err;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,246 @@
+/*
+ * Private output directory of a provisioning run
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <dirent.h>
+
+#include "lib_debug/Debug.h"
+#include "ConfigTool_Output.h"
+#include "ConfigTool_Util.h"
+
+
+/* Defines -------------------------------------------------------------------*/
+#define OUTPUT_TMP_DIR_TEMPLATE  ".cpt-XXXXXX"
+
+
+/* Private functions ---------------------------------------------------------*/
+// Removes all files of a directory and the directory itself
+static
+void
+ConfigTool_OutputRemoveDir(
+    int parentFd,
+    const char* name)
+{
+    int fd = openat(parentFd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    DIR* dir = (fd >= 0) ? fdopendir(fd) : NULL;
+    if (dir != NULL)
+    {
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != NULL)
+        {
+            if ((strcmp(entry->d_name, ".") != 0)
+                && (strcmp(entry->d_name, "..") != 0))
+            {
+                unlinkat(fd, entry->d_name, 0);
+            }
+        }
+        closedir(dir);
+    }
+    else if (fd >= 0)
+    {
+        close(fd);
+    }
+
+    if (unlinkat(parentFd, name, AT_REMOVEDIR) != 0)
+    {
+        Debug_LOG_WARNING("Removing %s failed with errno %d", name, errno);
+    }
+}
+
+/* Exported functions --------------------------------------------------------*/
+OS_Error_t
+ConfigTool_OutputInit(
+    ConfigTool_Output_t* self,
+    const char* dir)
+{
+    memset(self, 0, sizeof(ConfigTool_Output_t));
+    self->dirFd = -1;
+    self->cwdFd = -1;
+
+    size_t len = strlen(dir) + 1 + sizeof(OUTPUT_TMP_DIR_TEMPLATE);
+    if ((self->tmpDir = malloc(len)) == NULL)
+    {
+        Debug_LOG_ERROR("Failed to allocate memory");
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+
+    snprintf(self->tmpDir, len, "%s/%s", dir, OUTPUT_TMP_DIR_TEMPLATE);
+
+    if (mkdtemp(self->tmpDir) == NULL)
+    {
+        Debug_LOG_ERROR("mkdtemp() failed in %s with errno %d", dir, errno);
+        free(self->tmpDir);
+        self->tmpDir = NULL;
+        return OS_ERROR_GENERIC;
+    }
+
+    self->dirFd = open(self->tmpDir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (self->dirFd < 0)
+    {
+        Debug_LOG_ERROR("open() failed for %s with errno %d", self->tmpDir,
+                        errno);
+        ConfigTool_OutputFree(self);
+        return OS_ERROR_GENERIC;
+    }
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+ConfigTool_OutputEnter(
+    ConfigTool_Output_t* self)
+{
+    if ((self->cwdFd = open(".", O_RDONLY | O_DIRECTORY | O_CLOEXEC)) < 0)
+    {
+        Debug_LOG_ERROR("Opening the working directory failed with errno %d",
+                        errno);
+        return OS_ERROR_GENERIC;
+    }
+
+    if (fchdir(self->dirFd) != 0)
+    {
+        Debug_LOG_ERROR("fchdir() to %s failed with errno %d", self->tmpDir,
+                        errno);
+        close(self->cwdFd);
+        self->cwdFd = -1;
+        return OS_ERROR_GENERIC;
+    }
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+ConfigTool_OutputLeave(
+    ConfigTool_Output_t* self)
+{
+    if (self->cwdFd < 0)
+    {
+        return OS_SUCCESS;
+    }
+
+    int rc = fchdir(self->cwdFd);
+    if (rc != 0)
+    {
+        Debug_LOG_ERROR("fchdir() failed with errno %d", errno);
+    }
+
+    close(self->cwdFd);
+    self->cwdFd = -1;
+
+    return (rc == 0) ? OS_SUCCESS : OS_ERROR_GENERIC;
+}
+
+OS_Error_t
+ConfigTool_OutputImport(
+    ConfigTool_Output_t* self,
+    const char* name,
+    const char* path)
+{
+    int srcFd = open(path, O_RDONLY | O_CLOEXEC);
+    if (srcFd < 0)
+    {
+        if (errno == ENOENT)
+        {
+            Debug_LOG_ERROR("%s does not exist", path);
+            return OS_ERROR_NOT_FOUND;
+        }
+        Debug_LOG_ERROR("open() failed for %s with errno %d", path, errno);
+        return OS_ERROR_GENERIC;
+    }
+
+    OS_Error_t err = OS_SUCCESS;
+    int dstFd = openat(self->dirFd, name,
+                       O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (dstFd < 0)
+    {
+        Debug_LOG_ERROR("open() failed for %s in %s with errno %d", name,
+                        self->tmpDir, errno);
+        err = OS_ERROR_GENERIC;
+    }
+    else
+    {
+        err = ConfigTool_UtilCopyFile(srcFd, dstFd);
+        if (close(dstFd) != 0)
+        {
+            Debug_LOG_ERROR("close() failed for %s in %s with errno %d", name,
+                            self->tmpDir, errno);
+            err = OS_ERROR_GENERIC;
+        }
+    }
+
+    close(srcFd);
+
+    return err;
+}
+
+OS_Error_t
+ConfigTool_OutputPublish(
+    ConfigTool_Output_t* self,
+    const char* name,
+    const char* path)
+{
+    // The content has to be on disk before the name refers to it
+    int fd = openat(self->dirFd, name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        Debug_LOG_ERROR("open() failed for %s in %s with errno %d", name,
+                        self->tmpDir, errno);
+        return OS_ERROR_GENERIC;
+    }
+
+    int rc = fsync(fd);
+    close(fd);
+    if (rc != 0)
+    {
+        Debug_LOG_ERROR("fsync() failed for %s in %s with errno %d", name,
+                        self->tmpDir, errno);
+        return OS_ERROR_GENERIC;
+    }
+
+    if (renameat(self->dirFd, name, AT_FDCWD, path) != 0)
+    {
+        Debug_LOG_ERROR("Renaming %s in %s to %s failed with errno %d", name,
+                        self->tmpDir, path, errno);
+        return OS_ERROR_GENERIC;
+    }
+
+    return OS_SUCCESS;
+}
+
+void
+ConfigTool_OutputFree(
+    ConfigTool_Output_t* self)
+{
+    ConfigTool_OutputLeave(self);
+
+    if (self->dirFd >= 0)
+    {
+        close(self->dirFd);
+        self->dirFd = -1;
+    }
+
+    if (self->tmpDir == NULL)
+    {
+        return;
+    }
+
+    // Files left over belong to a failed or partially published run
+    ConfigTool_OutputRemoveDir(AT_FDCWD, self->tmpDir);
+
+    free(self->tmpDir);
+    self->tmpDir = NULL;
+}
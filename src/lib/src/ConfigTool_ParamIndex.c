@@ -0,0 +1,509 @@
+/*
+ * Name index of the parameter records
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "lib_debug/Debug.h"
+#include "ConfigTool_ParamIndex.h"
+#include "ConfigTool_Util.h"
+
+
+/* Defines -------------------------------------------------------------------*/
+#define DIV_ROUND_UP(x, y) (((x) + (y) - 1) / (y))
+
+// Displacements tried per bucket and seeds tried before giving up
+#define PARAM_INDEX_MAX_DISPLACEMENT  (1U << 24)
+#define PARAM_INDEX_MAX_SEEDS         16
+
+// Fractional part of the golden ratio, spreads consecutive displacements
+#define PARAM_INDEX_GOLDEN            0x9e3779b97f4a7c15ULL
+
+
+/* Private types/enums -------------------------------------------------------*/
+// State of building the index with one seed
+typedef struct
+{
+    const ConfigTool_ConfigModel_t* model; /**< model of the parameters */
+    uint32_t* index;          /**< words of INDEX.BIN being built */
+    uint32_t slotCount;       /**< number of slots and keys */
+    uint32_t bucketCount;     /**< number of buckets */
+    uint64_t* hashes;         /**< hash of each key */
+    uint32_t* bucketStart;    /**< first key of each bucket in keys */
+    uint32_t* keys;           /**< keys ordered by bucket */
+    uint32_t* buckets;        /**< buckets ordered by descending size */
+    uint8_t* isTaken;         /**< slots assigned so far */
+} ConfigTool_ParamIndexContext_t;
+
+
+/* Private functions ---------------------------------------------------------*/
+// Final mix of splitmix64, every input bit affects every output bit
+static
+uint64_t
+ConfigTool_ParamIndexMix(
+    uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+
+    return x;
+}
+
+static
+uint32_t
+ConfigTool_ParamIndexGetBucket(
+    uint64_t hash,
+    uint32_t bucketCount)
+{
+    return (uint32_t)(hash >> 32) % bucketCount;
+}
+
+static
+uint32_t
+ConfigTool_ParamIndexGetPosition(
+    uint64_t hash,
+    uint32_t displacement,
+    uint32_t slotCount)
+{
+    return ConfigTool_ParamIndexMix(hash + (displacement * PARAM_INDEX_GOLDEN))
+           % slotCount;
+}
+
+static
+uint32_t
+ConfigTool_ParamIndexGetBucketCount(
+    uint32_t paramCount)
+{
+    uint32_t bucketCount = DIV_ROUND_UP(paramCount,
+                                        CONFIG_TOOL_PARAM_INDEX_BUCKET_SIZE);
+
+    return (bucketCount > 0) ? bucketCount : 1;
+}
+
+// Hashes all keys and sorts them into their buckets, largest buckets first
+static
+void
+ConfigTool_ParamIndexSortKeys(
+    ConfigTool_ParamIndexContext_t* ctx,
+    uint32_t seed)
+{
+    const ConfigTool_ConfigModel_t* model = ctx->model;
+    uint32_t* bucketStart = ctx->bucketStart;
+
+    memset(bucketStart, 0, (ctx->bucketCount + 1) * sizeof(uint32_t));
+
+    for (uint32_t i = 0; i < ctx->slotCount; i++)
+    {
+        // Keys are hashed as the device sees them, with truncated names
+        char name[OS_CONFIG_LIB_PARAMETER_NAME_SIZE];
+        ConfigTool_UtilInitializeName(name, sizeof(name), model->params[i].name);
+
+        ctx->hashes[i] = ConfigTool_ParamIndexHash(
+                             seed,
+                             model->params[i].domainIndex,
+                             name);
+        bucketStart[ConfigTool_ParamIndexGetBucket(ctx->hashes[i],
+                                                   ctx->bucketCount) + 1]++;
+    }
+
+    uint32_t maxSize = 0;
+    for (uint32_t b = 0; b < ctx->bucketCount; b++)
+    {
+        if (bucketStart[b + 1] > maxSize)
+        {
+            maxSize = bucketStart[b + 1];
+        }
+        bucketStart[b + 1] += bucketStart[b];
+    }
+
+    // The bucket order serves as fill position of each bucket for a moment
+    uint32_t* fill = ctx->buckets;
+    memcpy(fill, bucketStart, ctx->bucketCount * sizeof(uint32_t));
+    for (uint32_t i = 0; i < ctx->slotCount; i++)
+    {
+        uint32_t b = ConfigTool_ParamIndexGetBucket(ctx->hashes[i],
+                                                    ctx->bucketCount);
+        ctx->keys[fill[b]++] = i;
+    }
+
+    // Buckets by descending size, the large ones find free slots more easily
+    uint32_t next = 0;
+    for (uint32_t size = maxSize; size > 0; size--)
+    {
+        for (uint32_t b = 0; b < ctx->bucketCount; b++)
+        {
+            if ((bucketStart[b + 1] - bucketStart[b]) == size)
+            {
+                ctx->buckets[next++] = b;
+            }
+        }
+    }
+    for (uint32_t b = 0; b < ctx->bucketCount; b++)
+    {
+        if (bucketStart[b + 1] == bucketStart[b])
+        {
+            ctx->buckets[next++] = b;
+        }
+    }
+}
+
+// Rejects keys that no displacement can separate
+static
+OS_Error_t
+ConfigTool_ParamIndexCheckBucket(
+    const ConfigTool_ParamIndexContext_t* ctx,
+    uint32_t first,
+    uint32_t end)
+{
+    const ConfigTool_ConfigModel_t* model = ctx->model;
+
+    for (uint32_t i = first; i < end; i++)
+    {
+        for (uint32_t j = i + 1; j < end; j++)
+        {
+            const ConfigTool_ConfigModelParam_t* a = &model->params[ctx->keys[i]];
+            const ConfigTool_ConfigModelParam_t* b = &model->params[ctx->keys[j]];
+
+            if (ctx->hashes[ctx->keys[i]] != ctx->hashes[ctx->keys[j]])
+            {
+                continue;
+            }
+
+            if ((a->domainIndex == b->domainIndex)
+                && (strncmp(a->name, b->name,
+                            OS_CONFIG_LIB_PARAMETER_NAME_SIZE - 1) == 0))
+            {
+                Debug_LOG_ERROR("Parameter %s is defined twice in domain %s",
+                                a->name, model->domains[a->domainIndex].name);
+                return OS_ERROR_INVALID_PARAMETER;
+            }
+
+            return OS_ERROR_NOT_FOUND;
+        }
+    }
+
+    return OS_SUCCESS;
+}
+
+// Finds a displacement placing all keys of the bucket into free slots
+static
+OS_Error_t
+ConfigTool_ParamIndexPlaceBucket(
+    ConfigTool_ParamIndexContext_t* ctx,
+    uint32_t bucket)
+{
+    uint32_t first = ctx->bucketStart[bucket];
+    uint32_t end = ctx->bucketStart[bucket + 1];
+    uint32_t* slots = &ctx->index[CONFIG_TOOL_PARAM_INDEX_HEADER_WORDS
+                                  + ctx->bucketCount];
+
+    OS_Error_t err = ConfigTool_ParamIndexCheckBucket(ctx, first, end);
+    if (err != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    for (uint32_t d = 0; d < PARAM_INDEX_MAX_DISPLACEMENT; d++)
+    {
+        uint32_t placed = first;
+
+        for (; placed < end; placed++)
+        {
+            uint32_t pos = ConfigTool_ParamIndexGetPosition(
+                               ctx->hashes[ctx->keys[placed]],
+                               d,
+                               ctx->slotCount);
+            if (ctx->isTaken[pos])
+            {
+                break;
+            }
+            ctx->isTaken[pos] = 1;
+            slots[pos] = ctx->keys[placed];
+        }
+
+        if (placed == end)
+        {
+            ctx->index[CONFIG_TOOL_PARAM_INDEX_HEADER_WORDS + bucket] = d;
+            return OS_SUCCESS;
+        }
+
+        // Release the slots taken by this attempt
+        for (uint32_t k = first; k < placed; k++)
+        {
+            ctx->isTaken[ConfigTool_ParamIndexGetPosition(
+                             ctx->hashes[ctx->keys[k]],
+                             d,
+                             ctx->slotCount)] = 0;
+        }
+    }
+
+    return OS_ERROR_NOT_FOUND;
+}
+
+static
+OS_Error_t
+ConfigTool_ParamIndexBuildWithSeed(
+    ConfigTool_ParamIndexContext_t* ctx,
+    uint32_t seed)
+{
+    ConfigTool_ParamIndexHeader_t header =
+    {
+        .magic = CONFIG_TOOL_PARAM_INDEX_MAGIC,
+        .version = CONFIG_TOOL_PARAM_INDEX_VERSION,
+        .seed = seed,
+        .slotCount = ctx->slotCount,
+        .bucketCount = ctx->bucketCount,
+    };
+    memcpy(ctx->index, &header, sizeof(header));
+    memset(&ctx->index[CONFIG_TOOL_PARAM_INDEX_HEADER_WORDS], 0,
+           ctx->bucketCount * sizeof(uint32_t));
+    memset(ctx->isTaken, 0, ctx->slotCount);
+
+    ConfigTool_ParamIndexSortKeys(ctx, seed);
+
+    for (uint32_t i = 0; i < ctx->bucketCount; i++)
+    {
+        uint32_t b = ctx->buckets[i];
+        if (ctx->bucketStart[b] == ctx->bucketStart[b + 1])
+        {
+            break;
+        }
+
+        OS_Error_t err = ConfigTool_ParamIndexPlaceBucket(ctx, b);
+        if (err != OS_SUCCESS)
+        {
+            return err;
+        }
+    }
+
+    return OS_SUCCESS;
+}
+
+
+/* Exported functions --------------------------------------------------------*/
+size_t
+ConfigTool_ParamIndexGetSize(
+    uint32_t paramCount)
+{
+    return (CONFIG_TOOL_PARAM_INDEX_HEADER_WORDS
+            + ConfigTool_ParamIndexGetBucketCount(paramCount)
+            + (size_t)paramCount) * sizeof(uint32_t);
+}
+
+OS_Error_t
+ConfigTool_ParamIndexBuild(
+    const ConfigTool_ConfigModel_t* model,
+    uint32_t** index,
+    size_t* size)
+{
+    uint32_t paramCount = model->counter.param_count;
+
+    ConfigTool_ParamIndexContext_t ctx =
+    {
+        .model = model,
+        .slotCount = paramCount,
+        .bucketCount = ConfigTool_ParamIndexGetBucketCount(paramCount),
+    };
+
+    *size = ConfigTool_ParamIndexGetSize(paramCount);
+
+    // One extra element keeps the allocations valid without parameters
+    ctx.index = malloc(*size);
+    ctx.hashes = calloc(paramCount + 1, sizeof(uint64_t));
+    ctx.bucketStart = calloc(ctx.bucketCount + 1, sizeof(uint32_t));
+    ctx.keys = calloc(paramCount + 1, sizeof(uint32_t));
+    ctx.buckets = calloc(ctx.bucketCount, sizeof(uint32_t));
+    ctx.isTaken = calloc(paramCount + 1, sizeof(uint8_t));
+
+    OS_Error_t err = OS_ERROR_INSUFFICIENT_SPACE;
+
+    if ((ctx.index == NULL) || (ctx.hashes == NULL) || (ctx.bucketStart == NULL)
+        || (ctx.keys == NULL) || (ctx.buckets == NULL) || (ctx.isTaken == NULL))
+    {
+        Debug_LOG_ERROR("Failed to allocate memory");
+        goto exit;
+    }
+
+    for (uint32_t seed = 0; seed < PARAM_INDEX_MAX_SEEDS; seed++)
+    {
+        err = ConfigTool_ParamIndexBuildWithSeed(&ctx, seed);
+        if (err != OS_ERROR_NOT_FOUND)
+        {
+            break;
+        }
+        Debug_LOG_DEBUG("No perfect hash with seed %u, retrying", seed);
+    }
+
+    if (err == OS_ERROR_NOT_FOUND)
+    {
+        Debug_LOG_ERROR("No perfect hash found for %u parameters", paramCount);
+        err = OS_ERROR_GENERIC;
+    }
+
+exit:
+    free(ctx.hashes);
+    free(ctx.bucketStart);
+    free(ctx.keys);
+    free(ctx.buckets);
+    free(ctx.isTaken);
+
+    if (err != OS_SUCCESS)
+    {
+        free(ctx.index);
+        return err;
+    }
+
+    *index = ctx.index;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+ConfigTool_ParamIndexWrite(
+    const ConfigTool_ConfigModel_t* model,
+    OS_FileSystem_Handle_t hFs)
+{
+    uint32_t* index;
+    size_t size;
+
+    OS_Error_t err = ConfigTool_ParamIndexBuild(model, &index, &size);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_ParamIndexBuild() failed with %d", err);
+        return err;
+    }
+
+    OS_FileSystemFile_Handle_t hFile;
+    err = OS_FileSystemFile_open(
+              hFs,
+              &hFile,
+              INDEX_FILE,
+              OS_FileSystem_OpenMode_RDWR,
+              OS_FileSystem_OpenFlags_CREATE);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("OS_FileSystemFile_open() failed for %s with %d",
+                        INDEX_FILE, err);
+        free(index);
+        return err;
+    }
+
+    err = OS_FileSystemFile_write(hFs, hFile, 0, size, index);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("OS_FileSystemFile_write() failed for %s with %d",
+                        INDEX_FILE, err);
+    }
+
+    OS_Error_t errClose = OS_FileSystemFile_close(hFs, hFile);
+    if (errClose != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("OS_FileSystemFile_close() failed for %s with %d",
+                        INDEX_FILE, errClose);
+    }
+
+    free(index);
+
+    return (err == OS_SUCCESS) ? errClose : err;
+}
+
+uint64_t
+ConfigTool_ParamIndexHash(
+    uint32_t seed,
+    uint32_t domainIndex,
+    const char* name)
+{
+    uint64_t hash = ConfigTool_UtilHashUpdate(CONFIG_TOOL_UTIL_HASH_INIT,
+                                              &seed, sizeof(seed));
+    hash = ConfigTool_UtilHashUpdate(hash, &domainIndex, sizeof(domainIndex));
+
+    return ConfigTool_UtilHashUpdate(
+               hash,
+               name,
+               strnlen(name, OS_CONFIG_LIB_PARAMETER_NAME_SIZE));
+}
+
+uint32_t
+ConfigTool_ParamIndexGetSlot(
+    const uint32_t* index,
+    uint64_t hash)
+{
+    ConfigTool_ParamIndexHeader_t header;
+    memcpy(&header, index, sizeof(header));
+
+    // Without parameters no key is found
+    if (header.slotCount == 0)
+    {
+        return UINT32_MAX;
+    }
+
+    const uint32_t* displacements = &index[CONFIG_TOOL_PARAM_INDEX_HEADER_WORDS];
+    const uint32_t* slots = &displacements[header.bucketCount];
+
+    uint32_t bucket = ConfigTool_ParamIndexGetBucket(hash, header.bucketCount);
+
+    return slots[ConfigTool_ParamIndexGetPosition(hash, displacements[bucket],
+                                                  header.slotCount)];
+}
+
+OS_Error_t
+ConfigTool_ParamIndexValidate(
+    const void* data,
+    size_t size,
+    size_t paramCount)
+{
+    ConfigTool_ParamIndexHeader_t header;
+
+    if (size < sizeof(header))
+    {
+        Debug_LOG_ERROR("%s of %zu bytes has no header", INDEX_FILE, size);
+        return OS_ERROR_INVALID_STATE;
+    }
+    memcpy(&header, data, sizeof(header));
+
+    if ((header.magic != CONFIG_TOOL_PARAM_INDEX_MAGIC)
+        || (header.version != CONFIG_TOOL_PARAM_INDEX_VERSION))
+    {
+        Debug_LOG_ERROR("%s has an unknown format", INDEX_FILE);
+        return OS_ERROR_INVALID_STATE;
+    }
+
+    if ((header.slotCount != paramCount)
+        || (header.bucketCount != ConfigTool_ParamIndexGetBucketCount(
+                                      header.slotCount))
+        || (size != ConfigTool_ParamIndexGetSize(header.slotCount)))
+    {
+        Debug_LOG_ERROR("%s does not index %zu parameters", INDEX_FILE,
+                        paramCount);
+        return OS_ERROR_INVALID_STATE;
+    }
+
+    const uint32_t* slots = (const uint32_t*)data
+                            + CONFIG_TOOL_PARAM_INDEX_HEADER_WORDS
+                            + header.bucketCount;
+    for (uint32_t i = 0; i < header.slotCount; i++)
+    {
+        if (slots[i] >= header.slotCount)
+        {
+            Debug_LOG_ERROR("Slot %u of %s refers to record %u", i, INDEX_FILE,
+                            slots[i]);
+            return OS_ERROR_INVALID_STATE;
+        }
+    }
+
+    return OS_SUCCESS;
+}
@@ -0,0 +1,700 @@
+/*
+ * Provisioning of a configuration from an XML file to a filesystem backend
+ *
+ * Copyright (C) 2019-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <libgen.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "lib_debug/Debug.h"
+#include "ConfigTool_Provisioning.h"
+#include "ConfigTool_ConfigWriter.h"
+#include "ConfigTool_Output.h"
+#include "ConfigTool_ParamIndex.h"
+#include "ConfigTool_Stats.h"
+#include "ConfigTool_StagingFs.h"
+#include "ConfigTool_XmlParser.h"
+
+
+/* Private functions ---------------------------------------------------------*/
+static
+OS_Error_t
+ConfigTool_ProvisioningParse(
+    ConfigTool_Provisioning_t* self,
+    const char* filePath,
+    bool useStreamParser)
+{
+    // The streaming parser reads the file itself and never builds a DOM
+    if (useStreamParser)
+    {
+        return ConfigTool_XmlParserBuildModelStream(filePath, &self->model);
+    }
+
+    // Parse the file and get the DOM(document object model)
+    xmlDoc* doc = xmlReadFile(filePath, NULL, 0);
+    if (doc == NULL)
+    {
+        Debug_LOG_ERROR("Could not parse input XML file %s", filePath);
+        return OS_ERROR_GENERIC;
+    }
+
+    // Get the root element node
+    xmlNode* rootElement = xmlDocGetRootElement(doc);
+    if (rootElement == NULL)
+    {
+        Debug_LOG_ERROR("Failed to get the root element node of the XML file");
+        xmlFreeDoc(doc);
+        return OS_ERROR_GENERIC;
+    }
+
+    OS_Error_t err = ConfigTool_XmlParserBuildModel(rootElement, &self->model);
+
+    // free the document
+    xmlFreeDoc(doc);
+
+    return err;
+}
+
+// Returns the accumulated size of the records of the staged backend files
+static
+uint64_t
+ConfigTool_ProvisioningGetStagedSize(
+    const ConfigTool_ConfigServiceCounter_t* counter)
+{
+    return ((uint64_t)counter->domain_count
+            * sizeof(OS_ConfigServiceLibTypes_Domain_t))
+           + ((uint64_t)counter->param_count
+              * sizeof(OS_ConfigServiceLibTypes_Parameter_t))
+           + ((uint64_t)counter->string_count
+              * OS_CONFIG_LIB_PARAMETER_MAX_STRING_SIZE);
+}
+
+// Creates the backend files on the passed filesystem and writes all records
+static
+OS_Error_t
+ConfigTool_ProvisioningWriteRecords(
+    ConfigTool_Provisioning_t* self,
+    OS_FileSystem_Handle_t hFs,
+    bool writeIndex)
+{
+    ConfigTool_ConfigServiceCounter_t configCounter = self->model.counter;
+
+    // Initialize the configuration service library
+    Debug_LOG_DEBUG("Initializing ConfigService");
+    OS_Error_t err = ConfigTool_ConfigServiceInit(
+                         &self->configLib,
+                         hFs,
+                         &configCounter);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_ConfigServiceInit() failed with %d", err);
+        return err;
+    }
+
+    err = ConfigTool_ConfigWriterRun(&self->configLib, &self->model);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_ConfigWriterRun() failed with %d", err);
+        return err;
+    }
+
+    // The writer fills every record of the backends exactly once
+    ConfigTool_StatsAddRecords(
+        CONFIG_TOOL_STATS_FILE_DOMAIN,
+        configCounter.domain_count,
+        (uint64_t)configCounter.domain_count
+        * sizeof(OS_ConfigServiceLibTypes_Domain_t));
+    ConfigTool_StatsAddRecords(
+        CONFIG_TOOL_STATS_FILE_PARAM,
+        configCounter.param_count,
+        (uint64_t)configCounter.param_count
+        * sizeof(OS_ConfigServiceLibTypes_Parameter_t));
+    ConfigTool_StatsAddRecords(
+        CONFIG_TOOL_STATS_FILE_STRING,
+        configCounter.string_count,
+        (uint64_t)configCounter.string_count
+        * OS_CONFIG_LIB_PARAMETER_MAX_STRING_SIZE);
+    ConfigTool_StatsAddRecords(
+        CONFIG_TOOL_STATS_FILE_BLOB,
+        configCounter.blob_count,
+        (uint64_t)configCounter.blob_count
+        * OS_CONFIG_LIB_PARAMETER_MAX_BLOB_BLOCK_SIZE);
+
+    if (writeIndex)
+    {
+        err = ConfigTool_ParamIndexWrite(&self->model, hFs);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("ConfigTool_ParamIndexWrite() failed with %d", err);
+            return err;
+        }
+
+        ConfigTool_StatsAddRecords(
+            CONFIG_TOOL_STATS_FILE_INDEX,
+            1,
+            ConfigTool_ParamIndexGetSize(configCounter.param_count));
+    }
+
+    return OS_SUCCESS;
+}
+
+/* Writes the records of the metadata files to memory first and each of these
+ * files at once afterwards. The blob blocks are streamed to the backend one
+ * by one, so they are never held in memory as a whole.
+ */
+static
+OS_Error_t
+ConfigTool_ProvisioningWriteStaged(
+    ConfigTool_Provisioning_t* self,
+    bool writeIndex)
+{
+    OS_FileSystem_Handle_t hStagingFs;
+
+    OS_Error_t err = ConfigTool_StagingFsInit(&hStagingFs, self->backend.hFs,
+                                              BLOB_FILE);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_StagingFsInit() failed with %d", err);
+        return err;
+    }
+
+    err = ConfigTool_ProvisioningWriteRecords(self, hStagingFs, writeIndex);
+    if (err == OS_SUCCESS)
+    {
+        err = ConfigTool_StagingFsFlush(hStagingFs);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("ConfigTool_StagingFsFlush() failed with %d", err);
+        }
+    }
+
+    ConfigTool_StagingFsFree(hStagingFs);
+
+    return err;
+}
+
+
+// Host files of an output, the index has to be the last one
+static const char* const hostFiles[] =
+{
+    DOMAIN_FILE, PARAMETER_FILE, STRING_FILE, BLOB_FILE, INDEX_FILE
+};
+
+// Copies the files of an existing output into the private directory
+static
+OS_Error_t
+ConfigTool_ProvisioningImportOutput(
+    ConfigTool_Output_t* output,
+    OS_FileSystem_Type_t fsType,
+    const char* outPath,
+    bool* hasIndex)
+{
+    *hasIndex = false;
+
+    if (fsType != OS_FileSystem_Type_NONE)
+    {
+        return ConfigTool_OutputImport(output, HOSTSTORAGE_FILE_NAME, outPath);
+    }
+
+    // The index is published again together with the patched files
+    for (size_t i = 0; i < sizeof(hostFiles) / sizeof(hostFiles[0]); i++)
+    {
+        char path[PATH_MAX];
+        if (snprintf(path, sizeof(path), "%s/%s", outPath, hostFiles[i])
+            >= (int)sizeof(path))
+        {
+            Debug_LOG_ERROR("Output path for %s too long", hostFiles[i]);
+            return OS_ERROR_INVALID_PARAMETER;
+        }
+
+        OS_Error_t err = ConfigTool_OutputImport(output, hostFiles[i], path);
+        bool isIndex = (strcmp(hostFiles[i], INDEX_FILE) == 0);
+        if ((err == OS_ERROR_NOT_FOUND) && isIndex)
+        {
+            break;
+        }
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("Importing %s failed with %d", hostFiles[i], err);
+            return err;
+        }
+        *hasIndex = isIndex;
+    }
+
+    return OS_SUCCESS;
+}
+
+/* Images are built by the host storage in the working directory, so the
+ * private directory is entered for them. Host files are created in it by its
+ * descriptor, which leaves the working directory of the process alone.
+ */
+static
+OS_Error_t
+ConfigTool_ProvisioningEnterOutput(
+    ConfigTool_Output_t* output,
+    ConfigTool_BackendConfig_t* cfg)
+{
+    if (cfg->fsType == OS_FileSystem_Type_NONE)
+    {
+        cfg->hostDir = output->tmpDir;
+        return OS_SUCCESS;
+    }
+
+    return ConfigTool_OutputEnter(output);
+}
+
+// Opens the backend files of the output and rewrites the values
+static
+OS_Error_t
+ConfigTool_ProvisioningPatchRecords(
+    const ConfigTool_BackendConfig_t* cfg,
+    const ConfigTool_ConfigPatcherValue_t* values,
+    size_t valueCount,
+    const char* blobDir)
+{
+    ConfigTool_Backend_t backend;
+    OS_ConfigServiceLib_t configLib;
+
+    OS_Error_t err = ConfigTool_BackendOpen(&backend, cfg);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_BackendOpen() failed with %d", err);
+        return err;
+    }
+
+    err = ConfigTool_ConfigServiceOpen(&configLib, backend.hFs);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_ConfigServiceOpen() failed with %d", err);
+        ConfigTool_BackendDeInit(&backend);
+        return err;
+    }
+
+    uint64_t startTime = ConfigTool_StatsGetTime();
+    err = ConfigTool_ConfigPatcherRun(&configLib, values, valueCount, blobDir);
+    ConfigTool_StatsAddPhase(CONFIG_TOOL_STATS_PHASE_WRITE, startTime);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_ConfigPatcherRun() failed with %d", err);
+        ConfigTool_BackendDeInit(&backend);
+        return err;
+    }
+
+    err = ConfigTool_BackendDeInit(&backend);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_BackendDeInit() failed with %d", err);
+        return err;
+    }
+
+    return OS_SUCCESS;
+}
+
+/* Moves the complete output files from the private directory to their names.
+ * An index left by an earlier run is removed if there is none now.
+ */
+static
+OS_Error_t
+ConfigTool_ProvisioningPublishOutput(
+    ConfigTool_Output_t* output,
+    OS_FileSystem_Type_t fsType,
+    bool hasIndex,
+    const char* outPath)
+{
+    // Rename the generic output filename to the requested filename
+    if (fsType != OS_FileSystem_Type_NONE)
+    {
+        OS_Error_t err = ConfigTool_OutputPublish(
+                             output,
+                             HOSTSTORAGE_FILE_NAME,
+                             outPath);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("Renaming the output file failed.");
+            return err;
+        }
+
+        Debug_LOG_DEBUG("Provisioned configuration image successfully created as %s",
+                        outPath);
+        return OS_SUCCESS;
+    }
+
+    char path[PATH_MAX];
+    for (size_t i = 0; i < sizeof(hostFiles) / sizeof(hostFiles[0]); i++)
+    {
+        if (snprintf(path, sizeof(path), "%s/%s", outPath, hostFiles[i])
+            >= (int)sizeof(path))
+        {
+            Debug_LOG_ERROR("Output path for %s too long", hostFiles[i]);
+            return OS_ERROR_INVALID_PARAMETER;
+        }
+
+        if ((strcmp(hostFiles[i], INDEX_FILE) == 0) && !hasIndex)
+        {
+            break;
+        }
+
+        OS_Error_t err = ConfigTool_OutputPublish(output, hostFiles[i], path);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("Publishing %s failed with %d", hostFiles[i], err);
+            return err;
+        }
+    }
+
+    if (hasIndex)
+    {
+        return OS_SUCCESS;
+    }
+
+    // A stale index would map names to the wrong records
+    if ((unlink(path) != 0) && (errno != ENOENT))
+    {
+        Debug_LOG_ERROR("Removing %s failed with errno %d", path, errno);
+        return OS_ERROR_GENERIC;
+    }
+
+    return OS_SUCCESS;
+}
+
+
+/* Exported functions --------------------------------------------------------*/
+OS_Error_t
+ConfigTool_ProvisioningLoad(
+    ConfigTool_Provisioning_t* self,
+    const char* filePath,
+    bool useStreamParser,
+    bool clusterDomains)
+{
+    memset(self, 0, sizeof(ConfigTool_Provisioning_t));
+
+    // Get the directory path of the XML file, dirname() may modify its input
+    char* filePathCopy = strdup(filePath);
+    if (filePathCopy == NULL)
+    {
+        Debug_LOG_ERROR("Failed to allocate memory");
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+
+    /* The blob files are read again while writing, which may happen from a
+     * different working directory
+     */
+    char* dirPath = realpath(dirname(filePathCopy), NULL);
+    free(filePathCopy);
+    if (dirPath == NULL)
+    {
+        Debug_LOG_ERROR("Failed to resolve the directory of %s", filePath);
+        return OS_ERROR_GENERIC;
+    }
+
+    OS_Error_t err = ConfigTool_ConfigModelInit(&self->model, dirPath);
+    free(dirPath);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_ConfigModelInit() failed with %d", err);
+        return err;
+    }
+
+    /* Parse the configuration once into the model, which also counts the
+     * number of domains and parameter of their respective types to initialize
+     * the config service backend with
+     */
+    uint64_t startTime = ConfigTool_StatsGetTime();
+    err = ConfigTool_ProvisioningParse(self, filePath, useStreamParser);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_ProvisioningParse() failed with %d", err);
+        ConfigTool_ConfigModelFree(&self->model);
+        return err;
+    }
+
+    if (clusterDomains)
+    {
+        err = ConfigTool_ConfigModelClusterDomains(&self->model);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("ConfigTool_ConfigModelClusterDomains() failed with %d",
+                            err);
+            ConfigTool_ConfigModelFree(&self->model);
+            return err;
+        }
+    }
+    ConfigTool_StatsAddPhase(CONFIG_TOOL_STATS_PHASE_PARSE, startTime);
+
+    Debug_LOG_DEBUG("Domain Count:%u, String Count:%u, Param Count:%u, Blob Count:%u",
+                    self->model.counter.domain_count, self->model.counter.string_count,
+                    self->model.counter.param_count, self->model.counter.blob_count);
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+ConfigTool_ProvisioningWrite(
+    ConfigTool_Provisioning_t* self,
+    const ConfigTool_BackendConfig_t* cfg)
+{
+    ConfigTool_BackendConfig_t cfgBackend = *cfg;
+
+    // An undersized image would only fail deep inside the filesystem
+    if (cfgBackend.fsType != OS_FileSystem_Type_NONE)
+    {
+        uint64_t minImageSize = ConfigTool_BackendGetMinImageSize(
+                                    cfgBackend.fsType,
+                                    &self->model.counter,
+                                    cfgBackend.writeIndex);
+        if (cfgBackend.imageSize == CONFIG_TOOL_BACKEND_IMAGE_SIZE_AUTO)
+        {
+            uint64_t autoImageSize = ConfigTool_BackendGetAutoImageSize(
+                                         cfgBackend.fsType,
+                                         &self->model.counter,
+                                         cfgBackend.writeIndex);
+            if (autoImageSize > HOSTSTORAGE_SIZE)
+            {
+                Debug_LOG_ERROR("Image of %" PRIu64 " bytes exceeds the "
+                                "maximum of %zu bytes", autoImageSize,
+                                (size_t)HOSTSTORAGE_SIZE);
+                return OS_ERROR_INSUFFICIENT_SPACE;
+            }
+            cfgBackend.imageSize = autoImageSize;
+        }
+        else if (cfgBackend.imageSize < minImageSize)
+        {
+            Debug_LOG_ERROR("Image size of %zu bytes is too small, the "
+                            "configuration needs %" PRIu64 " bytes",
+                            cfgBackend.imageSize, minImageSize);
+            return OS_ERROR_INSUFFICIENT_SPACE;
+        }
+        Debug_LOG_DEBUG("Formatting an image of %zu bytes", cfgBackend.imageSize);
+    }
+
+    // Initialize file system
+    Debug_LOG_DEBUG("Initializing FileSystem");
+    OS_Error_t err = ConfigTool_BackendInit(&self->backend, &cfgBackend);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_BackendInit() failed with %d", err);
+        return err;
+    }
+
+    /* The metadata files are built in memory and then written to the
+     * filesystem in one go, unless they would take too much memory. Mapped
+     * host files are memory already, staging them would only copy the records
+     * once more.
+     */
+    uint64_t startTime = ConfigTool_StatsGetTime();
+    if ((cfgBackend.fsType == OS_FileSystem_Type_NONE)
+        && (cfgBackend.hostFsMode == CONFIG_TOOL_HOST_FS_MODE_MAP))
+    {
+        err = ConfigTool_BackendReserveFiles(&self->backend,
+                                             &self->model.counter,
+                                             cfgBackend.writeIndex);
+        if (err == OS_SUCCESS)
+        {
+            err = ConfigTool_ProvisioningWriteRecords(self, self->backend.hFs,
+                                                      cfgBackend.writeIndex);
+        }
+    }
+    else if (ConfigTool_ProvisioningGetStagedSize(&self->model.counter)
+             <= CONFIG_TOOL_STAGING_FS_LIMIT)
+    {
+        err = ConfigTool_ProvisioningWriteStaged(self, cfgBackend.writeIndex);
+    }
+    else
+    {
+        Debug_LOG_DEBUG("Metadata files exceed the staging limit, writing directly");
+        err = ConfigTool_ProvisioningWriteRecords(self, self->backend.hFs,
+                                                  cfgBackend.writeIndex);
+    }
+    ConfigTool_StatsAddPhase(CONFIG_TOOL_STATS_PHASE_WRITE, startTime);
+
+    if (err != OS_SUCCESS)
+    {
+        ConfigTool_BackendDeInit(&self->backend);
+        return err;
+    }
+
+    // Deinitialize the Filesystem backend
+    err = ConfigTool_BackendDeInit(&self->backend);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_BackendDeInit() failed with %d", err);
+        return err;
+    }
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+ConfigTool_ProvisioningPublish(
+    ConfigTool_Provisioning_t* self,
+    const ConfigTool_BackendConfig_t* cfg,
+    const char* outPath)
+{
+    // The template cache is used from inside the private directory
+    if ((cfg->templateCacheDir != NULL) && (cfg->templateCacheDir[0] != '/'))
+    {
+        Debug_LOG_ERROR("Template cache directory %s is not absolute",
+                        cfg->templateCacheDir);
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    /* Every run writes into a private directory next to its output, so
+     * concurrent runs do not share the files of the storage and the backend
+     */
+    const char* outDir = outPath;
+    char* outPathCopy = NULL;
+    if (cfg->fsType != OS_FileSystem_Type_NONE)
+    {
+        if ((outPathCopy = strdup(outPath)) == NULL)
+        {
+            Debug_LOG_ERROR("Failed to allocate memory");
+            return OS_ERROR_INSUFFICIENT_SPACE;
+        }
+        outDir = dirname(outPathCopy);
+    }
+
+    ConfigTool_Output_t output;
+    OS_Error_t err = ConfigTool_OutputInit(&output, outDir);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_OutputInit() failed with %d", err);
+        free(outPathCopy);
+        return err;
+    }
+
+    ConfigTool_BackendConfig_t cfgBackend = *cfg;
+    err = ConfigTool_ProvisioningEnterOutput(&output, &cfgBackend);
+    if (err == OS_SUCCESS)
+    {
+        err = ConfigTool_ProvisioningWrite(self, &cfgBackend);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("ConfigTool_ProvisioningWrite() failed with %d", err);
+        }
+
+        OS_Error_t errLeave = ConfigTool_OutputLeave(&output);
+        if (err == OS_SUCCESS)
+        {
+            err = errLeave;
+        }
+    }
+
+    uint64_t startTime = ConfigTool_StatsGetTime();
+    if (err == OS_SUCCESS)
+    {
+        err = ConfigTool_ProvisioningPublishOutput(&output, cfg->fsType,
+                                                   cfg->writeIndex, outPath);
+    }
+
+    if (err == OS_SUCCESS)
+    {
+        ConfigTool_StatsAddPhase(CONFIG_TOOL_STATS_PHASE_PUBLISH, startTime);
+        ConfigTool_StatsAddOutput();
+    }
+
+    ConfigTool_OutputFree(&output);
+    free(outPathCopy);
+
+    return err;
+}
+
+OS_Error_t
+ConfigTool_ProvisioningPatch(
+    const ConfigTool_BackendConfig_t* cfg,
+    const char* outPath,
+    const ConfigTool_ConfigPatcherValue_t* values,
+    size_t valueCount,
+    const char* blobDir)
+{
+    ConfigTool_BackendConfig_t cfgBackend = *cfg;
+
+    // Mapped host files are created with their final size, not opened
+    cfgBackend.hostFsMode = CONFIG_TOOL_HOST_FS_MODE_WRITE;
+
+    const char* outDir = outPath;
+    char* outPathCopy = NULL;
+    if (cfgBackend.fsType != OS_FileSystem_Type_NONE)
+    {
+        struct stat st;
+        if (stat(outPath, &st) != 0)
+        {
+            Debug_LOG_ERROR("Cannot access %s", outPath);
+            return OS_ERROR_NOT_FOUND;
+        }
+        cfgBackend.imageSize = st.st_size;
+
+        if ((outPathCopy = strdup(outPath)) == NULL)
+        {
+            Debug_LOG_ERROR("Failed to allocate memory");
+            return OS_ERROR_INSUFFICIENT_SPACE;
+        }
+        outDir = dirname(outPathCopy);
+    }
+
+    ConfigTool_Output_t output;
+    OS_Error_t err = ConfigTool_OutputInit(&output, outDir);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_OutputInit() failed with %d", err);
+        free(outPathCopy);
+        return err;
+    }
+
+    bool hasIndex;
+    err = ConfigTool_ProvisioningImportOutput(&output, cfgBackend.fsType,
+                                              outPath, &hasIndex);
+    if (err == OS_SUCCESS)
+    {
+        err = ConfigTool_ProvisioningEnterOutput(&output, &cfgBackend);
+    }
+
+    if (err == OS_SUCCESS)
+    {
+        err = ConfigTool_ProvisioningPatchRecords(&cfgBackend, values,
+                                                  valueCount, blobDir);
+
+        OS_Error_t errLeave = ConfigTool_OutputLeave(&output);
+        if (err == OS_SUCCESS)
+        {
+            err = errLeave;
+        }
+    }
+
+    if (err == OS_SUCCESS)
+    {
+        uint64_t startTime = ConfigTool_StatsGetTime();
+        err = ConfigTool_ProvisioningPublishOutput(&output, cfgBackend.fsType,
+                                                   hasIndex, outPath);
+        ConfigTool_StatsAddPhase(CONFIG_TOOL_STATS_PHASE_PUBLISH, startTime);
+    }
+
+    if (err == OS_SUCCESS)
+    {
+        ConfigTool_StatsAddOutput();
+    }
+
+    ConfigTool_OutputFree(&output);
+    free(outPathCopy);
+
+    return err;
+}
+
+void
+ConfigTool_ProvisioningFree(
+    ConfigTool_Provisioning_t* self)
+{
+    ConfigTool_ConfigModelFree(&self->model);
+}
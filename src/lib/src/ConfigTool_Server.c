@@ -0,0 +1,682 @@
+/*
+ * Provisioning server answering build requests on a Unix socket
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include "lib_debug/Debug.h"
+#include "ConfigTool_Provisioning.h"
+#include "ConfigTool_Server.h"
+
+
+/* Defines -------------------------------------------------------------------*/
+#define SERVER_MAX_REQUEST_SIZE  (64 * 1024)
+#define SERVER_MAX_REPLY_SIZE    64
+
+#ifndef SERVER_REQUEST_TIMEOUT_SEC
+// Time a client has to send its request, the server accepts nothing else
+// meanwhile
+#define SERVER_REQUEST_TIMEOUT_SEC  5
+#endif
+
+#ifndef SERVER_MAX_ENTRIES
+// Parsed configurations kept at most, the least recently used one is dropped
+#define SERVER_MAX_ENTRIES       16
+#endif
+
+
+/* Private types/enums -------------------------------------------------------*/
+// A parsed configuration, valid as long as its XML and blob files are not
+// modified
+typedef struct
+{
+    char* path;                             /**< resolved path of the XML file */
+    struct timespec mtime;                  /**< modification time when parsed */
+    off_t size;                             /**< size when parsed */
+    uint64_t lastUse;                       /**< request that used it last */
+    ConfigTool_Provisioning_t provisioning; /**< parsed configuration */
+} ConfigTool_ServerEntry_t;
+
+typedef struct
+{
+    const ConfigTool_ServerConfig_t* cfg; /**< configuration of the server */
+    int listenFd;                         /**< listening socket */
+    ConfigTool_ServerEntry_t** entries;   /**< cached configurations */
+    size_t entryCount;                    /**< number of cached configurations */
+    uint64_t requestCount;                /**< orders the entries by use */
+    size_t maxWorkers;                    /**< parallel builds */
+    size_t running;                       /**< builds in progress */
+} ConfigTool_Server_t;
+
+
+/* Private variables ---------------------------------------------------------*/
+static volatile sig_atomic_t isStopRequested;
+
+
+/* Private functions ---------------------------------------------------------*/
+static
+void
+ConfigTool_ServerStop(
+    int sig)
+{
+    (void)sig;
+    isStopRequested = 1;
+}
+
+static
+uint64_t
+ConfigTool_ServerGetElapsedUsec(
+    const struct timespec* start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)(now.tv_sec - start->tv_sec) * 1000000
+           + (now.tv_nsec - start->tv_nsec) / 1000;
+}
+
+static
+void
+ConfigTool_ServerReply(
+    int fd,
+    OS_Error_t err,
+    const struct timespec* start)
+{
+    char reply[SERVER_MAX_REPLY_SIZE];
+    uint64_t usec = ConfigTool_ServerGetElapsedUsec(start);
+    int len;
+
+    if (err == OS_SUCCESS)
+    {
+        len = snprintf(reply, sizeof(reply), "OK %llu\n",
+                       (unsigned long long)usec);
+    }
+    else
+    {
+        len = snprintf(reply, sizeof(reply), "ERROR %d %llu\n", err,
+                       (unsigned long long)usec);
+    }
+
+    for (int written = 0; written < len;)
+    {
+        ssize_t n = write(fd, &reply[written], len - written);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            // The client is gone, the output is complete anyway
+            Debug_LOG_WARNING("Sending the reply failed with errno %d", errno);
+            return;
+        }
+        written += n;
+    }
+}
+
+/* Reads the request line into the buffer, which is terminated in any case.
+ * The whole line must arrive within SERVER_REQUEST_TIMEOUT_SEC of the start,
+ * so a stalled client cannot block the server.
+ */
+static
+OS_Error_t
+ConfigTool_ServerReadRequest(
+    int fd,
+    char* buf,
+    size_t bufSize,
+    const struct timespec* start)
+{
+    const uint64_t timeout = (uint64_t)SERVER_REQUEST_TIMEOUT_SEC * 1000000;
+    size_t len = 0;
+
+    for (;;)
+    {
+        if (len == (bufSize - 1))
+        {
+            Debug_LOG_ERROR("Request exceeds %zu bytes", bufSize - 1);
+            buf[len] = '\0';
+            return OS_ERROR_INVALID_PARAMETER;
+        }
+
+        uint64_t elapsed = ConfigTool_ServerGetElapsedUsec(start);
+        if (elapsed >= timeout)
+        {
+            Debug_LOG_ERROR("Request not received within %d s",
+                            SERVER_REQUEST_TIMEOUT_SEC);
+            buf[len] = '\0';
+            return OS_ERROR_TIMEOUT;
+        }
+
+        struct timeval remaining =
+        {
+            .tv_sec  = (timeout - elapsed) / 1000000,
+            .tv_usec = (timeout - elapsed) % 1000000,
+        };
+        if (setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &remaining,
+                       sizeof(remaining)) != 0)
+        {
+            Debug_LOG_ERROR("setsockopt() failed with errno %d", errno);
+            buf[len] = '\0';
+            return OS_ERROR_GENERIC;
+        }
+
+        ssize_t n = read(fd, &buf[len], bufSize - 1 - len);
+        if (n < 0)
+        {
+            // On a timeout the deadline check above fails the request
+            if ((errno == EINTR) || (errno == EAGAIN) || (errno == EWOULDBLOCK))
+            {
+                continue;
+            }
+            Debug_LOG_ERROR("read() failed with errno %d", errno);
+            buf[len] = '\0';
+            return OS_ERROR_GENERIC;
+        }
+
+        char* end = memchr(&buf[len], '\n', n);
+        len += n;
+
+        if ((end != NULL) || (n == 0))
+        {
+            if (end == NULL)
+            {
+                end = &buf[len];
+            }
+            if ((end > buf) && (end[-1] == '\r'))
+            {
+                end--;
+            }
+            *end = '\0';
+            return OS_SUCCESS;
+        }
+    }
+}
+
+static
+OS_Error_t
+ConfigTool_ServerParseFileSystemType(
+    const char* typeName,
+    OS_FileSystem_Type_t* fsType)
+{
+    static const struct
+    {
+        const char* name;
+        OS_FileSystem_Type_t type;
+    } types[] =
+    {
+        { "-",        OS_FileSystem_Type_NONE },
+        { "FAT",      OS_FileSystem_Type_FATFS },
+        { "SPIFFS",   OS_FileSystem_Type_SPIFFS },
+        { "LITTLEFS", OS_FileSystem_Type_LITTLEFS },
+    };
+
+    for (size_t i = 0; i < (sizeof(types) / sizeof(types[0])); i++)
+    {
+        if (strcmp(typeName, types[i].name) == 0)
+        {
+            *fsType = types[i].type;
+            return OS_SUCCESS;
+        }
+    }
+
+    Debug_LOG_ERROR("Unsupported FileSystem type %s", typeName);
+    return OS_ERROR_NOT_SUPPORTED;
+}
+
+static
+void
+ConfigTool_ServerFreeEntry(
+    ConfigTool_ServerEntry_t* entry)
+{
+    ConfigTool_ProvisioningFree(&entry->provisioning);
+    free(entry->path);
+    free(entry);
+}
+
+// Returns the cached configuration of the XML file, parsing it if necessary
+static
+OS_Error_t
+ConfigTool_ServerGetEntry(
+    ConfigTool_Server_t* self,
+    const char* filePath,
+    ConfigTool_ServerEntry_t** entry)
+{
+    char path[PATH_MAX];
+    struct stat st;
+
+    if ((realpath(filePath, path) == NULL) || (stat(path, &st) != 0))
+    {
+        Debug_LOG_ERROR("Cannot access %s, errno %d", filePath, errno);
+        return OS_ERROR_NOT_FOUND;
+    }
+
+    size_t i;
+    for (i = 0; i < self->entryCount; i++)
+    {
+        if (strcmp(self->entries[i]->path, path) == 0)
+        {
+            break;
+        }
+    }
+
+    if (i < self->entryCount)
+    {
+        ConfigTool_ServerEntry_t* cached = self->entries[i];
+        if ((cached->mtime.tv_sec == st.st_mtim.tv_sec)
+            && (cached->mtime.tv_nsec == st.st_mtim.tv_nsec)
+            && (cached->size == st.st_size)
+            && !ConfigTool_BlobCacheIsModified(
+                &cached->provisioning.model.blobCache))
+        {
+            cached->lastUse = ++self->requestCount;
+            *entry = cached;
+            return OS_SUCCESS;
+        }
+
+        Debug_LOG_INFO("%s or its blob files were modified, parsing it again",
+                       path);
+        ConfigTool_ServerFreeEntry(cached);
+        self->entries[i] = self->entries[--self->entryCount];
+    }
+    else if (self->entryCount == SERVER_MAX_ENTRIES)
+    {
+        // Running workers have their own copy of the dropped configuration
+        size_t oldest = 0;
+        for (i = 1; i < self->entryCount; i++)
+        {
+            if (self->entries[i]->lastUse < self->entries[oldest]->lastUse)
+            {
+                oldest = i;
+            }
+        }
+
+        Debug_LOG_DEBUG("Dropping the cached %s", self->entries[oldest]->path);
+        ConfigTool_ServerFreeEntry(self->entries[oldest]);
+        self->entries[oldest] = self->entries[--self->entryCount];
+    }
+
+    ConfigTool_ServerEntry_t** entries = realloc(
+                                             self->entries,
+                                             (self->entryCount + 1) * sizeof(*entries));
+    if (entries == NULL)
+    {
+        Debug_LOG_ERROR("Failed to allocate memory");
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+    self->entries = entries;
+
+    ConfigTool_ServerEntry_t* newEntry = calloc(1, sizeof(*newEntry));
+    if ((newEntry == NULL) || ((newEntry->path = strdup(path)) == NULL))
+    {
+        Debug_LOG_ERROR("Failed to allocate memory");
+        free(newEntry);
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+    newEntry->mtime = st.st_mtim;
+    newEntry->size = st.st_size;
+    newEntry->lastUse = ++self->requestCount;
+
+    OS_Error_t err = ConfigTool_ProvisioningLoad(
+                         &newEntry->provisioning,
+                         path,
+                         self->cfg->useStreamParser,
+                         self->cfg->clusterDomains);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_ProvisioningLoad() failed for %s with %d",
+                        path, err);
+        free(newEntry->path);
+        free(newEntry);
+        return err;
+    }
+
+    self->entries[self->entryCount++] = newEntry;
+    *entry = newEntry;
+
+    return OS_SUCCESS;
+}
+
+// Applies the overrides to the model of the worker and writes the output
+static
+OS_Error_t
+ConfigTool_ServerBuild(
+    ConfigTool_Server_t* self,
+    ConfigTool_ServerEntry_t* entry,
+    OS_FileSystem_Type_t fsType,
+    const char* outPath,
+    char* overrides)
+{
+    ConfigTool_ConfigModel_t* model = &entry->provisioning.model;
+    OS_Error_t err;
+    char* field;
+
+    while ((field = strsep(&overrides, "\t")) != NULL)
+    {
+        char* value = strchr(field, '=');
+        if (value == NULL)
+        {
+            Debug_LOG_ERROR("Override %s has no value", field);
+            return OS_ERROR_INVALID_PARAMETER;
+        }
+        *value++ = '\0';
+
+        uint32_t paramIndex;
+        err = ConfigTool_ConfigModelFindQualifiedParam(model, field, &paramIndex);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("Unknown parameter %s", field);
+            return err;
+        }
+
+        err = ConfigTool_ConfigModelSetValue(model, paramIndex, value);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("Setting %s failed with %d", field, err);
+            return err;
+        }
+    }
+
+    err = ConfigTool_ConfigModelRecount(model);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_ConfigModelRecount() failed with %d", err);
+        return err;
+    }
+
+    ConfigTool_BackendConfig_t cfgBackend = self->cfg->cfgBackend;
+    cfgBackend.fsType = fsType;
+
+    // Mapped output files only exist without an image
+    if (fsType != OS_FileSystem_Type_NONE)
+    {
+        cfgBackend.hostFsMode = CONFIG_TOOL_HOST_FS_MODE_WRITE;
+    }
+
+    err = ConfigTool_ProvisioningPublish(&entry->provisioning, &cfgBackend,
+                                         outPath);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_ProvisioningPublish() failed for %s with %d",
+                        outPath, err);
+    }
+
+    return err;
+}
+
+/* Parses the request and hands it to a worker, which replies to the client.
+ * Returns whether a worker was started.
+ */
+static
+bool
+ConfigTool_ServerHandle(
+    ConfigTool_Server_t* self,
+    int clientFd)
+{
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    char* request = malloc(SERVER_MAX_REQUEST_SIZE);
+    if (request == NULL)
+    {
+        Debug_LOG_ERROR("Failed to allocate memory");
+        ConfigTool_ServerReply(clientFd, OS_ERROR_INSUFFICIENT_SPACE, &start);
+        return false;
+    }
+
+    OS_Error_t err = ConfigTool_ServerReadRequest(clientFd, request,
+                                                  SERVER_MAX_REQUEST_SIZE,
+                                                  &start);
+
+    char* fields = request;
+    const char* verb = strsep(&fields, "\t");
+    const char* xmlPath = strsep(&fields, "\t");
+    const char* typeName = strsep(&fields, "\t");
+    const char* outPath = strsep(&fields, "\t");
+    OS_FileSystem_Type_t fsType = OS_FileSystem_Type_NONE;
+    ConfigTool_ServerEntry_t* entry = NULL;
+
+    if (err != OS_SUCCESS)
+    {
+        // Already logged
+    }
+    else if ((strcmp(verb, "build") != 0) || (outPath == NULL)
+             || (outPath[0] == '\0'))
+    {
+        Debug_LOG_ERROR("Malformed request");
+        err = OS_ERROR_INVALID_PARAMETER;
+    }
+    else if ((xmlPath[0] != '/') || (outPath[0] != '/'))
+    {
+        // The working directory of the server is unrelated to the client's
+        Debug_LOG_ERROR("Request paths must be absolute");
+        err = OS_ERROR_INVALID_PARAMETER;
+    }
+    else if ((err = ConfigTool_ServerParseFileSystemType(typeName, &fsType))
+             != OS_SUCCESS)
+    {
+        // Already logged
+    }
+    else
+    {
+        err = ConfigTool_ServerGetEntry(self, xmlPath, &entry);
+    }
+
+    if (err != OS_SUCCESS)
+    {
+        ConfigTool_ServerReply(clientFd, err, &start);
+        free(request);
+        return false;
+    }
+
+    // Output buffered before forking would otherwise be written by the worker
+    fflush(NULL);
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        Debug_LOG_ERROR("fork() failed with errno %d", errno);
+        ConfigTool_ServerReply(clientFd, OS_ERROR_GENERIC, &start);
+        free(request);
+        return false;
+    }
+
+    if (pid == 0)
+    {
+        close(self->listenFd);
+        err = ConfigTool_ServerBuild(self, entry, fsType, outPath, fields);
+        ConfigTool_ServerReply(clientFd, err, &start);
+        fflush(NULL);
+        _exit((err == OS_SUCCESS) ? 0 : 1);
+    }
+
+    free(request);
+
+    return true;
+}
+
+// Waits for a worker and returns whether one was reaped
+static
+bool
+ConfigTool_ServerReap(
+    bool wait)
+{
+    int status;
+    pid_t pid = waitpid(-1, &status, wait ? 0 : WNOHANG);
+
+    if (pid <= 0)
+    {
+        return false;
+    }
+
+    if (!WIFEXITED(status) || (WEXITSTATUS(status) != 0))
+    {
+        Debug_LOG_WARNING("Build of worker %d failed", (int)pid);
+    }
+
+    return true;
+}
+
+static
+OS_Error_t
+ConfigTool_ServerListen(
+    ConfigTool_Server_t* self)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+
+    if (strlen(self->cfg->socketPath) >= sizeof(addr.sun_path))
+    {
+        Debug_LOG_ERROR("Socket path %s too long", self->cfg->socketPath);
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+    strcpy(addr.sun_path, self->cfg->socketPath);
+
+    // A socket left over by a server that did not shut down is replaced
+    struct stat st;
+    if ((lstat(addr.sun_path, &st) == 0) && S_ISSOCK(st.st_mode))
+    {
+        unlink(addr.sun_path);
+    }
+
+    if ((self->listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0)
+    {
+        Debug_LOG_ERROR("socket() failed with errno %d", errno);
+        return OS_ERROR_GENERIC;
+    }
+
+    /* Only the user of the server may connect, builds write to arbitrary
+     * paths with its permissions. The socket is created with these
+     * permissions right away, no other thread runs yet to see the umask.
+     */
+    mode_t mask = umask(S_IRWXG | S_IRWXO | S_IXUSR);
+    int ret = bind(self->listenFd, (struct sockaddr*)&addr, sizeof(addr));
+    umask(mask);
+
+    if ((ret != 0) || (listen(self->listenFd, SOMAXCONN) != 0))
+    {
+        Debug_LOG_ERROR("Listening on %s failed with errno %d", addr.sun_path,
+                        errno);
+        close(self->listenFd);
+        self->listenFd = -1;
+        return OS_ERROR_GENERIC;
+    }
+
+    return OS_SUCCESS;
+}
+
+
+/* Exported functions --------------------------------------------------------*/
+OS_Error_t
+ConfigTool_ServerRun(
+    const ConfigTool_ServerConfig_t* cfg)
+{
+    ConfigTool_Server_t server =
+    {
+        .cfg = cfg,
+        .listenFd = -1,
+        .maxWorkers = cfg->maxWorkers,
+    };
+
+    if (server.maxWorkers == 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        server.maxWorkers = (cpus > 0) ? (size_t)cpus : 1;
+    }
+
+    // Without SA_RESTART a signal interrupts the blocking accept() and wait()
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = ConfigTool_ServerStop;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    // Clients closing the connection early must not terminate the workers
+    signal(SIGPIPE, SIG_IGN);
+
+    OS_Error_t err = ConfigTool_ServerListen(&server);
+    if (err != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    printf("Serving build requests on %s\n", cfg->socketPath);
+    fflush(stdout);
+
+    while (!isStopRequested)
+    {
+        while ((server.running > 0) && ConfigTool_ServerReap(false))
+        {
+            server.running--;
+        }
+
+        if (server.running == server.maxWorkers)
+        {
+            if (ConfigTool_ServerReap(true))
+            {
+                server.running--;
+            }
+            continue;
+        }
+
+        int clientFd = accept(server.listenFd, NULL, NULL);
+        if (clientFd < 0)
+        {
+            if ((errno != EINTR) && (errno != ECONNABORTED))
+            {
+                Debug_LOG_ERROR("accept() failed with errno %d", errno);
+                err = OS_ERROR_GENERIC;
+                break;
+            }
+            continue;
+        }
+
+        if (ConfigTool_ServerHandle(&server, clientFd))
+        {
+            server.running++;
+        }
+        close(clientFd);
+    }
+
+    // Requests accepted before the signal are completed
+    while (server.running > 0)
+    {
+        if (ConfigTool_ServerReap(true) || (errno == ECHILD))
+        {
+            server.running--;
+        }
+    }
+
+    close(server.listenFd);
+    unlink(cfg->socketPath);
+
+    for (size_t i = 0; i < server.entryCount; i++)
+    {
+        ConfigTool_ServerFreeEntry(server.entries[i]);
+    }
+    free(server.entries);
+
+    return err;
+}
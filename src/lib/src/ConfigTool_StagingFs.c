@@ -0,0 +1,435 @@
+/*
+ * In-memory filesystem staging the backend files
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lib_debug/Debug.h"
+#include "ConfigTool_StagingFs.h"
+
+
+/* Defines -------------------------------------------------------------------*/
+// The generic filesystem object is the first member of the staging instance
+#define STAGING_FS(self) ((ConfigTool_StagingFs_t*)(self))
+
+#define STAGING_FS_INITIAL_CAPACITY  4096
+
+
+/* Private functions ---------------------------------------------------------*/
+static
+bool
+ConfigTool_StagingFsIsDirect(
+    const ConfigTool_StagingFs_t* self,
+    const char* name)
+{
+    return (self->directName != NULL) && (strcmp(self->directName, name) == 0);
+}
+
+static
+ConfigTool_StagingFsFile_t*
+ConfigTool_StagingFsFind(
+    ConfigTool_StagingFs_t* self,
+    const char* name)
+{
+    for (size_t i = 0; i < CONFIG_TOOL_STAGING_FS_MAX_FILES; i++)
+    {
+        if ((self->files[i].name != NULL)
+            && (strcmp(self->files[i].name, name) == 0))
+        {
+            return &self->files[i];
+        }
+    }
+
+    return NULL;
+}
+
+static
+ConfigTool_StagingFsFile_t*
+ConfigTool_StagingFsCreate(
+    ConfigTool_StagingFs_t* self,
+    const char* name)
+{
+    for (size_t i = 0; i < CONFIG_TOOL_STAGING_FS_MAX_FILES; i++)
+    {
+        ConfigTool_StagingFsFile_t* file = &self->files[i];
+        if (file->name == NULL)
+        {
+            if ((file->name = strdup(name)) == NULL)
+            {
+                Debug_LOG_ERROR("Failed to allocate memory");
+                return NULL;
+            }
+            return file;
+        }
+    }
+
+    Debug_LOG_ERROR("No free slot to stage file %s", name);
+    return NULL;
+}
+
+static
+void
+ConfigTool_StagingFsRelease(
+    ConfigTool_StagingFsFile_t* file)
+{
+    free(file->name);
+    free(file->data);
+    memset(file, 0, sizeof(ConfigTool_StagingFsFile_t));
+}
+
+// Grows the content of the file, the bytes in between are zero
+static
+OS_Error_t
+ConfigTool_StagingFsResize(
+    ConfigTool_StagingFsFile_t* file,
+    size_t size)
+{
+    if (size > file->capacity)
+    {
+        size_t capacity = (file->capacity > 0) ?
+                          file->capacity : STAGING_FS_INITIAL_CAPACITY;
+        while (capacity < size)
+        {
+            capacity *= 2;
+        }
+
+        uint8_t* data = realloc(file->data, capacity);
+        if (data == NULL)
+        {
+            Debug_LOG_ERROR("Failed to allocate memory");
+            return OS_ERROR_INSUFFICIENT_SPACE;
+        }
+
+        file->data = data;
+        file->capacity = capacity;
+    }
+
+    if (size > file->size)
+    {
+        memset(&file->data[file->size], 0, size - file->size);
+        file->size = size;
+    }
+
+    return OS_SUCCESS;
+}
+
+static
+OS_Error_t
+ConfigTool_StagingFsFileOpen(
+    OS_FileSystem_Handle_t          self,
+    OS_FileSystemFile_Handle_t      hFile,
+    const char*                     name,
+    const OS_FileSystem_OpenMode_t  mode,
+    const OS_FileSystem_OpenFlags_t flags)
+{
+    ConfigTool_StagingFs_t* stagingFs = STAGING_FS(self);
+
+    if (ConfigTool_StagingFsIsDirect(stagingFs, name))
+    {
+        OS_Error_t err = OS_FileSystemFile_open(stagingFs->target,
+                                                &stagingFs->targetFile[hFile],
+                                                name, mode, flags);
+        if (err == OS_SUCCESS)
+        {
+            stagingFs->isDirect[hFile] = true;
+        }
+        return err;
+    }
+
+    ConfigTool_StagingFsFile_t* file = ConfigTool_StagingFsFind(
+                                           STAGING_FS(self),
+                                           name);
+
+    if (file == NULL)
+    {
+        if (!(flags & OS_FileSystem_OpenFlags_CREATE))
+        {
+            Debug_LOG_ERROR("File %s is not staged", name);
+            return OS_ERROR_NOT_FOUND;
+        }
+
+        if ((file = ConfigTool_StagingFsCreate(STAGING_FS(self), name)) == NULL)
+        {
+            return OS_ERROR_INSUFFICIENT_SPACE;
+        }
+    }
+
+    // Same as the host filesystem, a created file starts out empty
+    if ((mode != OS_FileSystem_OpenMode_RDONLY)
+        && (flags & (OS_FileSystem_OpenFlags_CREATE
+                     | OS_FileSystem_OpenFlags_TRUNCATE)))
+    {
+        file->size = 0;
+    }
+
+    STAGING_FS(self)->openFile[hFile] = file;
+
+    return OS_SUCCESS;
+}
+
+static
+OS_Error_t
+ConfigTool_StagingFsFileClose(
+    OS_FileSystem_Handle_t     self,
+    OS_FileSystemFile_Handle_t hFile)
+{
+    ConfigTool_StagingFs_t* stagingFs = STAGING_FS(self);
+
+    if (stagingFs->isDirect[hFile])
+    {
+        stagingFs->isDirect[hFile] = false;
+        return OS_FileSystemFile_close(stagingFs->target,
+                                       stagingFs->targetFile[hFile]);
+    }
+
+    stagingFs->openFile[hFile] = NULL;
+
+    return OS_SUCCESS;
+}
+
+static
+OS_Error_t
+ConfigTool_StagingFsFileRead(
+    OS_FileSystem_Handle_t     self,
+    OS_FileSystemFile_Handle_t hFile,
+    const off_t                offset,
+    const size_t               len,
+    void*                      buffer)
+{
+    const ConfigTool_StagingFs_t* stagingFs = STAGING_FS(self);
+
+    if (stagingFs->isDirect[hFile])
+    {
+        return OS_FileSystemFile_read(stagingFs->target,
+                                      stagingFs->targetFile[hFile],
+                                      offset, len, buffer);
+    }
+
+    const ConfigTool_StagingFsFile_t* file = stagingFs->openFile[hFile];
+
+    if ((offset < 0) || ((size_t)offset > file->size)
+        || (len > (file->size - offset)))
+    {
+        Debug_LOG_ERROR("Read of %zu bytes at %jd exceeds the size of %s",
+                        len, (intmax_t)offset, file->name);
+        return OS_ERROR_ABORTED;
+    }
+
+    memcpy(buffer, &file->data[offset], len);
+
+    return OS_SUCCESS;
+}
+
+static
+OS_Error_t
+ConfigTool_StagingFsFileWrite(
+    OS_FileSystem_Handle_t     self,
+    OS_FileSystemFile_Handle_t hFile,
+    const off_t                offset,
+    const size_t               len,
+    const void*                buffer)
+{
+    ConfigTool_StagingFs_t* stagingFs = STAGING_FS(self);
+
+    if (stagingFs->isDirect[hFile])
+    {
+        return OS_FileSystemFile_write(stagingFs->target,
+                                       stagingFs->targetFile[hFile],
+                                       offset, len, buffer);
+    }
+
+    ConfigTool_StagingFsFile_t* file = stagingFs->openFile[hFile];
+
+    if ((offset < 0) || (len > (SIZE_MAX - offset)))
+    {
+        Debug_LOG_ERROR("Invalid write of %zu bytes at %jd", len,
+                        (intmax_t)offset);
+        return OS_ERROR_ABORTED;
+    }
+
+    OS_Error_t err = ConfigTool_StagingFsResize(file, offset + len);
+    if (err != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    memcpy(&file->data[offset], buffer, len);
+
+    return OS_SUCCESS;
+}
+
+static
+OS_Error_t
+ConfigTool_StagingFsFileDelete(
+    OS_FileSystem_Handle_t self,
+    const char*            name)
+{
+    if (ConfigTool_StagingFsIsDirect(STAGING_FS(self), name))
+    {
+        return OS_FileSystemFile_delete(STAGING_FS(self)->target, name);
+    }
+
+    ConfigTool_StagingFsFile_t* file = ConfigTool_StagingFsFind(
+                                           STAGING_FS(self),
+                                           name);
+    if (file == NULL)
+    {
+        Debug_LOG_ERROR("File %s is not staged", name);
+        return OS_ERROR_NOT_FOUND;
+    }
+
+    ConfigTool_StagingFsRelease(file);
+
+    return OS_SUCCESS;
+}
+
+static
+OS_Error_t
+ConfigTool_StagingFsFileGetSize(
+    OS_FileSystem_Handle_t self,
+    const char*            name,
+    off_t*                 sz)
+{
+    if (ConfigTool_StagingFsIsDirect(STAGING_FS(self), name))
+    {
+        return OS_FileSystemFile_getSize(STAGING_FS(self)->target, name, sz);
+    }
+
+    const ConfigTool_StagingFsFile_t* file = ConfigTool_StagingFsFind(
+                                                 STAGING_FS(self),
+                                                 name);
+    if (file == NULL)
+    {
+        Debug_LOG_ERROR("File %s is not staged", name);
+        return OS_ERROR_NOT_FOUND;
+    }
+
+    *sz = file->size;
+
+    return OS_SUCCESS;
+}
+
+
+/* Private variables ---------------------------------------------------------*/
+static const OS_FileSystem_FileOps_t stagingFsFile_ops =
+{
+    .open       = ConfigTool_StagingFsFileOpen,
+    .close      = ConfigTool_StagingFsFileClose,
+    .read       = ConfigTool_StagingFsFileRead,
+    .write      = ConfigTool_StagingFsFileWrite,
+    .delete     = ConfigTool_StagingFsFileDelete,
+    .getSize    = ConfigTool_StagingFsFileGetSize,
+};
+
+
+/* Public functions ----------------------------------------------------------*/
+OS_Error_t
+ConfigTool_StagingFsInit(
+    OS_FileSystem_Handle_t* self,
+    OS_FileSystem_Handle_t  target,
+    const char*             directName)
+{
+    ConfigTool_StagingFs_t* stagingFs;
+
+    if ((stagingFs = calloc(1, sizeof(ConfigTool_StagingFs_t))) == NULL)
+    {
+        Debug_LOG_ERROR("Failed to allocate memory");
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+
+    stagingFs->fs.fileOps = &stagingFsFile_ops;
+    stagingFs->target = target;
+    stagingFs->directName = directName;
+
+    *self = &stagingFs->fs;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+ConfigTool_StagingFsFlush(
+    OS_FileSystem_Handle_t self)
+{
+    ConfigTool_StagingFs_t* stagingFs = STAGING_FS(self);
+
+    for (size_t i = 0; i < CONFIG_TOOL_STAGING_FS_MAX_FILES; i++)
+    {
+        const ConfigTool_StagingFsFile_t* file = &stagingFs->files[i];
+        if (file->name == NULL)
+        {
+            continue;
+        }
+
+        OS_FileSystemFile_Handle_t hFile;
+        OS_Error_t err = OS_FileSystemFile_open(
+                             stagingFs->target,
+                             &hFile,
+                             file->name,
+                             OS_FileSystem_OpenMode_RDWR,
+                             OS_FileSystem_OpenFlags_CREATE);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("OS_FileSystemFile_open() failed for %s with %d",
+                            file->name, err);
+            return err;
+        }
+
+        if (file->size > 0)
+        {
+            err = OS_FileSystemFile_write(
+                      stagingFs->target,
+                      hFile,
+                      0,
+                      file->size,
+                      file->data);
+            if (err != OS_SUCCESS)
+            {
+                Debug_LOG_ERROR("OS_FileSystemFile_write() failed for %s with %d",
+                                file->name, err);
+                OS_FileSystemFile_close(stagingFs->target, hFile);
+                return err;
+            }
+        }
+
+        err = OS_FileSystemFile_close(stagingFs->target, hFile);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("OS_FileSystemFile_close() failed for %s with %d",
+                            file->name, err);
+            return err;
+        }
+
+        Debug_LOG_DEBUG("Flushed %zu bytes of %s", file->size, file->name);
+    }
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+ConfigTool_StagingFsFree(
+    OS_FileSystem_Handle_t self)
+{
+    if (NULL == self)
+    {
+        Debug_LOG_ERROR("Empty handle received");
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    for (size_t i = 0; i < CONFIG_TOOL_STAGING_FS_MAX_FILES; i++)
+    {
+        ConfigTool_StagingFsRelease(&STAGING_FS(self)->files[i]);
+    }
+
+    free(STAGING_FS(self));
+
+    return OS_SUCCESS;
+}
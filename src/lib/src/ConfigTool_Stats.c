@@ -0,0 +1,338 @@
+/*
+ * Phase timers and I/O counters of a run of the tool
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <errno.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+#include "lib_debug/Debug.h"
+#include "ConfigTool_Stats.h"
+#include "ConfigTool_ConfigService.h"
+#include "ConfigTool_ParamIndex.h"
+
+
+/* Defines -------------------------------------------------------------------*/
+#define NSEC_PER_SEC   UINT64_C(1000000000)
+#define NSEC_PER_MSEC  UINT64_C(1000000)
+
+
+/* Private types/enums -------------------------------------------------------*/
+// Counters shared by the main process and its workers
+typedef struct
+{
+    uint64_t startTime;                                /**< start of the run */
+    uint64_t phaseTimes[CONFIG_TOOL_STATS_PHASE_COUNT]; /**< summed times */
+    uint64_t phaseCounts[CONFIG_TOOL_STATS_PHASE_COUNT]; /**< times run */
+    uint64_t records[CONFIG_TOOL_STATS_FILE_COUNT];    /**< records written */
+    uint64_t recordBytes[CONFIG_TOOL_STATS_FILE_COUNT]; /**< bytes written */
+    uint64_t storageOps[CONFIG_TOOL_STATS_STORAGE_COUNT]; /**< operations */
+    uint64_t storageBytes[CONFIG_TOOL_STATS_STORAGE_COUNT]; /**< bytes moved */
+    uint64_t blobBytesRead;                            /**< bytes of blob files */
+    uint64_t outputCount;                              /**< completed outputs */
+} ConfigTool_StatsData_t;
+
+
+/* Private variables ---------------------------------------------------------*/
+static ConfigTool_StatsData_t* stats;
+
+static const char* const phaseNames[CONFIG_TOOL_STATS_PHASE_COUNT] =
+{
+    "parse", "format", "write", "unmount", "publish"
+};
+
+static const char* const fileNames[CONFIG_TOOL_STATS_FILE_COUNT] =
+{
+    DOMAIN_FILE, PARAMETER_FILE, STRING_FILE, BLOB_FILE, INDEX_FILE
+};
+
+static const char* const storageOpNames[CONFIG_TOOL_STATS_STORAGE_COUNT] =
+{
+    "read", "write", "erase"
+};
+
+
+/* Private functions ---------------------------------------------------------*/
+static
+void
+ConfigTool_StatsAdd(
+    uint64_t* counter,
+    uint64_t value)
+{
+    __atomic_fetch_add(counter, value, __ATOMIC_RELAXED);
+}
+
+static
+uint64_t
+ConfigTool_StatsLoad(
+    const uint64_t* counter)
+{
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
+// Peak resident set size in KiB, the largest one of this process or a worker
+static
+uint64_t
+ConfigTool_StatsGetPeakRss(void)
+{
+    struct rusage self = {0};
+    struct rusage children = {0};
+
+    getrusage(RUSAGE_SELF, &self);
+    getrusage(RUSAGE_CHILDREN, &children);
+
+    return (self.ru_maxrss > children.ru_maxrss) ?
+           (uint64_t)self.ru_maxrss : (uint64_t)children.ru_maxrss;
+}
+
+static
+void
+ConfigTool_StatsPrintTable(
+    FILE* stream,
+    uint64_t totalTime,
+    uint64_t peakRss)
+{
+    fprintf(stream, "Statistics\n");
+    fprintf(stream, "  %-12s %12s %8s\n", "phase", "time [ms]", "runs");
+    for (size_t i = 0; i < CONFIG_TOOL_STATS_PHASE_COUNT; i++)
+    {
+        uint64_t time = ConfigTool_StatsLoad(&stats->phaseTimes[i]);
+        fprintf(stream, "  %-12s %8" PRIu64 ".%03" PRIu64 " %8" PRIu64 "\n",
+                phaseNames[i], time / NSEC_PER_MSEC,
+                (time % NSEC_PER_MSEC) / 1000,
+                ConfigTool_StatsLoad(&stats->phaseCounts[i]));
+    }
+    fprintf(stream, "  %-12s %8" PRIu64 ".%03" PRIu64 "\n", "total",
+            totalTime / NSEC_PER_MSEC, (totalTime % NSEC_PER_MSEC) / 1000);
+
+    fprintf(stream, "  %-12s %12s %14s\n", "file", "records", "bytes");
+    for (size_t i = 0; i < CONFIG_TOOL_STATS_FILE_COUNT; i++)
+    {
+        fprintf(stream, "  %-12s %12" PRIu64 " %14" PRIu64 "\n", fileNames[i],
+                ConfigTool_StatsLoad(&stats->records[i]),
+                ConfigTool_StatsLoad(&stats->recordBytes[i]));
+    }
+
+    fprintf(stream, "  %-12s %12s %14s\n", "storage", "ops", "bytes");
+    for (size_t i = 0; i < CONFIG_TOOL_STATS_STORAGE_COUNT; i++)
+    {
+        fprintf(stream, "  %-12s %12" PRIu64 " %14" PRIu64 "\n",
+                storageOpNames[i],
+                ConfigTool_StatsLoad(&stats->storageOps[i]),
+                ConfigTool_StatsLoad(&stats->storageBytes[i]));
+    }
+
+    fprintf(stream, "  %-27s %14" PRIu64 "\n", "blob bytes read",
+            ConfigTool_StatsLoad(&stats->blobBytesRead));
+    fprintf(stream, "  %-27s %14" PRIu64 "\n", "outputs",
+            ConfigTool_StatsLoad(&stats->outputCount));
+    fprintf(stream, "  %-27s %14" PRIu64 "\n", "peak RSS [KiB]", peakRss);
+}
+
+static
+void
+ConfigTool_StatsPrintJson(
+    FILE* stream,
+    uint64_t totalTime,
+    uint64_t peakRss)
+{
+    fprintf(stream, "{\"total_ns\":%" PRIu64 ",\"phases\":{", totalTime);
+    for (size_t i = 0; i < CONFIG_TOOL_STATS_PHASE_COUNT; i++)
+    {
+        fprintf(stream, "%s\"%s\":{\"ns\":%" PRIu64 ",\"runs\":%" PRIu64 "}",
+                (i > 0) ? "," : "", phaseNames[i],
+                ConfigTool_StatsLoad(&stats->phaseTimes[i]),
+                ConfigTool_StatsLoad(&stats->phaseCounts[i]));
+    }
+
+    fprintf(stream, "},\"files\":{");
+    for (size_t i = 0; i < CONFIG_TOOL_STATS_FILE_COUNT; i++)
+    {
+        fprintf(stream,
+                "%s\"%s\":{\"records\":%" PRIu64 ",\"bytes\":%" PRIu64 "}",
+                (i > 0) ? "," : "", fileNames[i],
+                ConfigTool_StatsLoad(&stats->records[i]),
+                ConfigTool_StatsLoad(&stats->recordBytes[i]));
+    }
+
+    fprintf(stream, "},\"storage\":{");
+    for (size_t i = 0; i < CONFIG_TOOL_STATS_STORAGE_COUNT; i++)
+    {
+        fprintf(stream, "%s\"%s\":{\"ops\":%" PRIu64 ",\"bytes\":%" PRIu64 "}",
+                (i > 0) ? "," : "", storageOpNames[i],
+                ConfigTool_StatsLoad(&stats->storageOps[i]),
+                ConfigTool_StatsLoad(&stats->storageBytes[i]));
+    }
+
+    fprintf(stream, "},\"blob_bytes_read\":%" PRIu64 ",\"outputs\":%" PRIu64
+            ",\"peak_rss_kib\":%" PRIu64 "}\n",
+            ConfigTool_StatsLoad(&stats->blobBytesRead),
+            ConfigTool_StatsLoad(&stats->outputCount), peakRss);
+}
+
+
+/* Exported functions --------------------------------------------------------*/
+OS_Error_t
+ConfigTool_StatsEnable(void)
+{
+    if (stats != NULL)
+    {
+        return OS_SUCCESS;
+    }
+
+    void* data = mmap(NULL, sizeof(ConfigTool_StatsData_t),
+                      PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED)
+    {
+        Debug_LOG_ERROR("mmap() failed for the statistics");
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+
+    // The anonymous mapping is zeroed
+    stats = data;
+    stats->startTime = ConfigTool_StatsGetTime();
+
+    return OS_SUCCESS;
+}
+
+bool
+ConfigTool_StatsIsEnabled(void)
+{
+    return stats != NULL;
+}
+
+uint64_t
+ConfigTool_StatsGetTime(void)
+{
+    struct timespec ts;
+
+    if ((stats == NULL) || (clock_gettime(CLOCK_MONOTONIC, &ts) != 0))
+    {
+        return 0;
+    }
+
+    return ((uint64_t)ts.tv_sec * NSEC_PER_SEC) + (uint64_t)ts.tv_nsec;
+}
+
+void
+ConfigTool_StatsAddPhase(
+    ConfigTool_StatsPhase_t phase,
+    uint64_t startTime)
+{
+    if (stats == NULL)
+    {
+        return;
+    }
+
+    ConfigTool_StatsAdd(&stats->phaseTimes[phase],
+                        ConfigTool_StatsGetTime() - startTime);
+    ConfigTool_StatsAdd(&stats->phaseCounts[phase], 1);
+}
+
+void
+ConfigTool_StatsAddRecords(
+    ConfigTool_StatsFile_t file,
+    uint64_t records,
+    uint64_t bytes)
+{
+    if (stats == NULL)
+    {
+        return;
+    }
+
+    ConfigTool_StatsAdd(&stats->records[file], records);
+    ConfigTool_StatsAdd(&stats->recordBytes[file], bytes);
+}
+
+void
+ConfigTool_StatsAddStorageOp(
+    ConfigTool_StatsStorageOp_t op,
+    uint64_t bytes)
+{
+    if (stats == NULL)
+    {
+        return;
+    }
+
+    ConfigTool_StatsAdd(&stats->storageOps[op], 1);
+    ConfigTool_StatsAdd(&stats->storageBytes[op], bytes);
+}
+
+void
+ConfigTool_StatsAddBlobRead(
+    uint64_t bytes)
+{
+    if (stats == NULL)
+    {
+        return;
+    }
+
+    ConfigTool_StatsAdd(&stats->blobBytesRead, bytes);
+}
+
+void
+ConfigTool_StatsAddOutput(void)
+{
+    if (stats == NULL)
+    {
+        return;
+    }
+
+    ConfigTool_StatsAdd(&stats->outputCount, 1);
+}
+
+OS_Error_t
+ConfigTool_StatsPrint(
+    ConfigTool_StatsFormat_t format,
+    const char* path)
+{
+    if (stats == NULL)
+    {
+        return OS_SUCCESS;
+    }
+
+    uint64_t totalTime = ConfigTool_StatsGetTime() - stats->startTime;
+    uint64_t peakRss = ConfigTool_StatsGetPeakRss();
+
+    // The report must not mix with the output of the run on stdout
+    FILE* stream = (path != NULL) ? fopen(path, "w") : stderr;
+    if (stream == NULL)
+    {
+        Debug_LOG_ERROR("Opening %s failed with errno %d", path, errno);
+        return OS_ERROR_GENERIC;
+    }
+
+    if (format == CONFIG_TOOL_STATS_FORMAT_JSON)
+    {
+        ConfigTool_StatsPrintJson(stream, totalTime, peakRss);
+    }
+    else
+    {
+        ConfigTool_StatsPrintTable(stream, totalTime, peakRss);
+    }
+
+    if (path == NULL)
+    {
+        fflush(stream);
+        return OS_SUCCESS;
+    }
+
+    if (fclose(stream) != 0)
+    {
+        Debug_LOG_ERROR("Writing %s failed with errno %d", path, errno);
+        return OS_ERROR_GENERIC;
+    }
+
+    return OS_SUCCESS;
+}
@@ -0,0 +1,146 @@
+/*
+ * Pool of the unique string values of a configuration
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "lib_debug/Debug.h"
+#include "ConfigTool_StringPool.h"
+#include "ConfigTool_Util.h"
+
+
+/* Private functions ---------------------------------------------------------*/
+static
+uint32_t*
+ConfigTool_StringPoolFindBucket(
+    const ConfigTool_StringPool_t* self,
+    const char* values,
+    const char* value,
+    size_t length,
+    uint64_t hash)
+{
+    uint32_t* bucket = ConfigTool_UtilHashTableFirst(&self->table, hash);
+
+    for (; *bucket != 0; bucket = ConfigTool_UtilHashTableNext(&self->table,
+                                                               bucket))
+    {
+        const ConfigTool_StringPoolEntry_t* entry = &self->entries[*bucket - 1];
+        if ((entry->hash == hash) && (entry->length == length)
+            && (memcmp(&values[entry->valueOffset], value, length) == 0))
+        {
+            break;
+        }
+    }
+
+    return bucket;
+}
+
+static
+OS_Error_t
+ConfigTool_StringPoolGrow(
+    ConfigTool_StringPool_t* self)
+{
+    bool isRehashNeeded;
+    OS_Error_t err = ConfigTool_UtilHashTableReserve(&self->table, self->count,
+                                                     &isRehashNeeded);
+    if (err != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    // The pooled values are unique, so no comparison is needed
+    for (uint32_t i = 0; isRehashNeeded && (i < self->count); i++)
+    {
+        ConfigTool_UtilHashTableInsert(&self->table, self->entries[i].hash, i);
+    }
+
+    if (self->count == self->capacity)
+    {
+        uint32_t capacity = (self->capacity > 0) ?
+                            (self->capacity * 2) :
+                            CONFIG_TOOL_UTIL_HASH_TABLE_INITIAL_BUCKETS;
+        ConfigTool_StringPoolEntry_t* entries = realloc(
+                                                    self->entries,
+                                                    capacity * sizeof(ConfigTool_StringPoolEntry_t));
+        if (entries == NULL)
+        {
+            Debug_LOG_ERROR("Failed to allocate memory");
+            return OS_ERROR_INSUFFICIENT_SPACE;
+        }
+
+        self->entries = entries;
+        self->capacity = capacity;
+    }
+
+    return OS_SUCCESS;
+}
+
+
+/* Public functions ----------------------------------------------------------*/
+void
+ConfigTool_StringPoolInit(
+    ConfigTool_StringPool_t* self)
+{
+    memset(self, 0, sizeof(ConfigTool_StringPool_t));
+}
+
+void
+ConfigTool_StringPoolFree(
+    ConfigTool_StringPool_t* self)
+{
+    free(self->entries);
+    ConfigTool_UtilHashTableFree(&self->table);
+
+    memset(self, 0, sizeof(ConfigTool_StringPool_t));
+}
+
+OS_Error_t
+ConfigTool_StringPoolIntern(
+    ConfigTool_StringPool_t* self,
+    const char* values,
+    size_t valueOffset,
+    size_t length,
+    uint32_t* entryIndex)
+{
+    OS_Error_t err = ConfigTool_StringPoolGrow(self);
+    if (err != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    const char* value = &values[valueOffset];
+    uint64_t hash = ConfigTool_UtilHash(value, length);
+    uint32_t* bucket = ConfigTool_StringPoolFindBucket(
+                           self,
+                           values,
+                           value,
+                           length,
+                           hash);
+
+    self->references++;
+
+    if (*bucket != 0)
+    {
+        *entryIndex = *bucket - 1;
+        return OS_SUCCESS;
+    }
+
+    ConfigTool_StringPoolEntry_t* entry = &self->entries[self->count];
+    entry->hash = hash;
+    entry->valueOffset = valueOffset;
+    entry->length = length;
+
+    *bucket = self->count + 1;
+    *entryIndex = self->count;
+    self->count++;
+
+    return OS_SUCCESS;
+}
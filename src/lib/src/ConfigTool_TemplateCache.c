@@ -0,0 +1,203 @@
+/*
+ * On-disk cache of freshly formatted, empty partition images
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+// mkostemp() is a GNU extension
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include "lib_debug/Debug.h"
+#include "ConfigTool_TemplateCache.h"
+#include "ConfigTool_Util.h"
+
+
+/* Private functions ---------------------------------------------------------*/
+static
+OS_Error_t
+ConfigTool_TemplateCacheGetPath(
+    char* buf,
+    size_t bufSize,
+    const char* cacheDir,
+    OS_FileSystem_Type_t fsType,
+    size_t size)
+{
+    const char* fsName;
+
+    switch (fsType)
+    {
+    case OS_FileSystem_Type_FATFS:
+        fsName = "FAT";
+        break;
+    case OS_FileSystem_Type_LITTLEFS:
+        fsName = "LITTLEFS";
+        break;
+    case OS_FileSystem_Type_SPIFFS:
+        fsName = "SPIFFS";
+        break;
+    default:
+        Debug_LOG_ERROR("Unsupported FileSystem type.");
+        return OS_ERROR_NOT_SUPPORTED;
+    }
+
+    if (snprintf(buf, bufSize, "%s/%s-%zu.img", cacheDir, fsName, size)
+        >= (int)bufSize)
+    {
+        Debug_LOG_ERROR("Template path in %s too long", cacheDir);
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    return OS_SUCCESS;
+}
+
+/* Exported functions --------------------------------------------------------*/
+OS_Error_t
+ConfigTool_TemplateCacheLoad(
+    const char* cacheDir,
+    OS_FileSystem_Type_t fsType,
+    size_t size,
+    const char* path)
+{
+    char templatePath[PATH_MAX];
+
+    OS_Error_t err = ConfigTool_TemplateCacheGetPath(
+                         templatePath,
+                         sizeof(templatePath),
+                         cacheDir,
+                         fsType,
+                         size);
+    if (err != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    int srcFd = open(templatePath, O_RDONLY | O_CLOEXEC);
+    if (srcFd < 0)
+    {
+        if (errno == ENOENT)
+        {
+            return OS_ERROR_NOT_FOUND;
+        }
+        Debug_LOG_ERROR("open() failed for %s with errno %d", templatePath,
+                        errno);
+        return OS_ERROR_GENERIC;
+    }
+
+    int dstFd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (dstFd < 0)
+    {
+        Debug_LOG_ERROR("open() failed for %s with errno %d", path, errno);
+        close(srcFd);
+        return OS_ERROR_GENERIC;
+    }
+
+    err = ConfigTool_UtilCopyFile(srcFd, dstFd);
+
+    close(srcFd);
+    if (close(dstFd) != 0)
+    {
+        Debug_LOG_ERROR("close() failed for %s with errno %d", path, errno);
+        err = OS_ERROR_GENERIC;
+    }
+
+    if (err == OS_SUCCESS)
+    {
+        Debug_LOG_DEBUG("Cloned template %s", templatePath);
+    }
+
+    return err;
+}
+
+OS_Error_t
+ConfigTool_TemplateCacheStore(
+    const char* cacheDir,
+    OS_FileSystem_Type_t fsType,
+    size_t size,
+    const char* path)
+{
+    char templatePath[PATH_MAX];
+    char tmpPath[PATH_MAX];
+
+    OS_Error_t err = ConfigTool_TemplateCacheGetPath(
+                         templatePath,
+                         sizeof(templatePath),
+                         cacheDir,
+                         fsType,
+                         size);
+    if (err != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    if (snprintf(tmpPath, sizeof(tmpPath), "%s/.tmp-XXXXXX", cacheDir)
+        >= (int)sizeof(tmpPath))
+    {
+        Debug_LOG_ERROR("Template path in %s too long", cacheDir);
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    int srcFd = open(path, O_RDONLY | O_CLOEXEC);
+    if (srcFd < 0)
+    {
+        Debug_LOG_ERROR("open() failed for %s with errno %d", path, errno);
+        return OS_ERROR_GENERIC;
+    }
+
+    // Readers only ever see complete templates
+    int dstFd = mkostemp(tmpPath, O_CLOEXEC);
+    if (dstFd < 0)
+    {
+        Debug_LOG_ERROR("mkostemp() failed in %s with errno %d", cacheDir,
+                        errno);
+        close(srcFd);
+        return OS_ERROR_GENERIC;
+    }
+
+    err = ConfigTool_UtilCopyFile(srcFd, dstFd);
+    close(srcFd);
+
+    // The storage only covers the blocks written while formatting
+    if ((err == OS_SUCCESS) && (ftruncate(dstFd, size) != 0))
+    {
+        Debug_LOG_ERROR("ftruncate() failed for %s with errno %d", tmpPath,
+                        errno);
+        err = OS_ERROR_GENERIC;
+    }
+
+    if (close(dstFd) != 0)
+    {
+        Debug_LOG_ERROR("close() failed for %s with errno %d", tmpPath, errno);
+        err = OS_ERROR_GENERIC;
+    }
+
+    if ((err == OS_SUCCESS) && (rename(tmpPath, templatePath) != 0))
+    {
+        Debug_LOG_ERROR("Renaming %s to %s failed with errno %d", tmpPath,
+                        templatePath, errno);
+        err = OS_ERROR_GENERIC;
+    }
+
+    if (err != OS_SUCCESS)
+    {
+        unlink(tmpPath);
+        return err;
+    }
+
+    Debug_LOG_DEBUG("Stored template %s", templatePath);
+
+    return OS_SUCCESS;
+}
@@ -9,21 +9,29 @@
  */
 
 /* Includes ------------------------------------------------------------------*/
+// copy_file_range() is a GNU extension
+#define _GNU_SOURCE
+
 #include <string.h>
 #include <stdlib.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
 
 #include "lib_debug/Debug.h"
 #include "ConfigTool_Util.h"
 
 
+/* Defines -------------------------------------------------------------------*/
+#define UTIL_COPY_BUFFER_SIZE  (64 * 1024)
+
 
 /* Public functions ----------------------------------------------------------*/
 uint32_t
-ConfigTool_UtilCalculateNumberOfBlocks(const char* blobValue)
+ConfigTool_UtilCalculateNumberOfBlocks(size_t blobSize)
 {
-    // strlen() does not include NULL terminator
-    uint32_t blobSize = strlen(blobValue) + 1;
-
     uint32_t calcNumberOfBlocks;
 
     if (blobSize <= OS_CONFIG_LIB_PARAMETER_MAX_BLOB_BLOCK_SIZE)
@@ -45,6 +53,27 @@ ConfigTool_UtilCalculateNumberOfBlocks(const char* blobValue)
     return calcNumberOfBlocks;
 }
 
+OS_Error_t
+ConfigTool_UtilParseInteger(
+    const char* value,
+    uint64_t max,
+    uint64_t* result)
+{
+    char* end;
+    errno = 0;
+    unsigned long long parsed = strtoull(value, &end, 0);
+    if ((errno != 0) || (end == value) || (*end != '\0') || (value[0] == '-')
+        || (parsed > max))
+    {
+        Debug_LOG_ERROR("Invalid integer value %s", value);
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    *result = parsed;
+
+    return OS_SUCCESS;
+}
+
 void
 ConfigTool_UtilInitializeDomain(
     OS_ConfigServiceLibTypes_Domain_t* domain,
@@ -66,47 +95,160 @@ void ConfigTool_UtilInitializeName(
     strncpy(buf, name, bufSize - 1);
 }
 
-char* ConfigTool_UtilCopyFileToBuf(const char* filename)
+uint64_t
+ConfigTool_UtilHash(
+    const void* data,
+    size_t len)
 {
-    FILE* handler = fopen(filename, "r");
-    if (handler == NULL)
+    return ConfigTool_UtilHashUpdate(CONFIG_TOOL_UTIL_HASH_INIT, data, len);
+}
+
+uint64_t
+ConfigTool_UtilHashUpdate(
+    uint64_t hash,
+    const void* data,
+    size_t len)
+{
+    const uint8_t* bytes = data;
+
+    for (size_t i = 0; i < len; i++)
     {
-        Debug_LOG_ERROR("Failed to open file!");
-        return NULL;
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
     }
 
-    // Seek the last byte of the file
-    fseek(handler, 0, SEEK_END);
-    // Offset from the first to the last byte, or in other words, filesize
-    uint64_t fileSize = ftell(handler);
-    // Go back to the start of the file
-    rewind(handler);
+    return hash;
+}
+
+uint32_t*
+ConfigTool_UtilHashTableFirst(
+    const ConfigTool_UtilHashTable_t* self,
+    uint64_t hash)
+{
+    return &self->buckets[hash & (self->bucketCount - 1)];
+}
 
-    // Allocate a string that can hold it all
-    char* buf = (char*) malloc(sizeof(char) * (fileSize + 1) );
+uint32_t*
+ConfigTool_UtilHashTableNext(
+    const ConfigTool_UtilHashTable_t* self,
+    const uint32_t* bucket)
+{
+    uint32_t i = (uint32_t)(bucket - self->buckets);
 
-    // Read it all in one operation
-    size_t readSize = fread(buf, sizeof(char), fileSize, handler);
+    return &self->buckets[(i + 1) & (self->bucketCount - 1)];
+}
 
-    // Close the file.
-    fclose(handler);
+void
+ConfigTool_UtilHashTableInsert(
+    ConfigTool_UtilHashTable_t* self,
+    uint64_t hash,
+    uint32_t entryIndex)
+{
+    uint32_t* bucket = ConfigTool_UtilHashTableFirst(self, hash);
+    while (*bucket != 0)
+    {
+        bucket = ConfigTool_UtilHashTableNext(self, bucket);
+    }
+
+    *bucket = entryIndex + 1;
+}
 
-    // Verify if the all content was read
-    if (readSize != fileSize)
+OS_Error_t
+ConfigTool_UtilHashTableReserve(
+    ConfigTool_UtilHashTable_t* self,
+    uint32_t count,
+    bool* isRehashNeeded)
+{
+    *isRehashNeeded = false;
+
+    if ((count + 1) * 2 <= self->bucketCount)
     {
-        /* Something went wrong, throw away the memory and set
-         * the buf to NULL
-         */
-        free(buf);
-        Debug_LOG_ERROR("Could not read the requested length from file! \
-                        Requested: %lu, Read: %zu", fileSize, readSize);
-        return NULL;
+        return OS_SUCCESS;
     }
 
-    /* fread doesn't set it so put a \0 in the last position
-     * and buf is now a string
-     */
-    buf[fileSize] = '\0';
+    uint32_t bucketCount = (self->bucketCount > 0) ?
+                           (self->bucketCount * 2) :
+                           CONFIG_TOOL_UTIL_HASH_TABLE_INITIAL_BUCKETS;
+    uint32_t* buckets = calloc(bucketCount, sizeof(uint32_t));
+    if (buckets == NULL)
+    {
+        Debug_LOG_ERROR("Failed to allocate memory");
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+
+    free(self->buckets);
+    self->buckets = buckets;
+    self->bucketCount = bucketCount;
+    *isRehashNeeded = true;
+
+    return OS_SUCCESS;
+}
+
+void
+ConfigTool_UtilHashTableFree(
+    ConfigTool_UtilHashTable_t* self)
+{
+    free(self->buckets);
+
+    self->buckets = NULL;
+    self->bucketCount = 0;
+}
+
+OS_Error_t
+ConfigTool_UtilCopyFile(
+    int srcFd,
+    int dstFd)
+{
+    if (ioctl(dstFd, FICLONE, srcFd) == 0)
+    {
+        return OS_SUCCESS;
+    }
+
+    ssize_t rc;
+    while ((rc = copy_file_range(srcFd, NULL, dstFd, NULL, SSIZE_MAX, 0)) > 0)
+    {
+    }
+
+    if (rc == 0)
+    {
+        return OS_SUCCESS;
+    }
+
+    // Kernels without copy_file_range() across filesystems need plain copies
+    if ((errno != EXDEV) && (errno != ENOSYS) && (errno != EINVAL))
+    {
+        Debug_LOG_ERROR("copy_file_range() failed with errno %d", errno);
+        return OS_ERROR_GENERIC;
+    }
+
+    uint8_t buffer[UTIL_COPY_BUFFER_SIZE];
+    while ((rc = read(srcFd, buffer, sizeof(buffer))) != 0)
+    {
+        if (rc < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            Debug_LOG_ERROR("read() failed with errno %d", errno);
+            return OS_ERROR_GENERIC;
+        }
+
+        for (ssize_t written = 0; written < rc;)
+        {
+            ssize_t n = write(dstFd, &buffer[written], rc - written);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                Debug_LOG_ERROR("write() failed with errno %d", errno);
+                return OS_ERROR_GENERIC;
+            }
+            written += n;
+        }
+    }
 
-    return buf;
+    return OS_SUCCESS;
 }
@@ -0,0 +1,109 @@
+/*
+ * Runs independent jobs in parallel worker processes
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "lib_debug/Debug.h"
+#include "ConfigTool_Worker.h"
+
+
+/* Private functions ---------------------------------------------------------*/
+// Waits for any worker and returns whether its job succeeded
+static
+bool
+ConfigTool_WorkerWait(void)
+{
+    int status;
+    pid_t pid;
+
+    while ((pid = wait(&status)) < 0)
+    {
+        if (errno != EINTR)
+        {
+            Debug_LOG_ERROR("wait() failed with errno %d", errno);
+            return false;
+        }
+    }
+
+    if (!WIFEXITED(status) || (WEXITSTATUS(status) != 0))
+    {
+        Debug_LOG_ERROR("Worker %d failed", (int)pid);
+        return false;
+    }
+
+    return true;
+}
+
+
+/* Exported functions --------------------------------------------------------*/
+OS_Error_t
+ConfigTool_WorkerRun(
+    size_t jobCount,
+    size_t maxWorkers,
+    ConfigTool_WorkerJob_t job,
+    void* ctx)
+{
+    if (jobCount == 1)
+    {
+        return job(0, ctx);
+    }
+
+    if (maxWorkers == 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        maxWorkers = (cpus > 0) ? (size_t)cpus : 1;
+    }
+
+    // Output buffered before forking would otherwise be written by every worker
+    fflush(NULL);
+
+    size_t running = 0;
+    bool success = true;
+
+    for (size_t i = 0; i < jobCount; i++)
+    {
+        if (running == maxWorkers)
+        {
+            success &= ConfigTool_WorkerWait();
+            running--;
+        }
+
+        pid_t pid = fork();
+        if (pid < 0)
+        {
+            Debug_LOG_ERROR("fork() failed with errno %d", errno);
+            success = false;
+            break;
+        }
+
+        if (pid == 0)
+        {
+            OS_Error_t err = job(i, ctx);
+            fflush(NULL);
+            _exit((err == OS_SUCCESS) ? 0 : 1);
+        }
+
+        running++;
+    }
+
+    while (running > 0)
+    {
+        success &= ConfigTool_WorkerWait();
+        running--;
+    }
+
+    return success ? OS_SUCCESS : OS_ERROR_GENERIC;
+}
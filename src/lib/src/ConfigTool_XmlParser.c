@@ -1,6 +1,6 @@
 /*
- * Parses the XML element nodes and writes the parameters and domains to the
- * configuration library instance
+ * Parses the XML element nodes and adds the parameters and domains to the
+ * configuration model
  *
  * Copyright (C) 2019-2024, HENSOLDT Cyber GmbH
  * 
@@ -15,6 +15,8 @@
 #include <stdbool.h>
 #include <string.h>
 
+#include <libxml/xmlreader.h>
+
 #include "lib_debug/Debug.h"
 #include "ConfigTool_XmlParser.h"
 
@@ -46,12 +48,15 @@ typedef struct
     unsigned int val;
 } ConfigTool_XmlParserElements_t;
 
+// State of a single parser run, collecting the elements of the current parameter
 typedef struct
 {
+    ConfigTool_ConfigModel_t* model; /**< model the parsed elements are added to */
     ConfigTool_ConfigServiceParamType_t type;
     char  paramName[OS_CONFIG_LIB_PARAMETER_NAME_SIZE]; /**< name of params present (from XML) */
-    void* value;    /**< value of params present (from XML) */
-} ConfigTool_XmlParserParams_t;
+    bool hasReadAccess;
+    bool hasWriteAccess;
+} ConfigTool_XmlParserContext_t;
 
 typedef enum
 {
@@ -68,13 +73,7 @@ typedef enum
 
 
 /* Private variables ---------------------------------------------------------*/
-static uint8_t parameterIndex, blobIndex, stringIndex = 0;
-static ConfigTool_XmlParserParams_t xmlparams;
-static bool isNewDomain = false;
-static bool hasReadAccess = false;
-static bool hasWriteAccess = false;
-
-static ConfigTool_ConfigServiceTypes_t lookupTable[] =
+static const ConfigTool_ConfigServiceTypes_t lookupTable[] =
 {
     { "int32",  INT32 },
     { "int64",  INT64 },
@@ -82,7 +81,7 @@ static ConfigTool_ConfigServiceTypes_t lookupTable[] =
     { "blob",   BLOB }
 };
 
-static ConfigTool_XmlParserElements_t xmlElementLookupTable[] =
+static const ConfigTool_XmlParserElements_t xmlElementLookupTable[] =
 {
     {ELEMENT_DOMAIN,        XML_ELEMENT_DOMAIN},
     {ELEMENT_PARAM_NAME,    XML_ELEMENT_PARAM_NAME},
@@ -96,35 +95,13 @@ static ConfigTool_XmlParserElements_t xmlElementLookupTable[] =
 
 
 /* Private functions ---------------------------------------------------------*/
-static
-xmlNode* ConfigTool_GetNextValueElement(xmlNode* a_node)
-{
-    xmlNode* cur_node = NULL;
-
-    for (cur_node = a_node; cur_node; cur_node = cur_node->next)
-    {
-        if (cur_node->type == XML_ELEMENT_NODE)
-        {
-            if (strncmp((const char*)cur_node->name, ELEMENT_VALUE,
-                        sizeof(ELEMENT_VALUE)) == 0)
-            {
-                return cur_node;
-            }
-        }
-
-        ConfigTool_GetNextValueElement(cur_node->children);
-    }
-
-    return NULL;
-}
-
 static
 ConfigTool_ConfigServiceParamType_t
-ConfigTool_XmlParserGetElementType(char* key)
+ConfigTool_XmlParserGetElementType(const char* key)
 {
     for (unsigned int i = 0; i < NKEYS; i++)
     {
-        ConfigTool_ConfigServiceTypes_t* sym = &lookupTable[i];
+        const ConfigTool_ConfigServiceTypes_t* sym = &lookupTable[i];
         if (strcmp(sym->key, key) == 0)
         {
             return sym->parameterType;
@@ -136,7 +113,7 @@ ConfigTool_XmlParserGetElementType(char* key)
 
 static
 OS_Error_t
-ConfigTool_XmlParserSetAccessSetting(char* accessSetting, bool* accessRight)
+ConfigTool_XmlParserSetAccessSetting(const char* accessSetting, bool* accessRight)
 {
     if (strcmp(accessSetting, "true") == 0)
     {
@@ -159,11 +136,11 @@ ConfigTool_XmlParserSetAccessSetting(char* accessSetting, bool* accessRight)
 
 static
 ConfigTool_XmlParserElementValues_t
-ConfigTool_XmlParserGetXmlElement(char* key)
+ConfigTool_XmlParserGetXmlElement(const char* key)
 {
     for (unsigned int i = 0; i < NUMELEMENTS; i++)
     {
-        ConfigTool_XmlParserElements_t* sym = &xmlElementLookupTable[i];
+        const ConfigTool_XmlParserElements_t* sym = &xmlElementLookupTable[i];
         if (strcmp(sym->element, key) == 0)
         {
             return sym->val;
@@ -173,678 +150,362 @@ ConfigTool_XmlParserGetXmlElement(char* key)
     return XML_ELEMENT_BAD;
 }
 
-static void
-ConfigTool_HandleBlobCount(
-    xmlNode* cur_node,
-    ConfigTool_ConfigServiceCounter_t* configCounter,
-    const char* dirPath)
+static
+OS_Error_t
+ConfigTool_XmlParserAddParamValue(
+    ConfigTool_XmlParserContext_t* ctx,
+    const char* value)
 {
-    xmlNode* nextNode = ConfigTool_GetNextValueElement(cur_node);
-    char* node_content = (char*)xmlNodeGetContent(nextNode);
-
-    char* filePath = malloc((strlen(dirPath) + 1) + (strlen(node_content) + 1));
-    strcpy(filePath, dirPath);
-    strcat(filePath, node_content);
-    Debug_LOG_DEBUG("Generated file path %s", filePath);
+    Debug_LOG_DEBUG("Parameter: %s", ctx->paramName);
 
-    char* fileInBuf = ConfigTool_UtilCopyFileToBuf(filePath);
-    if (!fileInBuf)
-    {
-        Debug_LOG_ERROR("Invalid blob passed!");
-        return;
-    }
+    OS_Error_t err = ConfigTool_ConfigModelAddParam(
+                         ctx->model,
+                         ctx->type,
+                         ctx->paramName,
+                         ctx->hasReadAccess,
+                         ctx->hasWriteAccess,
+                         value);
 
-    configCounter->blob_count += ConfigTool_UtilCalculateNumberOfBlocks(fileInBuf);
+    // Reset the access states for the next parameter
+    ctx->hasReadAccess = false;
+    ctx->hasWriteAccess = false;
 
-    free(node_content);
-    free(filePath);
-    free(fileInBuf);
+    return err;
 }
 
+/* Processes a single element of the configuration. The content is only
+ * evaluated for the leaf elements and the domain name only for domain elements,
+ * so callers may pass NULL for the respective other one.
+ */
 static
 OS_Error_t
-ConfigTool_XmlParserWriteVariableLengthBlob(
-    OS_ConfigServiceBackend_t* backend,
-    uint32_t index,
-    uint32_t numberOfBlocks,
-    void const* buffer,
-    size_t bufferLength)
+ConfigTool_XmlParserProcessElement(
+    ConfigTool_XmlParserContext_t* ctx,
+    ConfigTool_XmlParserElementValues_t element,
+    const char* content,
+    const char* domainName)
 {
-    size_t blobBlockSize = OS_ConfigServiceBackend_getSizeOfRecords(backend);
-    size_t blobCapacity = blobBlockSize * numberOfBlocks;
-
-    if (bufferLength > blobCapacity)
-    {
-        Debug_LOG_DEBUG("Passed buffer length exceeds available blob capacity");
-        return OS_ERROR_GENERIC;
-    }
-
-    // We anticipate a maximum size here which should be ok to place on the stack.
-    char tmpBuf[OS_CONFIG_LIB_PARAMETER_MAX_BLOB_BLOCK_SIZE] = {0};
-    size_t bytesCopied = 0;
+    OS_Error_t err;
 
-    while (bytesCopied < bufferLength)
+    switch (element)
     {
-        size_t bytesToCopy;
+    case XML_ELEMENT_ACCESS_POLICY:
+    case XML_ELEMENT_COMPONENT:
+        ; // skip as per component access policy is not supported yet
+        break;
 
-        if ((bufferLength - bytesCopied) >= blobBlockSize)
+    case XML_ELEMENT_READ:
+        err = ConfigTool_XmlParserSetAccessSetting(content, &ctx->hasReadAccess);
+        if (err != OS_SUCCESS)
         {
-            bytesToCopy = blobBlockSize;
+            Debug_LOG_ERROR("ConfigTool_XmlParserSetAccessSetting() failed with %d", err);
+            return err;
         }
-        else
+        break;
+
+    case XML_ELEMENT_WRITE:
+        err = ConfigTool_XmlParserSetAccessSetting(content, &ctx->hasWriteAccess);
+        if (err != OS_SUCCESS)
         {
-            bytesToCopy = bufferLength - bytesCopied;
+            Debug_LOG_ERROR("ConfigTool_XmlParserSetAccessSetting() failed with %d", err);
+            return err;
         }
+        break;
 
-        memcpy(tmpBuf, (char*)buffer + bytesCopied, bytesToCopy);
+    case XML_ELEMENT_DOMAIN:
+        Debug_LOG_DEBUG("Found a domain with name: %s", domainName);
+        err = ConfigTool_ConfigModelAddDomain(ctx->model, domainName);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("ConfigTool_ConfigModelAddDomain() failed with %d", err);
+            return err;
+        }
+        break;
 
-        OS_Error_t fetchResult = OS_ConfigServiceBackend_writeRecord(
-                                     backend,
-                                     index,
-                                     tmpBuf,
-                                     sizeof(tmpBuf));
+    case XML_ELEMENT_PARAM_NAME:
+        strncpy(ctx->paramName,
+                content,
+                sizeof(ctx->paramName) - 1);
+        ctx->paramName[sizeof(ctx->paramName) - 1] = '\0';
+        break;
 
-        if (OS_SUCCESS != fetchResult)
+    case XML_ELEMENT_TYPE:
+        ctx->type = ConfigTool_XmlParserGetElementType(content);
+        if (ctx->type < 0)
         {
-            Debug_LOG_DEBUG("OS_ConfigServiceBackend_writeRecord() failed \
-                            with %d", fetchResult);
+            Debug_LOG_ERROR("Unsupported parameter type!");
             return OS_ERROR_GENERIC;
         }
+        break;
+
+    case XML_ELEMENT_VALUE:
+        err = ConfigTool_XmlParserAddParamValue(ctx, content);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("ConfigTool_XmlParserAddParamValue() failed with %d", err);
+            return err;
+        }
+        break;
 
-        bytesCopied += bytesToCopy;
-        index++;
+    default:
+        Debug_LOG_DEBUG("No known element found. Continuing...");
+        break;
     }
 
     return OS_SUCCESS;
 }
 
+/* Returns the text of a leaf element. In the common case of a single text
+ * child, the text is referenced in place. Only if the text is split across
+ * several nodes, e.g. by comments or CDATA sections, it is concatenated into a
+ * buffer that is returned in allocated and must be freed by the caller.
+ */
 static
-OS_Error_t
-ConfigTool_XmlParserAddIntParameter(
-    OS_ConfigServiceLib_t* configLib,
-    OS_ConfigServiceLibTypes_Parameter_t* parameter,
-    OS_ConfigServiceLibTypes_ParameterType_t parameterType,
-    unsigned int domainIndex,
-    const char* parameterName,
-    const void* parameterValue)
+const char*
+ConfigTool_XmlParserGetLeafContent(xmlNode* node, xmlChar** allocated)
 {
-    parameter->domain.index = domainIndex;
+    xmlNode* child = node->children;
 
-    if (parameterType == OS_CONFIG_LIB_PARAMETER_TYPE_INTEGER32)
-    {
-        parameter->parameterType = parameterType;
-        memcpy(&parameter->parameterValue, parameterValue, sizeof(uint32_t));
-    }
+    *allocated = NULL;
 
-    if (parameterType == OS_CONFIG_LIB_PARAMETER_TYPE_INTEGER64)
+    if (child == NULL)
     {
-        parameter->parameterType = parameterType;
-        memcpy(&parameter->parameterValue, parameterValue, sizeof(uint64_t));
+        return "";
     }
 
-    ConfigTool_UtilInitializeName(
-        parameter->parameterName.name,
-        OS_CONFIG_LIB_PARAMETER_NAME_SIZE,
-        parameterName);
-
-    OS_Error_t err = OS_ConfigServiceBackend_writeRecord(
-                         &configLib->parameterBackend,
-                         parameterIndex,
-                         parameter,
-                         sizeof(OS_ConfigServiceLibTypes_Parameter_t));
-    if (err != OS_SUCCESS)
+    if ((child->next == NULL)
+        && ((child->type == XML_TEXT_NODE)
+            || (child->type == XML_CDATA_SECTION_NODE)))
     {
-        Debug_LOG_ERROR("OS_ConfigServiceBackend_writeRecord() failed with: %d", err);
-        return err;
+        return (const char*)child->content;
     }
 
-    parameterIndex++;
+    *allocated = xmlNodeGetContent(node);
 
-    return OS_SUCCESS;
+    return (*allocated != NULL) ? (const char*)*allocated : "";
 }
 
 static
-OS_Error_t
-ConfigTool_XmlParserAddStringParameter(
-    OS_ConfigServiceLib_t* configLib,
-    OS_ConfigServiceLibTypes_Parameter_t* parameter,
-    unsigned int domainIndex,
-    const char* parameterName,
-    const void* parameterValue,
-    size_t parameterSize)
+const char*
+ConfigTool_XmlParserGetDomainName(xmlNode* node)
 {
+    xmlAttr* attr = xmlHasProp(node, BAD_CAST ATTRIBUTE_NAME);
 
-    char str[OS_CONFIG_LIB_PARAMETER_MAX_STRING_SIZE];
-    memset(str, 0, sizeof(str));
-    strncpy(str, (const char*)xmlparams.value, (sizeof(str) - 1));
-
-    parameter->domain.index = domainIndex;
-    parameter->parameterType = OS_CONFIG_LIB_PARAMETER_TYPE_STRING;
-
-    ConfigTool_UtilInitializeName(
-        parameter->parameterName.name,
-        OS_CONFIG_LIB_PARAMETER_NAME_SIZE,
-        parameterName);
-
-    parameter->parameterValue.valueString.index = stringIndex;
-    parameter->parameterValue.valueString.size = strlen(str) + 1;
-
-    OS_Error_t err = OS_ConfigServiceBackend_writeRecord(
-                         &configLib->parameterBackend,
-                         parameterIndex,
-                         parameter,
-                         sizeof(OS_ConfigServiceLibTypes_Parameter_t));;
-    if (err != OS_SUCCESS)
-    {
-        Debug_LOG_ERROR("OS_ConfigServiceBackend_writeRecord() failed with: %d", err);
-        return err;
-    }
-
-    err = OS_ConfigServiceBackend_writeRecord(
-              &configLib->stringBackend,
-              parameter->parameterValue.valueString.index,
-              str,
-              sizeof(str));
-    if (err != OS_SUCCESS)
+    if ((attr == NULL) || (attr->children == NULL))
     {
-        Debug_LOG_ERROR("OS_ConfigServiceBackend_writeRecord() failed with: %d", err);
-        return err;
+        return NULL;
     }
 
-    parameterIndex++;
-    stringIndex++;
-
-    return OS_SUCCESS;
+    return (const char*)attr->children->content;
 }
 
-/* The configuration library stores large blobs in chunks of blocks and therfore
- * it is first required to verify how many blocks need to be used to store the
- * complete blob
+/* Returns the text of the element the reader is currently positioned on. Only
+ * the text of this single element is materialized, the reader does not keep
+ * any of the already processed nodes around.
  */
 static
-OS_Error_t
-ConfigTool_XmlParserAddBlobParameter(
-    OS_ConfigServiceLib_t* configLib,
-    OS_ConfigServiceLibTypes_Parameter_t* parameter,
-    unsigned int domainIndex,
-    const char* parameterName,
-    const void* parameterValue,
-    size_t parameterSize)
+char*
+ConfigTool_XmlParserStreamGetContent(xmlTextReaderPtr reader)
 {
-    parameter->domain.index = domainIndex;
-    parameter->parameterType = OS_CONFIG_LIB_PARAMETER_TYPE_BLOB;
-
-    ConfigTool_UtilInitializeName(
-        parameter->parameterName.name,
-        OS_CONFIG_LIB_PARAMETER_NAME_SIZE,
-        parameterName);
-
-    uint32_t calcNumberOfBlocks = ConfigTool_UtilCalculateNumberOfBlocks(
-                                      parameterValue);
-
-    Debug_LOG_DEBUG("Calculated number of blocks required: %u\n",
-                    calcNumberOfBlocks);
-
-    parameter->parameterValue.valueBlob.index = blobIndex;
-    parameter->parameterValue.valueBlob.numberOfBlocks = calcNumberOfBlocks;
-    parameter->parameterValue.valueBlob.size = parameterSize;
-
-    OS_Error_t err = OS_ConfigServiceBackend_writeRecord(
-                         &configLib->parameterBackend,
-                         parameterIndex,
-                         parameter,
-                         sizeof(OS_ConfigServiceLibTypes_Parameter_t));
-    if (err != OS_SUCCESS)
-    {
-        Debug_LOG_ERROR("OS_ConfigServiceBackend_writeRecord() failed with: %d", err);
-        return err;
-    }
+    xmlChar* content = xmlTextReaderReadString(reader);
 
-    err = ConfigTool_XmlParserWriteVariableLengthBlob(
-              &configLib->blobBackend,
-              parameter->parameterValue.valueBlob.index,
-              parameter->parameterValue.valueBlob.numberOfBlocks,
-              parameterValue,
-              parameterSize);
-    if (err != OS_SUCCESS)
+    // Empty elements have no text node, treat them like an empty string
+    if (content == NULL)
     {
-        Debug_LOG_ERROR("OS_ConfigServiceBackend_writeRecord() failed with: %d", err);
-        return err;
+        content = xmlStrdup(BAD_CAST "");
     }
 
-    blobIndex += calcNumberOfBlocks;
-    parameterIndex++;
-
-    return OS_SUCCESS;
+    return (char*)content;
 }
 
 static
 OS_Error_t
-ConfigTool_HandleBlobParameter(
-    OS_ConfigServiceLib_t* configLib,
-    OS_ConfigServiceLibTypes_Parameter_t* parameter,
-    ConfigTool_ConfigServiceCounter_t* configCounter,
-    const char* dirPath)
+ConfigTool_XmlParserStreamElement(
+    ConfigTool_XmlParserContext_t* ctx,
+    xmlTextReaderPtr reader)
 {
-    char* filePath = malloc((strlen(dirPath) + 1) + (strlen(xmlparams.value) + 1));
-    strcpy(filePath, dirPath);
-    strcat(filePath, xmlparams.value);
-    Debug_LOG_DEBUG("Generated file path %s", filePath);
-
-    void* blobptr = ConfigTool_UtilCopyFileToBuf(filePath);
-    if (!blobptr)
-    {
-        Debug_LOG_ERROR("ConfigTool_UtilCopyFileToBuf() failed");
-        return OS_ERROR_GENERIC;
-    }
-    // strlen() does not include NULL terminator
-    size_t blob_size = strlen(blobptr) + 1;
-
-    Debug_LOG_DEBUG("Adding parameter %s to domain %u",
-                    xmlparams.paramName, configCounter->domain_count);
-    OS_Error_t err = ConfigTool_XmlParserAddBlobParameter(
-                         configLib,
-                         parameter,
-                         configCounter->domain_count,
-                         xmlparams.paramName,
-                         blobptr,
-                         blob_size);
-    if (err != OS_SUCCESS)
-    {
-        Debug_LOG_ERROR("ConfigTool_XmlParserAddBlobParameter() failed with: %d", err);
-        return err;
-    }
+    const char* name = (const char*)xmlTextReaderConstName(reader);
+    Debug_LOG_DEBUG("Element name: %s", name);
 
-    free(filePath);
-    free(blobptr);
+    ConfigTool_XmlParserElementValues_t element =
+        ConfigTool_XmlParserGetXmlElement(name);
 
-    return OS_SUCCESS;
-}
+    char* content = NULL;
+    char* domainName = NULL;
 
-static
-OS_Error_t
-ConfigTool_HandleInt32Parameter(
-    OS_ConfigServiceLib_t* configLib,
-    OS_ConfigServiceLibTypes_Parameter_t* parameter,
-    ConfigTool_ConfigServiceCounter_t* configCounter)
-{
-    /* Convert string to integer. Parameters can be entered either in
-     * decimal or hex format in the XML file, so base is set to 0
-     */
-    char* endPtr;
-    uint32_t parameterValue = strtoul(xmlparams.value, &endPtr, 0);
-    if (endPtr == NULL)
+    switch (element)
     {
-        Debug_LOG_ERROR("strtoul() failed to convert to uint32_t value");
-        return OS_ERROR_GENERIC;
-    }
-
-    Debug_LOG_DEBUG("Adding parameter %s to domain %u",
-                    xmlparams.paramName, configCounter->domain_count);
-    OS_Error_t err = ConfigTool_XmlParserAddIntParameter(
-                         configLib,
-                         parameter,
-                         OS_CONFIG_LIB_PARAMETER_TYPE_INTEGER32,
-                         configCounter->domain_count,
-                         xmlparams.paramName,
-                         &parameterValue);
-    if (err != OS_SUCCESS)
-    {
-        Debug_LOG_ERROR("ConfigTool_XmlParserAddIntParameter() failed with: %d", err);
-        return err;
-    }
-
-    return OS_SUCCESS;
-}
+    case XML_ELEMENT_DOMAIN:
+        domainName = (char*)xmlTextReaderGetAttribute(
+                         reader,
+                         BAD_CAST ATTRIBUTE_NAME);
+        if (domainName == NULL)
+        {
+            Debug_LOG_ERROR("Domain element without a name attribute");
+            return OS_ERROR_GENERIC;
+        }
+        break;
 
-static
-OS_Error_t
-ConfigTool_HandleInt64Parameter(
-    OS_ConfigServiceLib_t* configLib,
-    OS_ConfigServiceLibTypes_Parameter_t* parameter,
-    ConfigTool_ConfigServiceCounter_t* configCounter)
-{
-    /* Convert string to long long integer. Parameters can be entered either in
-     * decimal or hex format in the XML file, so base is set to 0
-     */
-    char* endPtr;
-    uint64_t parameterValue = strtoull((char*)xmlparams.value, &endPtr, 0);
-    if (endPtr == NULL)
-    {
-        Debug_LOG_ERROR("strtoull() failed to convert to uint64_t value");
-        return OS_ERROR_GENERIC;
-    }
+    case XML_ELEMENT_PARAM_NAME:
+    case XML_ELEMENT_TYPE:
+    case XML_ELEMENT_VALUE:
+    case XML_ELEMENT_READ:
+    case XML_ELEMENT_WRITE:
+        content = ConfigTool_XmlParserStreamGetContent(reader);
+        break;
 
-    Debug_LOG_DEBUG("Adding parameter %s to domain %u",
-                    xmlparams.paramName, configCounter->domain_count);
-    OS_Error_t err = ConfigTool_XmlParserAddIntParameter(
-                         configLib,
-                         parameter,
-                         OS_CONFIG_LIB_PARAMETER_TYPE_INTEGER64,
-                         configCounter->domain_count,
-                         xmlparams.paramName,
-                         &parameterValue);
-    if (err != OS_SUCCESS)
-    {
-        Debug_LOG_ERROR("ConfigTool_XmlParserAddIntParameter() failed with: %d", err);
-        return err;
+    default:
+        break;
     }
 
-    return OS_SUCCESS;
-}
+    OS_Error_t err = ConfigTool_XmlParserProcessElement(
+                         ctx,
+                         element,
+                         content,
+                         domainName);
 
-static
-OS_Error_t
-ConfigTool_HandleStringParameter(
-    OS_ConfigServiceLib_t* configLib,
-    OS_ConfigServiceLibTypes_Parameter_t* parameter,
-    ConfigTool_ConfigServiceCounter_t* configCounter)
-{
-    size_t parameterLength = strlen((const char*)xmlparams.value);
-
-    Debug_LOG_DEBUG("Adding parameter %s to domain %u",
-                    xmlparams.paramName, configCounter->domain_count);
-    OS_Error_t err = ConfigTool_XmlParserAddStringParameter(
-                         configLib,
-                         parameter,
-                         configCounter->domain_count,
-                         xmlparams.paramName,
-                         xmlparams.value,
-                         parameterLength);
-    if (err != OS_SUCCESS)
-    {
-        Debug_LOG_ERROR("ConfigTool_XmlParserAddStringParameter() failed with: %d",
-                        err);
-        return err;
-    }
+    xmlFree(content);
+    xmlFree(domainName);
 
-    return OS_SUCCESS;
+    return err;
 }
 
-static
-OS_Error_t
-ConfigTool_XmlParserWriteDomainValue(
-    OS_ConfigServiceLib_t* configLib,
-    ConfigTool_ConfigServiceCounter_t* configCounter,
-    const char* domainName)
-{
-    Debug_LOG_DEBUG("Domain: %s", domainName);
-
-    // Increment the domain count after the parameters are written to it
-    if (isNewDomain)
-    {
-        configCounter->domain_count++;
-        isNewDomain = false;
-    }
-
-    OS_ConfigServiceLibTypes_Domain_t domain;
-    ConfigTool_UtilInitializeDomain(&domain, domainName);
-    OS_Error_t err = OS_ConfigServiceBackend_writeRecord(
-                         &configLib->domainBackend,
-                         configCounter->domain_count,
-                         &domain,
-                         sizeof(domain));
-    if (err != OS_SUCCESS)
-    {
-        Debug_LOG_ERROR("OS_ConfigServiceBackend_writeRecord() failed with: %d", err);
-        return err;
-    }
-
-    // Set flag so domain will be incremented after writing the parameters
-    isNewDomain = true;
-
-    return OS_SUCCESS;
-}
 
+/* Parse the XML parameters. XML params are in the form of a tree structure due to
+ * DOM and hence can be parsed recursively.
+ */
 static
 OS_Error_t
-ConfigTool_XmlParserWriteParamValue(
-    OS_ConfigServiceLib_t* configLib,
-    ConfigTool_ConfigServiceCounter_t* configCounter,
-    const char* filePath)
+ConfigTool_XmlParserBuildModelNodes(
+    ConfigTool_XmlParserContext_t* ctx,
+    xmlNode* a_node)
 {
     OS_Error_t err;
-    OS_ConfigServiceLibTypes_Parameter_t parameter = {0};
 
-    // Use _SetAll as access rights per component are currently not supported
-    if (hasReadAccess)
+    for (xmlNode* cur_node = a_node; cur_node; cur_node = cur_node->next)
     {
-        OS_ConfigServiceAccessRights_SetAll(&parameter.readAccess);
-        // Reset the read access state
-        hasReadAccess = false;
-    }
+        if (cur_node->type != XML_ELEMENT_NODE)
+        {
+            continue;
+        }
 
-    if (hasWriteAccess)
-    {
-        OS_ConfigServiceAccessRights_SetAll(&parameter.writeAccess);
-        // Reset the write access state
-        hasWriteAccess = false;
-    }
+        Debug_LOG_DEBUG("Element name: %s", cur_node->name);
 
-    Debug_LOG_DEBUG("Parameter: %s", xmlparams.paramName);
+        ConfigTool_XmlParserElementValues_t element =
+            ConfigTool_XmlParserGetXmlElement((const char*)cur_node->name);
 
-    switch (xmlparams.type)
-    {
-    case INT32:
-        Debug_LOG_DEBUG("Param Type:%s", "Int32");
-        err = ConfigTool_HandleInt32Parameter(configLib, &parameter, configCounter);
-        if (err != OS_SUCCESS)
+        const char* content = NULL;
+        const char* domainName = NULL;
+        xmlChar* allocated = NULL;
+
+        /* Only the leaf elements carry text we are interested in, which is
+         * referenced directly from their text node. Fetching the content of
+         * the inner elements would concatenate the text of their whole subtree.
+         */
+        switch (element)
         {
-            Debug_LOG_ERROR("ConfigTool_HandleInt32Parameter() failed with: %d", err);
-            return err;
+        case XML_ELEMENT_DOMAIN:
+            domainName = ConfigTool_XmlParserGetDomainName(cur_node);
+            if (domainName == NULL)
+            {
+                Debug_LOG_ERROR("Domain element without a name attribute");
+                return OS_ERROR_GENERIC;
+            }
+            break;
+
+        case XML_ELEMENT_PARAM_NAME:
+        case XML_ELEMENT_TYPE:
+        case XML_ELEMENT_VALUE:
+        case XML_ELEMENT_READ:
+        case XML_ELEMENT_WRITE:
+            content = ConfigTool_XmlParserGetLeafContent(cur_node, &allocated);
+            Debug_LOG_DEBUG("Element content:%s", content);
+            break;
+
+        default:
+            break;
         }
-        break;
 
-    case INT64:
-        Debug_LOG_DEBUG("Param Type:%s", "Int64");
-        err = ConfigTool_HandleInt64Parameter(configLib, &parameter, configCounter);
+        err = ConfigTool_XmlParserProcessElement(
+                  ctx,
+                  element,
+                  content,
+                  domainName);
+        xmlFree(allocated);
         if (err != OS_SUCCESS)
         {
-            Debug_LOG_ERROR("ConfigTool_HandleInt64Parameter() failed with: %d", err);
+            Debug_LOG_ERROR("ConfigTool_XmlParserProcessElement() failed with %d", err);
             return err;
         }
-        break;
 
-    case STRING:
-        Debug_LOG_DEBUG("Param Type:%s", "string");
-        Debug_LOG_DEBUG("Param Value:%s", (char*)xmlparams.value);
-        err = ConfigTool_HandleStringParameter(configLib, &parameter, configCounter);
-        if (err != OS_SUCCESS)
+        // The text of a leaf element has been consumed completely
+        if (content != NULL)
         {
-            Debug_LOG_ERROR("ConfigTool_HandleStringParameter() failed with: %d", err);
-            return err;
+            continue;
         }
-        break;
 
-    case BLOB:
-        Debug_LOG_DEBUG("Param Type:%s", "Blob");
-        Debug_LOG_DEBUG("Param Value:%s", (char*)xmlparams.value);
-        err = ConfigTool_HandleBlobParameter(
-                  configLib,
-                  &parameter,
-                  configCounter,
-                  filePath);
+        // recursive function to parse the params
+        err = ConfigTool_XmlParserBuildModelNodes(ctx, cur_node->children);
         if (err != OS_SUCCESS)
         {
-            Debug_LOG_ERROR("ConfigTool_HandleBlobParameter() failed with: %d", err);
             return err;
         }
-        break;
-
-    default:
-        Debug_LOG_ERROR("Unsupported parameter type!");
-        err = OS_ERROR_GENERIC;
-        break;
     }
 
-    return err;
-} // end of ConfigTool_XmlParserWriteParamValue()
-
+    return OS_SUCCESS;
+}
 
 /* Exported functions --------------------------------------------------------*/
-/* Parse through the XML elements found in the nodes and count them according to
- * their supported type. This aggregation is later used to create the
- * configuration backend
- */
-void ConfigTool_XmlParserGetElementCount(
+OS_Error_t ConfigTool_XmlParserBuildModel(
     xmlNode* a_node,
-    ConfigTool_ConfigServiceCounter_t* configCounter,
-    const char* dirPath)
+    ConfigTool_ConfigModel_t* model)
 {
-    for (xmlNode* cur_node = a_node; cur_node; cur_node = cur_node->next)
-    {
-        if (cur_node->type == XML_ELEMENT_NODE)
-        {
-            Debug_LOG_DEBUG("Received Element name: %s", cur_node->name);
-            char* cur_node_name = (char*)cur_node->name;
-
-            if (strncmp(cur_node_name, ELEMENT_DOMAIN, sizeof(ELEMENT_DOMAIN)) == 0)
-            {
-                Debug_LOG_DEBUG("Found a domain");
-                configCounter->domain_count++;
-            }
+    ConfigTool_XmlParserContext_t ctx = { .model = model };
 
-            if (strncmp(cur_node_name, ELEMENT_TYPE, sizeof(ELEMENT_TYPE)) == 0)
-            {
-                char* node_content = (char*)xmlNodeGetContent(cur_node);
-                switch (ConfigTool_XmlParserGetElementType(node_content))
-                {
-                case STRING:
-                    Debug_LOG_DEBUG("Found a String parameter");
-                    configCounter->param_count++;
-                    configCounter->string_count++;
-                    break;
-
-                case BLOB:
-                    Debug_LOG_DEBUG("Found a Blob parameter");
-                    configCounter->param_count++;
-                    ConfigTool_HandleBlobCount(cur_node, configCounter, dirPath);
-                    break;
-
-                case INT32:
-                case INT64:
-                    Debug_LOG_DEBUG("Found an Int parameter");
-                    configCounter->param_count++;
-                    break;
-
-                case BADTYPE:
-                    Debug_LOG_ERROR("No valid type found in XML, exiting...");
-                    exit(1);
-
-                default:
-                    Debug_LOG_ERROR("Unsupported parameter type!");
-                    break;
-                }
-                free(node_content);
-            }
-        }
-        ConfigTool_XmlParserGetElementCount(cur_node->children, configCounter, dirPath);
-    }
+    return ConfigTool_XmlParserBuildModelNodes(&ctx, a_node);
 }
 
-/* Parse the XML parameters. XML params are in the form of a tree structure due to
- * DOM and hence can be parsed recursively.
+/* Stream through the XML file and add the domains and parameters to the model
+ * as the elements arrive. No DOM is built, so the memory consumption of the
+ * parser is bound by the largest single element.
  */
-void ConfigTool_XmlParserRun(
-    OS_ConfigServiceLib_t* configLib,
-    xmlNode* a_node,
-    ConfigTool_ConfigServiceCounter_t* configCounter,
-    const char* dirPath)
+OS_Error_t ConfigTool_XmlParserBuildModelStream(
+    const char* fileName,
+    ConfigTool_ConfigModel_t* model)
 {
-    OS_Error_t err;
+    xmlTextReaderPtr reader = xmlReaderForFile(fileName, NULL, 0);
+    if (reader == NULL)
+    {
+        Debug_LOG_ERROR("Could not open input XML file %s", fileName);
+        return OS_ERROR_GENERIC;
+    }
 
-    for (xmlNode* cur_node = a_node; cur_node; cur_node = cur_node->next)
+    ConfigTool_XmlParserContext_t ctx = { .model = model };
+    OS_Error_t err = OS_SUCCESS;
+    int ret;
+
+    while ((ret = xmlTextReaderRead(reader)) == 1)
     {
-        if (cur_node->type == XML_ELEMENT_NODE)
+        if (xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT)
         {
-            Debug_LOG_DEBUG("Element name: %s", cur_node->name);
-            char* cur_node_name = (char*)cur_node->name;
-
-            Debug_LOG_DEBUG("Element content:%s", xmlNodeGetContent(cur_node));
-            char* node_content = (char*)xmlNodeGetContent(cur_node);
+            continue;
+        }
 
-            switch (ConfigTool_XmlParserGetXmlElement(cur_node_name))
-            {
-            case XML_ELEMENT_ACCESS_POLICY:
-            case XML_ELEMENT_COMPONENT:
-                ; // skip as per component access policy is not supported yet
-                break;
-
-            case XML_ELEMENT_READ:
-                err = ConfigTool_XmlParserSetAccessSetting(node_content, &hasReadAccess);
-                if (err != OS_SUCCESS)
-                {
-                    Debug_LOG_ERROR("ConfigTool_XmlParserSetAccessSetting() failed with %d", err);
-                    free(node_content);
-                    exit(1);
-                }
-                break;
-
-            case XML_ELEMENT_WRITE:
-                err = ConfigTool_XmlParserSetAccessSetting(node_content, &hasWriteAccess);
-                if (err != OS_SUCCESS)
-                {
-                    Debug_LOG_ERROR("ConfigTool_XmlParserSetAccessSetting() failed with %d", err);
-                    free(node_content);
-                    exit(1);
-                }
-                break;
-
-            case XML_ELEMENT_DOMAIN:
-                Debug_LOG_DEBUG("Found a domain with name: %s", (char*)xmlNodeGetContent(
-                                    cur_node->properties->children));
-                char* domainName = (char*)xmlNodeGetContent(
-                                       cur_node->properties->children);
-                err = ConfigTool_XmlParserWriteDomainValue(
-                          configLib,
-                          configCounter,
-                          domainName);
-                if (err != OS_SUCCESS)
-                {
-                    Debug_LOG_ERROR("ConfigTool_XmlParserWriteDomainValue() failed with %d", err);
-                    free(domainName);
-                    free(node_content);
-                    exit(1);
-                }
-                free(domainName);
-                break;
-
-            case XML_ELEMENT_PARAM_NAME:
-                strncpy(xmlparams.paramName,
-                        node_content,
-                        sizeof(xmlparams.paramName) - 1);
-                xmlparams.paramName[sizeof(xmlparams.paramName) - 1] = '\0';
-                break;
-
-            case XML_ELEMENT_TYPE:
-                xmlparams.type = ConfigTool_XmlParserGetElementType(node_content);
-                if (xmlparams.type < 0)
-                {
-                    Debug_LOG_ERROR("Unsupported parameter type!");
-                    free(node_content);
-                    exit(1);
-                }
-                break;
-
-            case XML_ELEMENT_VALUE:
-                xmlparams.value = (void*)node_content;
-                err = ConfigTool_XmlParserWriteParamValue(configLib, configCounter, dirPath);
-                if (err != OS_SUCCESS)
-                {
-                    Debug_LOG_ERROR("ConfigTool_XmlParserWriteParamValue() failed with %d", err);
-                    free(node_content);
-                    exit(1);
-                }
-                break;
-
-            default:
-                Debug_LOG_DEBUG("No known element found. Continuing...");
-                break;
-            }
-            free(node_content);
+        err = ConfigTool_XmlParserStreamElement(&ctx, reader);
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("ConfigTool_XmlParserStreamElement() failed with %d", err);
+            break;
         }
-        // recursive function to parse and write params
+    }
 
-        ConfigTool_XmlParserRun(configLib, cur_node->children, configCounter, dirPath);
+    xmlFreeTextReader(reader);
+
+    if (ret < 0)
+    {
+        Debug_LOG_ERROR("Could not parse input XML file %s", fileName);
+        return OS_ERROR_GENERIC;
     }
+
+    return err;
 }
@@ -0,0 +1,113 @@
+/**
+ * Image size test of the Configuration Provisioning Tool
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include "lib_debug/Debug.h"
+#include "ConfigTool_Provisioning.h"
+
+
+/* Defines -------------------------------------------------------------------*/
+#define USAGE_STRING                                   \
+    printf("Usage: cpt_image_size_test "               \
+           "<path-to-xml_file> <filesystem_type> "     \
+           "<output_image>\n")
+
+
+/* Private variables ---------------------------------------------------------*/
+static const struct
+{
+    const char* name;
+    OS_FileSystem_Type_t type;
+} fsTypes[] =
+{
+    { "FAT",      OS_FileSystem_Type_FATFS },
+    { "SPIFFS",   OS_FileSystem_Type_SPIFFS },
+    { "LITTLEFS", OS_FileSystem_Type_LITTLEFS },
+};
+
+
+/* Main ----------------------------------------------------------------------*/
+/* Formats an image of exactly the smallest size computed for the
+ * configuration and writes the configuration into it. The image is checked
+ * against the configuration with cpt --verify afterwards.
+ */
+int main(int argc, char* argv[])
+{
+    if (argc != 4)
+    {
+        USAGE_STRING;
+        return -1;
+    }
+
+    size_t i;
+    for (i = 0; i < (sizeof(fsTypes) / sizeof(fsTypes[0])); i++)
+    {
+        if (strcmp(argv[2], fsTypes[i].name) == 0)
+        {
+            break;
+        }
+    }
+
+    if (i == (sizeof(fsTypes) / sizeof(fsTypes[0])))
+    {
+        printf("Unsupported FileSystem type %s\n", argv[2]);
+        USAGE_STRING;
+        return -1;
+    }
+
+    ConfigTool_Provisioning_t provisioning;
+    OS_Error_t err = ConfigTool_ProvisioningLoad(&provisioning, argv[1],
+                                                 false, false);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_ProvisioningLoad() failed with %d", err);
+        return -1;
+    }
+
+    uint64_t minImageSize = ConfigTool_BackendGetMinImageSize(
+                                fsTypes[i].type,
+                                &provisioning.model.counter,
+                                false);
+    if (minImageSize > HOSTSTORAGE_SIZE)
+    {
+        printf("Image of %" PRIu64 " bytes exceeds the maximum of %zu bytes\n",
+               minImageSize, (size_t)HOSTSTORAGE_SIZE);
+        ConfigTool_ProvisioningFree(&provisioning);
+        return -1;
+    }
+
+    ConfigTool_BackendConfig_t cfgBackend =
+    {
+        .fsType = fsTypes[i].type,
+        .hostFsMode = CONFIG_TOOL_HOST_FS_MODE_WRITE,
+        .imageSize = (size_t)minImageSize,
+        .templateCacheDir = NULL,
+        .writeIndex = false,
+        .hostDir = NULL,
+    };
+
+    printf("Formatting a %s image of %" PRIu64 " bytes\n", fsTypes[i].name,
+           minImageSize);
+
+    err = ConfigTool_ProvisioningPublish(&provisioning, &cfgBackend, argv[3]);
+    ConfigTool_ProvisioningFree(&provisioning);
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("ConfigTool_ProvisioningPublish() failed with %d", err);
+        return -1;
+    }
+
+    return 0;
+}
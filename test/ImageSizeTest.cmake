@@ -0,0 +1,55 @@
+#
+# Config Provisioning Tool image size test
+#
+# Copyright (C) 2024, HENSOLDT Cyber GmbH
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# For commercial licensing, contact: info.cyber@hensoldt.net
+#
+# Generates every benchmark scenario, writes it into an image of the
+# filesystem FS_TYPE formatted with exactly the computed minimum size, and
+# checks every record of the image against the configuration with --verify.
+#
+# Usage: cmake -DCPT=<cpt> -DCPT_BENCH=<cpt_bench>
+#              -DIMAGE_SIZE_TEST=<cpt_image_size_test> -DFS_TYPE=<type>
+#              -DWORK_DIR=<dir> -P ImageSizeTest.cmake
+#
+
+foreach(var CPT CPT_BENCH IMAGE_SIZE_TEST FS_TYPE WORK_DIR)
+    if(NOT DEFINED ${var})
+        message(FATAL_ERROR "${var} is not set")
+    endif()
+endforeach()
+
+# Runs the command in the work directory and fails the test if it fails
+function(run_step name)
+    execute_process(
+        COMMAND ${ARGN}
+        WORKING_DIRECTORY ${WORK_DIR}
+        RESULT_VARIABLE result
+    )
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "${name} failed: ${result}")
+    endif()
+endfunction()
+
+
+#-------------------------------------------------------------------------------
+file(REMOVE_RECURSE ${WORK_DIR})
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+foreach(scenario small strings large blobs)
+    set(configDir ${WORK_DIR}/${scenario})
+    set(xmlFile ${configDir}/config.xml)
+    set(output ${WORK_DIR}/${scenario}.img)
+
+    run_step("Generating ${scenario}"
+        ${CPT_BENCH} --generate ${configDir} --scenario ${scenario})
+    run_step("Provisioning ${scenario}"
+        ${IMAGE_SIZE_TEST} ${xmlFile} ${FS_TYPE} ${output})
+    run_step("Reading back ${scenario}"
+        ${CPT} --verify ${output} -t ${FS_TYPE} -i ${xmlFile})
+endforeach()
+
+file(REMOVE_RECURSE ${WORK_DIR})
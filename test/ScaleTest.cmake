@@ -0,0 +1,61 @@
+#
+# Config Provisioning Tool scaling test
+#
+# Copyright (C) 2024, HENSOLDT Cyber GmbH
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# For commercial licensing, contact: info.cyber@hensoldt.net
+#
+# Generates the "large" benchmark configuration of 100000 parameters, builds
+# it with the backend FS_TYPE, HOST for the plain backend files, and checks
+# every record of the output against the configuration with --verify.
+#
+# Usage: cmake -DCPT=<cpt> -DCPT_BENCH=<cpt_bench> -DFS_TYPE=<type>
+#              -DWORK_DIR=<dir> -P ScaleTest.cmake
+#
+
+foreach(var CPT CPT_BENCH FS_TYPE WORK_DIR)
+    if(NOT DEFINED ${var})
+        message(FATAL_ERROR "${var} is not set")
+    endif()
+endforeach()
+
+# Runs the command in the work directory and fails the test if it fails
+function(run_step name)
+    execute_process(
+        COMMAND ${ARGN}
+        WORKING_DIRECTORY ${WORK_DIR}
+        RESULT_VARIABLE result
+    )
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "${name} failed: ${result}")
+    endif()
+endfunction()
+
+
+#-------------------------------------------------------------------------------
+file(REMOVE_RECURSE ${WORK_DIR})
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+set(configDir ${WORK_DIR}/config)
+set(xmlFile ${configDir}/config.xml)
+
+run_step("Generating the configuration"
+    ${CPT_BENCH} --generate ${configDir} --scenario large)
+
+if(FS_TYPE STREQUAL "HOST")
+    set(output ${WORK_DIR}/out)
+    set(buildArgs --outdir ${output})
+    set(typeArgs "")
+    file(MAKE_DIRECTORY ${output})
+else()
+    set(output ${WORK_DIR}/out.img)
+    set(buildArgs -o ${output} -t ${FS_TYPE} --size auto)
+    set(typeArgs -t ${FS_TYPE})
+endif()
+
+run_step("Provisioning" ${CPT} -i ${xmlFile} ${buildArgs})
+run_step("Reading back" ${CPT} --verify ${output} ${typeArgs} -i ${xmlFile})
+
+file(REMOVE_RECURSE ${WORK_DIR})